@@ -29,6 +29,7 @@
 
 #include "string.hpp"
 #include "resfile.hpp"
+#include "anmstore.hpp"
 
 namespace cursedearth
 {
@@ -38,11 +39,10 @@ namespace cursedearth
         int translation_frame_count;
         int morph_frame_count;
         int morph_vertex_count;
-        float* rotations;
-        float* translations;
-        float* morphs;
-        size_t size;
-        void* data;
+        const float* rotations;
+        const float* translations;
+        const float* morphs;
+        ce_anm_block* block; // keys point into it, shared with other figures
     } ce_anmfile;
 
     ce_anmfile* ce_anmfile_open(ce_res_file* res_file, size_t index);
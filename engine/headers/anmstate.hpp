@@ -21,13 +21,28 @@
 #ifndef CE_ANMSTATE_HPP
 #define CE_ANMSTATE_HPP
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "vector.hpp"
 #include "anmfile.hpp"
 
 namespace cursedearth
 {
+    /**
+     * @brief case-insensitive hashed index over animations of a figure node
+     */
+    typedef struct {
+        std::vector<std::pair<uint64_t, ce_anmfile*>> entries; // sorted by name hash
+    } ce_anm_index;
+
+    ce_anm_index* ce_anm_index_new(const ce_vector* anmfiles);
+    void ce_anm_index_del(ce_anm_index* anm_index);
+
+    ce_anmfile* ce_anm_index_find(const ce_anm_index* anm_index, const std::string& name);
+
     typedef struct {
         ce_anmfile* anmfile;
         float frame_count;
@@ -42,7 +57,7 @@ namespace cursedearth
 
     void ce_anmstate_advance(ce_anmstate* anmstate, float distance);
 
-    bool ce_anmstate_play_animation(ce_anmstate* anmstate, ce_vector* anmfiles, const std::string& name);
+    bool ce_anmstate_play_animation(ce_anmstate* anmstate, const ce_anm_index* anm_index, const std::string& name);
     void ce_anmstate_stop_animation(ce_anmstate* anmstate);
 }
 
@@ -0,0 +1,50 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_ANMSTORE_HPP
+#define CE_ANMSTORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "resfile.hpp"
+
+namespace cursedearth
+{
+    /**
+     * @brief shared read-only animation data: anm keyframes and bon positions
+     *        nodes with equal contents are stored once while in use, so figures that
+     *        carry the same animation share one block; a block is freed with its last user
+     */
+    typedef struct {
+        uint64_t hash;
+        size_t size;
+        size_t ref_count;
+        void* data; // allocated by ce_alloc, aligned for float access
+    } ce_anm_block;
+
+    // read node data and return a shared block holding it; thread-safe
+    ce_anm_block* ce_anm_store_acquire(ce_res_file* res_file, size_t index);
+
+    // thread-safe
+    void ce_anm_store_release(ce_anm_block* block);
+}
+
+#endif
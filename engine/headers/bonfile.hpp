@@ -28,12 +28,13 @@
 #include <cstddef>
 
 #include "resfile.hpp"
+#include "anmstore.hpp"
 
 namespace cursedearth
 {
     typedef struct {
-        size_t size;
-        float* bone;
+        const float* bone;
+        ce_anm_block* block;
     } ce_bonfile;
 
     ce_bonfile* ce_bonfile_open(ce_res_file* res_file, const char* name);
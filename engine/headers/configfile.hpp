@@ -21,52 +21,45 @@
 #ifndef CE_CONFIGFILE_HPP
 #define CE_CONFIGFILE_HPP
 
+#include <cstdint>
+#include <vector>
+
 #include <boost/filesystem/path.hpp>
 
-#include "vector.hpp"
-#include "string.hpp"
+#include "keytable.hpp"
 
 namespace cursedearth
 {
-    typedef struct {
-        ce_string* name;
-        ce_string* value;
-    } ce_config_option;
-
-    typedef struct {
-        ce_string* name;
-        ce_vector* options;
-    } ce_config_section;
-
-    typedef struct {
-        ce_vector* sections;
-    } ce_config_file;
+    struct ce_config_file
+    {
+        ce_key_table key_table;
+        std::vector<char> values; // NUL-terminated option values back to back
+        std::vector<uint32_t> value_offsets; // per option
+    };
 
     ce_config_file* ce_config_file_open(const boost::filesystem::path&);
     void ce_config_file_close(ce_config_file* config_file);
 
-    inline size_t ce_config_file_section_count(ce_config_file* config_file)
+    inline size_t ce_config_file_section_count(const ce_config_file* config_file)
     {
-        return config_file->sections->count;
+        return ce_key_table_section_count(&config_file->key_table);
     }
 
-    inline size_t ce_config_file_option_count(ce_config_file* config_file, size_t section_index)
+    inline size_t ce_config_file_option_count(const ce_config_file* config_file, size_t section_index)
     {
-        ce_config_section* section = (ce_config_section*)config_file->sections->items[section_index];
-        return section->options->count;
+        return config_file->key_table.sections[section_index].option_count;
     }
 
-    size_t ce_config_file_section_index(ce_config_file* config_file, const char* section_name);
-    size_t ce_config_file_option_index(ce_config_file* config_file, size_t section_index, const char* option_name);
+    size_t ce_config_file_section_index(const ce_config_file* config_file, const char* section_name);
+    size_t ce_config_file_option_index(const ce_config_file* config_file, size_t section_index, const char* option_name);
 
-    inline const char* ce_config_file_get(ce_config_file* config_file, size_t section_index, size_t option_index)
+    inline const char* ce_config_file_get(const ce_config_file* config_file, size_t section_index, size_t option_index)
     {
-        ce_config_section* section = (ce_config_section*)config_file->sections->items[section_index];
-        ce_config_option* option = (ce_config_option*)section->options->items[option_index];
-        return option->value->str;
+        size_t index = config_file->key_table.sections[section_index].first_option + option_index;
+        return config_file->values.data() + config_file->value_offsets[index];
     }
 
-    const char* ce_config_file_find(ce_config_file* config_file, const char* section_name, const char* option_name);
+    const char* ce_config_file_find(const ce_config_file* config_file, const char* section_name, const char* option_name);
 }
 
 #endif
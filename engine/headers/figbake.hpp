@@ -0,0 +1,77 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_FIGBAKE_HPP
+#define CE_FIGBAKE_HPP
+
+#include <cstdint>
+
+#include "complection.hpp"
+#include "figfile.hpp"
+
+namespace cursedearth
+{
+    /**
+     * @brief figure geometry evaluated for one complection
+     *
+     * Vertices, normals and texture coordinates are expanded per index
+     * (three per triangle), ready to be uploaded or compiled as is.
+     * Baked once per mesh, shared by all entities with that complection.
+     */
+    typedef struct {
+        int vertex_count;
+        float* vertices;
+        float* normals;
+        float* texcoords;
+    } ce_figbake;
+
+    ce_figbake* ce_figbake_new(const ce_figfile* figfile, const complection_t* complection);
+    void ce_figbake_del(ce_figbake* figbake);
+
+    /**
+     * @brief welded geometry: unique vertices and 16-bit triangle indices
+     *
+     * Identical (position, normal, texcoord) tuples of a bake are merged,
+     * triangles are reordered for the post-transform vertex cache and
+     * vertices are stored in order of first use.
+     */
+    typedef struct {
+        int vertex_count;
+        int index_count;
+        float* vertices; // interleaved: position (3), normal (3), texcoord (2)
+        uint16_t* indices;
+    } ce_figweld;
+
+    enum {
+        CE_FIGWELD_VERTEX_SIZE = 3 + 3 + 2,
+    };
+
+    // returns NULL if unique vertices do not fit into 16-bit indices
+    ce_figweld* ce_figweld_new(const ce_figbake* figbake);
+    void ce_figweld_del(ce_figweld* figweld);
+
+    // evaluate all 4 * figfile->vertex_count vertices in file order (xyz)
+    void ce_figbake_eval_vertices(float* array, const ce_figfile* figfile, const complection_t* complection);
+
+    // evaluate all 4 * figfile->normal_count normals in file order (xyz)
+    void ce_figbake_eval_normals(float* array, const ce_figfile* figfile);
+}
+
+#endif
@@ -29,6 +29,7 @@
 #include "texture.hpp"
 #include "scenenode.hpp"
 #include "renderqueue.hpp"
+#include "soundobject.hpp"
 
 namespace cursedearth
 {
@@ -41,13 +42,18 @@ namespace cursedearth
         ce_vector* textures;
         ce_vector* renderlayers;
         ce_scenenode* scenenode;
+        sound_object_t sound_object; // 0 if silent
     } ce_figentity;
 
-    ce_figentity* ce_figentity_new(ce_figmesh* figmesh, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[], ce_scenenode* scenenode);
+    // entity takes ownership of the figbone, pass NULL to build it from the mesh
+    ce_figentity* ce_figentity_new(ce_figmesh* figmesh, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[], ce_figbone* figbone, ce_scenenode* scenenode);
     void ce_figentity_del(ce_figentity* figentity);
 
     void ce_figentity_fix_height(ce_figentity* figentity, float height);
 
+    // the entity takes ownership of the sound, which follows it; a previous sound is removed
+    void ce_figentity_attach_sound(ce_figentity* figentity, sound_object_t sound_object, int priority);
+
     int ce_figentity_get_animation_count(ce_figentity* figentity);
     const char* ce_figentity_get_animation_name(ce_figentity* figentity, int index);
 
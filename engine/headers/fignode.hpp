@@ -28,6 +28,7 @@
 #include "figfile.hpp"
 #include "bonfile.hpp"
 #include "anmfile.hpp"
+#include "anmstate.hpp"
 #include "material.hpp"
 #include "renderqueue.hpp"
 
@@ -39,6 +40,7 @@ namespace cursedearth
         ce_figfile* figfile;
         ce_bonfile* bonfile;
         ce_vector* anmfiles;
+        ce_anm_index* anm_index;
         ce_material* material;
         ce_rendergroup* rendergroup;
         ce_vector* childs;
@@ -23,11 +23,11 @@
 
 #include "renderitem.hpp"
 #include "fignode.hpp"
-#include "complection.hpp"
+#include "figbake.hpp"
 
 namespace cursedearth
 {
-    ce_renderitem* ce_figrenderitem_new(const ce_fignode* fignode, const complection_t* complection);
+    ce_renderitem* ce_figrenderitem_new(const ce_fignode* fignode, const ce_figbake* figbake);
 }
 
 #endif
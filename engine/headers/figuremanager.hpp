@@ -21,7 +21,13 @@
 #ifndef CE_FIGUREMANAGER_HPP
 #define CE_FIGUREMANAGER_HPP
 
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #include "vector.hpp"
+#include "thread.hpp"
 #include "figproto.hpp"
 #include "figmesh.hpp"
 #include "figentity.hpp"
@@ -31,15 +37,53 @@ namespace cursedearth
     typedef struct {
         void (*figproto_created)(void* listener, ce_figproto* figproto);
         void (*figmesh_created)(void* listener, ce_figmesh* figmesh);
+        void (*figures_removing)(void* listener); // entities or cached figures are about to be deleted
         void* listener;
     } ce_figure_manager_listener;
 
+    /*
+     *  Cache entries: protos are keyed by lower-case name, meshes by proto
+     *  and complection. An entry is unused when the cache holds the only
+     *  reference. Unused entries are kept up to the cache budget and then
+     *  evicted, least recently used first.
+     */
+    typedef struct {
+        ce_figproto* figproto;
+        size_t size;
+        uint64_t last_use;
+    } ce_figproto_entry;
+
+    typedef struct {
+        ce_figmesh* figmesh;
+        size_t size;
+        uint64_t last_use;
+    } ce_figmesh_entry;
+
+    struct ce_figmesh_key {
+        const ce_figproto* figproto;
+        complection_t complection;
+
+        bool operator ==(const ce_figmesh_key& other) const;
+    };
+
+    struct ce_figmesh_key_hash {
+        size_t operator ()(const ce_figmesh_key& key) const;
+    };
+
+    typedef std::unordered_map<std::string, ce_figproto_entry> ce_figproto_map;
+    typedef std::unordered_map<ce_figmesh_key, ce_figmesh_entry, ce_figmesh_key_hash> ce_figmesh_map;
+
     extern struct ce_figure_manager {
-        ce_vector* res_files;
-        ce_vector* figprotos;
-        ce_vector* figmeshes;
+        uint64_t use_count;
+        size_t cache_budget;
+        ce_vector* res_files; // opened on first use, so that menus do not wait for figure archives
+        std::once_flag* res_files_flag;
+        ce_figproto_map* figprotos;
+        ce_vector* pending_figprotos; // resolved off the render thread, listeners not yet notified
+        ce_figmesh_map* figmeshes;
         ce_vector* entities;
         ce_vector* listeners;
+        ce_mutex* mutex; // guards figprotos, pending_figprotos and use_count
     }* ce_figure_manager;
 
     void ce_figure_manager_init();
@@ -51,10 +95,28 @@ namespace cursedearth
         ce_vector_push_back(ce_figure_manager->listeners, listener);
     }
 
+    /**
+     * @brief find or load a figure proto, safe to call from any thread
+     *
+     * Returns a new reference, release it with ce_figproto_del. Listeners
+     * are not notified here, the render thread picks up newly loaded protos
+     * in ce_figure_manager_flush_protos.
+     */
+    ce_figproto* ce_figure_manager_resolve_proto(const std::string& name);
+    void ce_figure_manager_flush_protos();
+
+    // evict unused protos and meshes over the cache budget (render thread only)
+    void ce_figure_manager_trim();
+
+    // borrowed pointers, valid until the next trim unless a reference is taken
     ce_figproto* ce_figure_manager_create_proto(const std::string& name);
     ce_figmesh* ce_figure_manager_create_mesh(const std::string& name, const complection_t* complection);
+    ce_figmesh* ce_figure_manager_create_mesh_proto(ce_figproto* figproto, const complection_t* complection);
     ce_figentity* ce_figure_manager_create_entity(const std::string& name, const complection_t* complection, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[]);
 
+    // manager takes ownership of the figbone (built from the proto and complection)
+    ce_figentity* ce_figure_manager_create_entity_proto(ce_figproto* figproto, const complection_t* complection, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[], ce_figbone* figbone);
+
     void ce_figure_manager_remove_entity(ce_figentity* entity);
 }
 
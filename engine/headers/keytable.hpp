@@ -0,0 +1,111 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_KEYTABLE_HPP
+#define CE_KEYTABLE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace cursedearth
+{
+    const uint32_t CE_KEY_TABLE_NPOS = UINT32_MAX;
+
+    /**
+     * @brief parsed section/option layout shared by reg and config files
+     *        every name is interned once into a string pool, sections and options refer to it by id
+     *        (section name) and (section, option name) pairs are resolved through open-addressed hash indices,
+     *        so a lookup costs one hash of the query name instead of a string compare per entry
+     *        sections and options are appended in file order; options always belong to the last section
+     */
+    struct ce_key_table
+    {
+        struct section_t
+        {
+            uint32_t name;
+            uint32_t first_option;
+            uint32_t option_count;
+            uint32_t next; // next section with the same name or CE_KEY_TABLE_NPOS
+        };
+
+        struct name_slot_t
+        {
+            uint32_t hash;
+            uint32_t name;
+        };
+
+        struct key_slot_t
+        {
+            uint64_t key;
+            uint32_t value;
+        };
+
+        std::vector<char> names; // interned NUL-terminated names, a name id is its offset
+        std::vector<section_t> sections;
+        std::vector<uint32_t> options; // option name ids
+        std::vector<name_slot_t> name_slots;
+        std::vector<key_slot_t> key_slots;
+        uint32_t name_count = 0;
+        uint32_t key_count = 0;
+    };
+
+    // intern name; returns its id
+    uint32_t ce_key_table_intern(ce_key_table* key_table, const char* name, size_t length);
+
+    // id of an interned name or CE_KEY_TABLE_NPOS
+    uint32_t ce_key_table_name(const ce_key_table* key_table, const char* name);
+
+    // returns index of the new section
+    size_t ce_key_table_add_section(ce_key_table* key_table, const char* name, size_t length);
+
+    // append option to the last section; returns global index of the new option
+    size_t ce_key_table_add_option(ce_key_table* key_table, const char* name, size_t length);
+
+    inline size_t ce_key_table_section_count(const ce_key_table* key_table)
+    {
+        return key_table->sections.size();
+    }
+
+    inline const char* ce_key_table_section_name(const ce_key_table* key_table, size_t section_index)
+    {
+        return key_table->names.data() + key_table->sections[section_index].name;
+    }
+
+    inline const char* ce_key_table_option_name(const ce_key_table* key_table, size_t option_index)
+    {
+        return key_table->names.data() + key_table->options[option_index];
+    }
+
+    // first section with the given name; section count if not found
+    size_t ce_key_table_section_index(const ce_key_table* key_table, const char* section_name);
+
+    // next section with the same name; section count if there are no more
+    inline size_t ce_key_table_next_section(const ce_key_table* key_table, size_t section_index)
+    {
+        uint32_t next = key_table->sections[section_index].next;
+        return CE_KEY_TABLE_NPOS != next ? next : key_table->sections.size();
+    }
+
+    // global index of the first option with the given name in the section; CE_KEY_TABLE_NPOS if not found
+    uint32_t ce_key_table_option_index(const ce_key_table* key_table, size_t section_index, const char* option_name);
+}
+
+#endif
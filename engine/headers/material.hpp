@@ -21,6 +21,8 @@
 #ifndef CE_MATERIAL_HPP
 #define CE_MATERIAL_HPP
 
+#include <cstddef>
+
 #include "color.hpp"
 #include "shader.hpp"
 
@@ -34,6 +36,7 @@ namespace cursedearth
     } ce_material_mode;
 
     typedef struct {
+        size_t ref_count; // render groups hold a reference while they may apply the material
         ce_material_mode mode;
         color_t ambient;
         color_t diffuse;
@@ -47,6 +50,12 @@ namespace cursedearth
 
     ce_material* ce_material_new(void);
     void ce_material_del(ce_material* material);
+
+    inline ce_material* ce_material_add_ref(ce_material* material)
+    {
+        ++material->ref_count;
+        return material;
+    }
 }
 
 #endif
@@ -37,6 +37,7 @@ namespace cursedearth
         long int (*tell)(ce_mem_file* mem_file);
         int (*eof)(ce_mem_file* mem_file);
         int (*error)(ce_mem_file* mem_file);
+        void (*advise)(ce_mem_file* mem_file, long int offset, size_t size); // optional
     } ce_mem_file_vtable;
 
     struct ce_mem_file {
@@ -63,7 +64,7 @@ namespace cursedearth
     ce_mem_file* ce_mem_file_new_data(void* data, size_t size);
 
     /*
-     *  Implements a buffered interface for the FILE standard functions.
+     *  Implements a read-ahead buffered file on top of the FILE standard functions.
     */
     ce_mem_file* ce_mem_file_new_path(const boost::filesystem::path&);
 
@@ -106,6 +107,14 @@ namespace cursedearth
         return size;
     }
 
+    // hint that the range is going to be read soon, so that it can be fetched ahead
+    inline void ce_mem_file_advise(ce_mem_file* mem_file, long int offset, size_t size)
+    {
+        if (NULL != mem_file->vtable.advise) {
+            (mem_file->vtable.advise)(mem_file, offset, size);
+        }
+    }
+
     inline void ce_mem_file_skip(ce_mem_file* mem_file, size_t size)
     {
         ce_mem_file_seek(mem_file, size, CE_MEM_FILE_SEEK_CUR);
@@ -167,12 +176,24 @@ namespace cursedearth
         return le2cpu(value);
     }
 
-    inline uint32_t ce_mem_file_read_fle(ce_mem_file* mem_file)
+    inline float ce_mem_file_read_fle(ce_mem_file* mem_file)
     {
-        float value;
-        ce_mem_file_read(mem_file, &value, 4, 1);
-        return value;
+        union {
+            uint32_t u;
+            float f;
+        } value;
+        ce_mem_file_read(mem_file, &value.u, 4, 1);
+        value.u = le2cpu(value.u);
+        return value.f;
     }
+
+    /*
+     *  Bulk readers: fill an array of little-endian values converted to
+     *  the host byte order, return the number of values actually read.
+    */
+    size_t ce_mem_file_read_u16le_array(ce_mem_file* mem_file, uint16_t* values, size_t n);
+    size_t ce_mem_file_read_u32le_array(ce_mem_file* mem_file, uint32_t* values, size_t n);
+    size_t ce_mem_file_read_fle_array(ce_mem_file* mem_file, float* values, size_t n);
 }
 
 #endif
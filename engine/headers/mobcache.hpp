@@ -0,0 +1,108 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_MOBCACHE_HPP
+#define CE_MOBCACHE_HPP
+
+#include <cstdint>
+
+#include <boost/filesystem/path.hpp>
+
+#include "mobfile.hpp"
+
+namespace cursedearth
+{
+    enum {
+        CE_MOB_CACHE_VERSION = 1
+    };
+
+    /**
+     * @brief compiled level: a flat, read-only image of mob objects
+     *        all tables are structures of arrays indexed by object
+     *        all strings are offsets into the interned string pool
+     *        the image is mapped as is, so it's little-endian only
+     */
+    typedef struct {
+        // source mob file
+        uint64_t source_size;
+        int64_t source_mtime;
+        uint64_t source_hash;
+        // level
+        uint32_t name;
+        uint32_t script;
+        uint32_t object_count;
+        const uint32_t* types;
+        const uint32_t* ids;
+        const uint32_t* parent_ids;
+        const uint8_t* owners;
+        const uint8_t* quests;
+        const uint8_t* shadows;
+        const float* positions; // 3 per object
+        const float* rotations; // 4 per object
+        const float* complections; // 3 per object
+        const uint32_t* names;
+        const uint32_t* model_names;
+        const uint32_t* parent_names;
+        const uint32_t* primary_textures;
+        const uint32_t* secondary_textures;
+        const uint32_t* comments;
+        const uint32_t* quest_infos;
+        const uint32_t* part_offsets; // object_count + 1, object parts are in [i, i + 1)
+        const uint32_t* parts;
+        const char* strings;
+        // private data
+        void* impl;
+    } ce_mob_cache;
+
+    // compile mob file in memory
+    ce_mob_cache* ce_mob_cache_new(const ce_mob_file* mob_file, uint64_t source_size, int64_t source_mtime, uint64_t source_hash);
+
+    // map compiled mob file; NULL if it's missing, corrupted or outdated
+    ce_mob_cache* ce_mob_cache_open(const boost::filesystem::path&);
+
+    void ce_mob_cache_del(ce_mob_cache* mob_cache);
+
+    // save compiled mob file atomically; thread-safe
+    void ce_mob_cache_save(const ce_mob_cache* mob_cache, const boost::filesystem::path&);
+
+    // rewrite mapped cache file with a new source modification time, once contents are known to match
+    void ce_mob_cache_restamp(ce_mob_cache* mob_cache, int64_t source_mtime, const boost::filesystem::path&);
+
+    // hash contents of source mob file
+    uint64_t ce_mob_cache_hash_source(const boost::filesystem::path&);
+
+    // NULL-terminated, but may contain null characters (scripts)
+    inline const char* ce_mob_cache_string(const ce_mob_cache* mob_cache, uint32_t offset)
+    {
+        return mob_cache->strings + offset;
+    }
+
+    inline uint32_t ce_mob_cache_string_length(const ce_mob_cache* mob_cache, uint32_t offset)
+    {
+        return reinterpret_cast<const uint32_t*>(mob_cache->strings + offset)[-1];
+    }
+
+    inline uint32_t ce_mob_cache_part_count(const ce_mob_cache* mob_cache, uint32_t index)
+    {
+        return mob_cache->part_offsets[index + 1] - mob_cache->part_offsets[index];
+    }
+}
+
+#endif
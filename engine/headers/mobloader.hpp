@@ -22,9 +22,12 @@
 #define CE_MOBLOADER_HPP
 
 #include <string>
+#include <mutex>
+#include <condition_variable>
 
 #include "vector.hpp"
-#include "mobfile.hpp"
+#include "mprfile.hpp"
+#include "mobcache.hpp"
 
 namespace cursedearth
 {
@@ -32,22 +35,29 @@ namespace cursedearth
         size_t processed_event_count;
         size_t posted_event_count;
         ce_string* name;
-        ce_mob_file* mob_file;
+        ce_mob_cache* mob_cache;
+        const ce_mprfile* mprfile; // optional, used to fix figure heights
     } ce_mob_task;
 
-    ce_mob_task* ce_mob_task_new(const char* name);
+    ce_mob_task* ce_mob_task_new(const char* name, const ce_mprfile* mprfile);
     void ce_mob_task_del(ce_mob_task* mob_task);
 
     extern struct ce_mob_loader {
         size_t completed_job_count;
         size_t queued_job_count;
         ce_vector* mob_tasks;
+        size_t worker_job_count; // task and batch jobs queued on the thread pool, guarded by mutex
+        std::mutex* mutex;
+        std::condition_variable* idle;
     }* ce_mob_loader;
 
     void ce_mob_loader_init(void);
     void ce_mob_loader_term(void);
 
-    void ce_mob_loader_load_mob(const std::string& name);
+    void ce_mob_loader_load_mob(const std::string& name, const ce_mprfile* mprfile = NULL);
+
+    // wait for workers and detach pending tasks from the mpr file; call it before the mpr file is deleted
+    void ce_mob_loader_release_mprfile(const ce_mprfile* mprfile);
 }
 
 #endif
@@ -24,6 +24,7 @@
 #include <string>
 
 #include "mobfile.hpp"
+#include "mobcache.hpp"
 
 namespace cursedearth
 {
@@ -35,6 +36,9 @@ namespace cursedearth
     void ce_mob_manager_term(void);
 
     ce_mob_file* ce_mob_manager_open(const std::string& name);
+
+    // search compiled level in cache directory, compile mob file if cache is missing or outdated; thread-safe
+    ce_mob_cache* ce_mob_manager_open_cache(const std::string& name);
 }
 
 #endif
@@ -26,6 +26,7 @@
 #define CE_MPRFILE_HPP
 
 #include <cstdint>
+#include <mutex>
 
 #include "string.hpp"
 #include "resfile.hpp"
@@ -62,6 +63,8 @@ namespace cursedearth
         uint16_t* land_textures;
         uint16_t* water_textures;
         int16_t* water_allow;
+        size_t size;
+        void* data; // decoded payload, arrays above point into it
     } ce_mprsector;
 
     typedef struct {
@@ -79,12 +82,22 @@ namespace cursedearth
         uint32_t* tiles;
         uint16_t* anim_tiles;
         ce_mprsector* sectors;
+        size_t* sector_nodes;
+        std::once_flag* sector_flags;
+        ce_res_file* res_file;
         size_t size;
         void* data;
     } ce_mprfile;
 
+    // mpr file takes ownership of the res file, sectors are decoded from it on first use
     ce_mprfile* ce_mprfile_open(ce_res_file* res_file);
     void ce_mprfile_close(ce_mprfile* mprfile);
+
+    // thread-safe, decodes the sector if it has not been used yet
+    ce_mprsector* ce_mprfile_sector(const ce_mprfile* mprfile, int sector_x, int sector_z);
+
+    // decode all sectors on the thread pool, do not call it from a thread pool task
+    void ce_mprfile_decode_sectors(const ce_mprfile* mprfile);
 }
 
 #endif
@@ -25,6 +25,8 @@
 #include "singleton.hpp"
 #include "optparse.hpp"
 
+#include <string>
+
 #include <boost/filesystem/path.hpp>
 
 namespace cursedearth
@@ -41,7 +43,16 @@ namespace cursedearth
 
         bool terrain_tiling() const { return m_enable_terrain_tiling; }
         bool texture_caching() const { return !m_disable_texture_caching; }
+        bool level_caching() const { return !m_disable_level_caching; }
+        bool archive_indexing() const { return m_enable_archive_indexing; }
         bool disable_sound() const { return m_disable_sound; }
+        bool low_latency_sound() const { return m_low_latency_sound; }
+        size_t sound_buffer_time() const { return m_sound_buffer_time; }
+        size_t sound_period_time() const { return m_sound_period_time; }
+        const std::string& sound_output() const { return m_sound_output; }
+        size_t sound_voice_count() const { return m_sound_voice_count; }
+        size_t video_prefetch_frames() const { return m_video_prefetch_frames; }
+        size_t figure_cache_size() const { return m_figure_cache_size; }
 
         bool show_axes() const { return m_show_axes; }
         bool show_fps() const { return m_show_fps; }
@@ -69,7 +80,16 @@ namespace cursedearth
         boost::filesystem::path m_ce_path;
         bool m_enable_terrain_tiling;
         bool m_disable_texture_caching;
+        bool m_disable_level_caching;
+        bool m_enable_archive_indexing;
         bool m_disable_sound;
+        bool m_low_latency_sound;
+        int m_sound_buffer_time;
+        int m_sound_period_time;
+        std::string m_sound_output;
+        int m_sound_voice_count;
+        int m_video_prefetch_frames;
+        int m_figure_cache_size;
         bool m_show_axes;
         bool m_show_fps;
     };
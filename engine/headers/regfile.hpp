@@ -26,21 +26,25 @@
 #define CE_REGFILE_HPP
 
 #include <cstdint>
+#include <vector>
 
-#include "vector.hpp"
-#include "object.hpp"
+#include "value.hpp"
+#include "keytable.hpp"
 #include "memfile.hpp"
 
 namespace cursedearth
 {
-    typedef struct {
-        ce_vector* sections;
-    } ce_reg_file;
+    struct ce_reg_file
+    {
+        ce_key_table key_table;
+        std::vector<uint32_t> first_values; // per option, one past the last value at the end
+        std::vector<ce_value*> values;
+    };
 
     ce_reg_file* ce_reg_file_new(ce_mem_file* mem_file);
     void ce_reg_file_del(ce_reg_file* reg_file);
 
-    ce_value* ce_reg_file_find(ce_reg_file* reg_file, const char* section_name, const char* option_name, size_t index);
+    ce_value* ce_reg_file_find(const ce_reg_file* reg_file, const char* section_name, const char* option_name, size_t index);
 }
 
 #endif
@@ -42,9 +42,17 @@ namespace cursedearth
     void ce_res_ball_extract_all_mem_files(ce_res_file* res_file, ce_mem_file* mem_files[]);
     void ce_res_ball_clean_all_mem_files(ce_res_file* res_file, ce_mem_file* mem_files[]);
 
+    /*
+     *  Opens a view over the node data range of the parent archive.
+     *  Nothing is copied, reads go through the parent mem file under
+     *  the parent mutex. The parent must outlive the view.
+    */
+    ce_mem_file* ce_res_ball_open_mem_file(ce_res_file* res_file, size_t index);
+
+    // nested archives are opened as views, see above
     inline ce_res_file* ce_res_ball_extract_res_file(ce_res_file* res_file, size_t index)
     {
-        return ce_res_file_new(ce_res_file_node_name(res_file, index), ce_res_ball_extract_mem_file(res_file, index));
+        return ce_res_file_new(ce_res_file_node_name(res_file, index), ce_res_ball_open_mem_file(res_file, index));
     }
 
     inline ce_res_file* ce_res_ball_extract_res_file_by_name(ce_res_file* res_file, const std::string& name)
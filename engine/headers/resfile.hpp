@@ -28,6 +28,7 @@
 
 #include "string.hpp"
 #include "memfile.hpp"
+#include "thread.hpp"
 
 namespace cursedearth
 {
@@ -52,6 +53,7 @@ namespace cursedearth
         char* names;
         ce_res_node* nodes;
         ce_mem_file* mem_file;
+        ce_mutex* mutex; // guards mem_file position, node data may be read from any thread
     } ce_res_file;
 
     // res file takes ownership of the mem file if successfull
@@ -77,6 +79,15 @@ namespace cursedearth
     }
 
     void* ce_res_file_node_data(ce_res_file* res_file, size_t index);
+
+    // read node data into a caller-provided buffer of at least node size bytes;
+    // false on a short read (truncated or damaged archive)
+    bool ce_res_file_node_read(ce_res_file* res_file, size_t index, void* data);
+
+    // raw access to the archive byte range, used to read several adjacent nodes at once;
+    // false on a short read (truncated or damaged archive)
+    bool ce_res_file_read_range(ce_res_file* res_file, size_t offset, size_t size, void* data);
+    void ce_res_file_advise_range(ce_res_file* res_file, size_t offset, size_t size);
 }
 
 #endif
@@ -0,0 +1,66 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_RESINDEX_HPP
+#define CE_RESINDEX_HPP
+
+#include <cstdint>
+
+#include <boost/filesystem/path.hpp>
+
+#include "resfile.hpp"
+
+namespace cursedearth
+{
+    enum {
+        CE_RES_INDEX_VERSION = 1
+    };
+
+    /**
+     * @brief content index: a 64-bit hash of every node of a res archive
+     *        it's kept in a sidecar file bound to the archive by size and modification time,
+     *        so a valid sidecar is accepted without reading any payload
+     *        derived data may store node hashes to find out what changed after a game patch
+     */
+    typedef struct {
+        uint64_t source_size;
+        int64_t source_mtime;
+        uint32_t node_count;
+        uint64_t* hashes; // FNV-1a of node data, indexed as res file nodes
+    } ce_res_index;
+
+    // read every node in file order and hash it on the thread pool; do not call it from a thread pool task
+    ce_res_index* ce_res_index_new(ce_res_file* res_file, uint64_t source_size, int64_t source_mtime);
+
+    // read sidecar; NULL if it's missing or corrupted
+    ce_res_index* ce_res_index_open(const boost::filesystem::path&);
+
+    void ce_res_index_del(ce_res_index* res_index);
+
+    // save sidecar atomically; thread-safe
+    void ce_res_index_save(const ce_res_index* res_index, const boost::filesystem::path&);
+
+    inline uint64_t ce_res_index_node_hash(const ce_res_index* res_index, size_t index)
+    {
+        return res_index->hashes[index];
+    }
+}
+
+#endif
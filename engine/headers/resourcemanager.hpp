@@ -22,22 +22,189 @@
 #define CE_RESOURCEMANAGER_HPP
 
 #include <string>
+#include <map>
+#include <tuple>
+#include <future>
+#include <atomic>
+#include <typeindex>
 
+#include "alloc.hpp"
+#include "makeunique.hpp"
+#include "singleton.hpp"
+#include "conditionvariable.hpp"
+#include "threadpool.hpp"
 #include "resource.hpp"
 #include "string.hpp"
 #include "resfile.hpp"
+#include "resindex.hpp"
 
 namespace cursedearth
 {
     extern struct ce_resource_manager {
         ce_res_file* database;
         ce_res_file* menus;
+        // content indices of the archives above, only if archive indexing is enabled
+        ce_res_index* database_index;
+        ce_res_index* menus_index;
     }* ce_resource_manager;
 
     void ce_resource_manager_init();
     void ce_resource_manager_term();
 
     size_t ce_resource_manager_find_data(const std::string& path);
+
+    // content index of the archive from its sidecar in the cache directory;
+    // the index is built and saved if the sidecar is missing or does not match the archive,
+    // and built without a sidecar if the archive can't be stamped
+    ce_res_index* ce_resource_manager_open_index(const boost::filesystem::path& archive_path, ce_res_file* res_file);
+
+    class thread_lock_t;
+
+    /**
+     * @brief node data read by the resource loader
+     *        either a buffer of its own or a view into a span of nodes read at once
+     *        exclusive data has a single consumer, which may take the buffer over
+     */
+    struct resource_data_t: untransferable_t
+    {
+        resource_data_t(void* data, size_t size, bool exclusive): data(data), size(size), exclusive(exclusive), released(false) {}
+        resource_data_t(const std::shared_ptr<uint8_t>& span, void* data, size_t size): data(data), size(size), exclusive(false), released(false), span(span) {}
+        ~resource_data_t() { if (!span && !released) ce_free(data, size); }
+
+        // a ce_alloc'ed buffer of size bytes owned by the caller: this one if exclusive,
+        // a copy if shared or a view into a span (nodes read together with their neighbours)
+        void* release() const;
+
+        void* const data;
+        const size_t size;
+        const bool exclusive;
+        mutable std::atomic<bool> released;
+        const std::shared_ptr<uint8_t> span;
+    };
+
+    typedef std::shared_ptr<const resource_data_t> resource_data_ptr_t;
+    typedef std::shared_future<resource_data_ptr_t> resource_data_future_t;
+
+    /**
+     * @brief the resource loader is the single scheduling point for archive reads
+     *        all reads are done by one I/O thread, each batch in archive offset order
+     *        duplicate in-flight requests share one read and one decoding
+     *        decoding is done on the thread pool
+     *        all functions are thread-safe
+     */
+    class resource_loader_t final: public singleton_t<resource_loader_t>
+    {
+        typedef std::function<void (const resource_data_ptr_t&)> continuation_t;
+
+        struct request_t
+        {
+            ce_res_file* res_file;
+            size_t index;
+            std::promise<resource_data_ptr_t> promise;
+            resource_data_future_t future;
+            std::vector<continuation_t> continuations;
+            size_t consumer_count; // readers and continuations
+        };
+
+        typedef std::shared_ptr<request_t> request_ptr_t;
+        typedef std::tuple<ce_res_file*, size_t, std::type_index> decode_key_t;
+
+        // outlives the loader in queued decoding tasks
+        struct decode_registry_t
+        {
+            std::mutex mutex;
+            std::map<decode_key_t, std::shared_ptr<void>> futures;
+        };
+
+    public:
+        resource_loader_t();
+        ~resource_loader_t();
+
+        // raw node data, null if there is no such node or it could not be read
+        resource_data_future_t read(ce_res_file*, const std::string& name);
+
+        // node data decoded to T on the thread pool, null if there is no such node or it could not be read;
+        // requests for the same archive, name and type share one decoding while in flight
+        template <typename T>
+        std::shared_future<std::shared_ptr<T>> load(ce_res_file*, const std::string& name, std::function<std::shared_ptr<T> (const resource_data_ptr_t&)> decoder);
+
+    private:
+        // nodes this close are read together, a gap is cheaper to read than to seek over
+        static constexpr size_t merge_gap = 64 * 1024;
+        static constexpr size_t max_span_size = 4 * 1024 * 1024;
+
+        static size_t span_begin(const request_ptr_t& request) { return request->res_file->nodes[request->index].data_offset; }
+        static size_t span_end(const request_ptr_t& request) { return span_begin(request) + request->res_file->nodes[request->index].data_length; }
+
+        resource_data_future_t request(ce_res_file*, size_t index, const continuation_t&);
+        // span is the buffer data points into, null if data is a buffer of its own;
+        // null data means the node could not be read
+        void complete(const request_ptr_t&, void* data, size_t size, const std::shared_ptr<uint8_t>& span, thread_lock_t&);
+        void read_run(std::vector<request_ptr_t>::const_iterator first, std::vector<request_ptr_t>::const_iterator last, size_t end, thread_lock_t&);
+        void execute();
+
+    private:
+        std::mutex m_mutex;
+        condition_variable_ptr_t m_idle;
+        std::vector<request_ptr_t> m_queue;
+        std::map<std::pair<ce_res_file*, size_t>, request_ptr_t> m_requests; // queued or being read
+        std::shared_ptr<decode_registry_t> m_decodes;
+        thread_ptr_t m_thread;
+    };
+
+    template <typename T>
+    std::shared_future<std::shared_ptr<T>> resource_loader_t::load(ce_res_file* res_file, const std::string& name, std::function<std::shared_ptr<T> (const resource_data_ptr_t&)> decoder)
+    {
+        typedef std::shared_future<std::shared_ptr<T>> future_t;
+        typedef std::promise<std::shared_ptr<T>> promise_t;
+
+        const size_t index = ce_res_file_node_index(res_file, name);
+        const decode_key_t key(res_file, index, std::type_index(typeid(T)));
+        const std::shared_ptr<decode_registry_t> decodes = m_decodes;
+        const std::shared_ptr<promise_t> promise = std::make_shared<promise_t>();
+
+        std::shared_ptr<future_t> future;
+        {
+            std::lock_guard<std::mutex> lock(decodes->mutex);
+            std::ignore = lock;
+            auto it = decodes->futures.find(key);
+            if (decodes->futures.end() != it) {
+                return *std::static_pointer_cast<future_t>(it->second);
+            }
+            future = std::make_shared<future_t>(promise->get_future().share());
+            decodes->futures[key] = future;
+        }
+
+        request(res_file, index, [decodes, promise, decoder, key] (const resource_data_ptr_t& data) {
+            if (nullptr == data) {
+                // no such node or the loader is going away: nothing to decode
+                promise->set_value(nullptr);
+                std::lock_guard<std::mutex> lock(decodes->mutex);
+                std::ignore = lock;
+                decodes->futures.erase(key);
+                return;
+            }
+            thread_pool_t::instance()->enqueue([decodes, promise, decoder, key, data] {
+                try {
+                    promise->set_value(decoder(data));
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+                std::lock_guard<std::mutex> lock(decodes->mutex);
+                std::ignore = lock;
+                decodes->futures.erase(key);
+            });
+        });
+
+        return *future;
+    }
+
+    typedef std::unique_ptr<resource_loader_t> resource_loader_ptr_t;
+
+    inline resource_loader_ptr_t make_resource_loader()
+    {
+        return make_unique<resource_loader_t>();
+    }
 }
 
 #endif
@@ -27,9 +27,11 @@
 #include "renderwindow.hpp"
 #include "soundsystem.hpp"
 #include "soundmixer.hpp"
+#include "soundscheduler.hpp"
 #include "soundmanager.hpp"
 #include "videomanager.hpp"
 #include "threadpool.hpp"
+#include "resourcemanager.hpp"
 #include "scenemanager.hpp"
 
 namespace cursedearth
@@ -57,9 +59,11 @@ namespace cursedearth
         render_window_ptr_t m_render_window;
         sound_system_ptr_t m_sound_system;
         sound_mixer_ptr_t m_sound_mixer;
+        sound_scheduler_ptr_t m_sound_scheduler;
         sound_manager_ptr_t m_sound_manager;
         video_manager_ptr_t m_video_manager;
         thread_pool_ptr_t m_thread_pool;
+        resource_loader_ptr_t m_resource_loader;
         scene_manager_ptr_t m_scene_manager;
     };
 }
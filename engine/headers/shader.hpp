@@ -55,6 +55,9 @@ namespace cursedearth
     void ce_shader_bind(ce_shader* shader);
     void ce_shader_unbind(ce_shader* shader);
 
+    // shader must be bound
+    void ce_shader_set_uniform_int(ce_shader* shader, const char* name, int value);
+
     inline ce_shader* ce_shader_add_ref(ce_shader* shader)
     {
         ++shader->ref_count;
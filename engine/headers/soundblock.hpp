@@ -45,6 +45,12 @@ namespace cursedearth
 
         std::pair<const uint8_t*, size_t> read_raw();
 
+        // zero-copy access: spans cover the unread/unwritten part of the block, consume/commit advance them
+        std::pair<const uint8_t*, size_t> read_span() const { return std::make_pair(m_data.get() + m_read_position, read_size()); }
+        std::pair<uint8_t*, size_t> write_span() { return std::make_pair(m_data.get() + m_write_position, write_size()); }
+        void consume(size_t);
+        void commit(size_t);
+
         void reset();
 
     private:
@@ -53,8 +59,6 @@ namespace cursedearth
         size_t m_write_position = 0, m_read_position = 0;
         std::unique_ptr<uint8_t[]> m_data;
     };
-
-    typedef std::shared_ptr<sound_block_t> sound_block_ptr_t;
 }
 
 #endif
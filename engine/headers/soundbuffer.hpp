@@ -21,15 +21,26 @@
 #ifndef CE_SOUNDBUFFER_HPP
 #define CE_SOUNDBUFFER_HPP
 
-#include "ringbuffer.hpp"
+#include "conditionvariable.hpp"
 #include "soundblock.hpp"
 
+#include <atomic>
+#include <vector>
+
 namespace cursedearth
 {
+    /**
+     * @brief Single-Producer/Single-Consumer ring of preallocated sound blocks
+     *
+     * Blocks never leave the buffer: the producer fills the block returned by
+     * acquire and publishes it with push, the consumer reads the block returned
+     * by pop (or spans of it) and hands it back with release. The indices are
+     * atomics, so the mutex is only touched when one side has to wait.
+     */
     class sound_buffer_t final: untransferable_t
     {
     public:
-        explicit sound_buffer_t(const sound_format_t&);
+        explicit sound_buffer_t(const sound_format_t&, size_t block_count = sound_options_t::block_count);
 
         const sound_format_t& format() const { return m_format; }
 
@@ -38,24 +49,42 @@ namespace cursedearth
         void wakeup() { m_sleeping = false; }
 
         size_t granule_position() const { return m_granule_position; }
+
+        // for producers: number of blocks queued for the mixer and whether one more fits without blocking
+        size_t queued_block_count() const { return m_write_index - m_read_index; }
+        bool full() const { return m_blocks.size() == queued_block_count(); }
         void reset_granule_position() { m_granule_position = 0; }
 
-        void push(const sound_block_ptr_t&);
-        sound_block_ptr_t pop();
+        // for producers: empty block to be filled, null if the buffer is full and waiting is not allowed
+        sound_block_t* acquire(bool wait = true);
+        void push(sound_block_t*);
+
+        // for consumers: oldest filled block, null if the buffer is empty and waiting is not allowed
+        sound_block_t* pop(bool wait = true);
+        void release(sound_block_t*);
 
-        bool try_read_one_sample(uint8_t[sound_options_t::max_sample_size]);
+        // for consumers: zero-copy reading across blocks without blocking;
+        // the span covers whole samples of the oldest block, empty if nothing is queued
+        std::pair<const uint8_t*, size_t> try_read_span();
+        void consume(size_t);
+
+    private:
+        sound_block_t* front() { return 0 == queued_block_count() ? nullptr : m_blocks[m_read_index % m_blocks.size()].get(); }
 
-        sound_block_ptr_t acquire();
-        void release(const sound_block_ptr_t&);
+        template <typename predicate_t>
+        void wait(predicate_t);
+        void notify();
 
     private:
         const sound_format_t m_format;
         std::atomic<bool> m_sleeping;
         std::atomic<size_t> m_granule_position;
-        sound_block_ptr_t m_current_block;
+        std::vector<std::unique_ptr<sound_block_t>> m_blocks;
+        std::atomic<size_t> m_write_index;
+        std::atomic<size_t> m_read_index;
+        std::atomic<size_t> m_waiter_count;
         std::mutex m_mutex;
-        std::vector<sound_block_ptr_t> m_blocks;
-        ring_buffer_t<sound_block_ptr_t> m_buffer;
+        condition_variable_ptr_t m_condition_variable;
     };
 
     typedef std::shared_ptr<sound_buffer_t> sound_buffer_ptr_t;
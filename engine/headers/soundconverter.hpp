@@ -0,0 +1,77 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_SOUNDCONVERTER_HPP
+#define CE_SOUNDCONVERTER_HPP
+
+#include "makeunique.hpp"
+#include "soundbuffer.hpp"
+#include "soundresampler.hpp"
+
+namespace cursedearth
+{
+    /*
+     *  Block converters between interleaved samples of a sound format
+     *  and the internal float representation in [-1, 1].
+     *  8-bit samples are unsigned as in WAV, 24-bit samples are packed
+     *  into 3 little-endian bytes, 32-bit samples are either integers
+     *  or IEEE floats; 16/32-bit samples are in host byte order.
+    */
+    void convert_to_float(float* output, const uint8_t* input, size_t value_count, const sound_format_t&);
+    void convert_from_float(uint8_t* output, const float* input, size_t value_count, const sound_format_t&);
+
+    /*
+     *  Pulls samples from a sound buffer and delivers them in the native
+     *  (device) rate and channel layout as floats, ready to be mixed.
+    */
+    class sound_converter_t final: untransferable_t
+    {
+    public:
+        sound_converter_t(const sound_buffer_ptr_t&, const sound_format_t& native_format);
+
+        const sound_buffer_ptr_t& buffer() const { return m_buffer; }
+
+        // returns the number of frames delivered, less than requested if the buffer runs dry
+        size_t read(float* output, size_t frame_count);
+
+        // drops the input that would make up frame_count native frames without converting it
+        size_t skip(size_t frame_count);
+
+    private:
+        size_t read_foreign(float* output, size_t frame_count);
+        void map_channels(float* output, const float* input, size_t frame_count) const;
+
+    private:
+        const sound_buffer_ptr_t m_buffer;
+        const sound_format_t m_native_format;
+        std::unique_ptr<sound_resampler_t> m_resampler;
+        std::vector<float> m_foreign;
+        std::vector<float> m_resampled;
+    };
+
+    typedef std::unique_ptr<sound_converter_t> sound_converter_ptr_t;
+
+    inline sound_converter_ptr_t make_sound_converter(const sound_buffer_ptr_t& buffer, const sound_format_t& native_format)
+    {
+        return make_unique<sound_converter_t>(buffer, native_format);
+    }
+}
+
+#endif
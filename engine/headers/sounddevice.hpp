@@ -24,35 +24,90 @@
 #include "makeunique.hpp"
 #include "soundblock.hpp"
 
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+
+#include <boost/filesystem/path.hpp>
+
 namespace cursedearth
 {
+    /**
+     * @brief requested output latency in microseconds; devices pick the nearest supported values
+     */
+    struct sound_latency_t
+    {
+        size_t buffer_time;
+        size_t period_time;
+
+        sound_latency_t(size_t buffer_time, size_t period_time): buffer_time(buffer_time), period_time(period_time) {}
+    };
+
     class sound_device_t: untransferable_t
     {
     public:
-        explicit sound_device_t(const sound_format_t& format): m_format(format) {}
+        explicit sound_device_t(const sound_format_t& format): m_format(format), m_underrun_count(0), m_suspend_count(0) {}
         virtual ~sound_device_t() = default;
 
-        virtual void write(const sound_block_ptr_t&) = 0;
+        virtual void write(sound_block_t&) = 0;
+
+        // xruns the device has recovered from
+        size_t underrun_count() const { return m_underrun_count; }
+        size_t suspend_count() const { return m_suspend_count; }
 
     protected:
         const sound_format_t m_format;
+        std::atomic<size_t> m_underrun_count;
+        std::atomic<size_t> m_suspend_count;
     };
 
+    /**
+     * @brief discards output; paced like a real device or as fast as the mixer goes
+     */
     class null_sound_device_t final: public sound_device_t
     {
     public:
-        explicit null_sound_device_t(const sound_format_t&);
+        null_sound_device_t(const sound_format_t&, bool realtime);
+
+        virtual void write(sound_block_t&) final;
+
+    private:
+        const bool m_realtime;
+        std::chrono::steady_clock::time_point m_start_time;
+        size_t m_sample_count = 0;
+    };
+
+    /**
+     * @brief writes output into a WAV file as fast as the mixer goes
+     */
+    class wave_sound_device_t final: public sound_device_t
+    {
+    public:
+        wave_sound_device_t(const sound_format_t&, const boost::filesystem::path&);
+        ~wave_sound_device_t();
+
+        virtual void write(sound_block_t&) final;
 
-        virtual void write(const sound_block_ptr_t&) final;
+    private:
+        void write_header();
+
+    private:
+        FILE* m_file;
+        size_t m_data_size = 0;
     };
 
     typedef std::shared_ptr<sound_device_t> sound_device_ptr_t;
 
-    sound_device_ptr_t make_sound_device(const sound_format_t&);
+    sound_device_ptr_t make_sound_device(const sound_format_t&, const sound_latency_t&);
+
+    inline sound_device_ptr_t make_null_sound_device(const sound_format_t& format, bool realtime = true)
+    {
+        return std::make_shared<null_sound_device_t>(format, realtime);
+    }
 
-    inline sound_device_ptr_t make_null_sound_device(const sound_format_t& format)
+    inline sound_device_ptr_t make_wave_sound_device(const sound_format_t& format, const boost::filesystem::path& path)
     {
-        return std::make_shared<null_sound_device_t>(format);
+        return std::make_shared<wave_sound_device_t>(format, path);
     }
 }
 
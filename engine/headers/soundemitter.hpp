@@ -0,0 +1,72 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_SOUNDEMITTER_HPP
+#define CE_SOUNDEMITTER_HPP
+
+#include "vector3.hpp"
+
+#include <atomic>
+#include <memory>
+
+namespace cursedearth
+{
+    /**
+     * @brief where and how loud a sound plays
+     *
+     * The placement is set by the game and evaluated once per frame by the
+     * sound manager (see spatialize), which publishes the resulting gains and
+     * whether the sound is mixed at all; the mixer only reads those.
+     */
+    struct sound_emitter_t
+    {
+        // main thread
+        bool positional = false;
+        vector3_t position = { 0.0f, 0.0f, 0.0f };
+        int priority = 0;
+        float volume = 1.0f;
+
+        // published for the mixer
+        std::atomic<float> left_gain{1.0f};
+        std::atomic<float> right_gain{1.0f};
+        std::atomic<bool> audible{true}; // virtual otherwise: time goes on, nothing is mixed
+
+        // gains for the native channel layout: left, right, the rest get the average
+        void channel_gains(float* gains, size_t channel_count) const;
+    };
+
+    typedef std::shared_ptr<sound_emitter_t> sound_emitter_ptr_t;
+
+    inline sound_emitter_ptr_t make_sound_emitter()
+    {
+        return std::make_shared<sound_emitter_t>();
+    }
+
+    struct sound_listener_t
+    {
+        vector3_t position;
+        vector3_t right; // unit
+    };
+
+    // computes and publishes the gains, returns the loudness used to rank voices
+    float spatialize(sound_emitter_t&, const sound_listener_t&);
+}
+
+#endif
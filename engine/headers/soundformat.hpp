@@ -33,17 +33,20 @@ namespace cursedearth
         size_t channel_count;
         size_t sample_size;
         size_t bytes_per_second;
+        bool floating_point;
 
-        sound_format_t(size_t bits_per_sample, size_t samples_per_second, size_t channel_count):
+        sound_format_t(size_t bits_per_sample, size_t samples_per_second, size_t channel_count, bool floating_point = false):
             bits_per_sample(bits_per_sample), samples_per_second(samples_per_second), channel_count(channel_count),
-            sample_size(channel_count * (bits_per_sample / 8)), bytes_per_second(samples_per_second * sample_size) {}
+            sample_size(channel_count * (bits_per_sample / 8)), bytes_per_second(samples_per_second * sample_size),
+            floating_point(floating_point) {}
     };
 
     inline bool operator ==(const sound_format_t& lhs, const sound_format_t& rhs)
     {
         return lhs.bits_per_sample    == rhs.bits_per_sample    &&
                lhs.samples_per_second == rhs.samples_per_second &&
-               lhs.channel_count      == rhs.channel_count;
+               lhs.channel_count      == rhs.channel_count      &&
+               lhs.floating_point     == rhs.floating_point;
     }
 
     inline sound_format_t make_default_format()
@@ -22,6 +22,7 @@
 #define CE_SOUNDINSTANCE_HPP
 
 #include "soundresource.hpp"
+#include "soundemitter.hpp"
 
 namespace cursedearth
 {
@@ -42,20 +43,26 @@ namespace cursedearth
 
         float time() const { return m_buffer->granule_position() * m_bytes_per_second_inv; }
 
+        const sound_emitter_ptr_t& emitter() const { return m_emitter; }
+
         void advance(float) {}
 
     private:
-        void pause();
-        void execute();
+        friend class sound_scheduler_t;
+
+        // seconds of queued sound left before the mixer starves
+        float deadline() const { return m_buffer->queued_block_count() * m_seconds_per_block; }
+
+        // called by the scheduler only, never concurrently
+        void process();
 
     private:
         std::atomic<sound_instance_state_t> m_state;
         const float m_bytes_per_second_inv;
+        const float m_seconds_per_block;
         ce_sound_resource* m_resource;
+        const sound_emitter_ptr_t m_emitter;
         sound_buffer_ptr_t m_buffer;
-        std::mutex m_mutex;
-        condition_variable_ptr_t m_pause_condition;
-        thread_t m_thread;
     };
 
     typedef std::shared_ptr<sound_instance_t> sound_instance_ptr_t;
@@ -24,10 +24,12 @@
 #include "makeunique.hpp"
 #include "singleton.hpp"
 #include "soundinstance.hpp"
+#include "soundvoice.hpp"
 #include "soundobject.hpp"
 #include "resfile.hpp"
 
 #include <unordered_map>
+#include <mutex>
 
 namespace cursedearth
 {
@@ -37,19 +39,57 @@ namespace cursedearth
         sound_manager_t();
         ~sound_manager_t();
 
+        // ranks the playing sounds by priority and loudness at the listener,
+        // only the first sound_voice_count of the audible ones are mixed
         void advance(float elapsed);
 
+        void set_listener(const sound_listener_t& listener) { m_listener = listener; }
+
+        sound_emitter_ptr_t find_emitter(sound_object_t);
+
         sound_object_t make_instance(const std::string&);
+        void remove_instance(sound_object_t);
 
         sound_instance_ptr_t find_instance(sound_object_t object)
         {
-            return m_instances[object];
+            auto it = m_instances.find(object);
+            return m_instances.end() != it ? it->second : nullptr;
+        }
+
+        sound_voice_ptr_t find_voice(sound_object_t object)
+        {
+            auto it = m_voices.find(object);
+            return m_voices.end() != it ? it->second : nullptr;
         }
 
+    private:
+        struct candidate_t
+        {
+            sound_object_t object;
+            sound_emitter_t* emitter;
+            float gain;
+        };
+
+        // sound bank: short sounds decoded once, null for sounds too long to be kept in memory
+        // or still being decoded; shared with the decode tasks, which may outlive the manager
+        struct bank_t
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, sound_sample_ptr_t> samples;
+        };
+
+        ce_sound_resource* open_resource(const std::string&);
+        void bank_sample(const std::string&);
+
     private:
         sound_object_t m_last_object;
+        const size_t m_voice_count;
+        sound_listener_t m_listener;
+        std::vector<candidate_t> m_candidates;
         std::vector<ce_res_file*> m_files;
         std::unordered_map<sound_object_t, sound_instance_ptr_t> m_instances;
+        std::unordered_map<sound_object_t, sound_voice_ptr_t> m_voices;
+        const std::shared_ptr<bank_t> m_bank;
     };
 
     typedef std::unique_ptr<sound_manager_t> sound_manager_ptr_t;
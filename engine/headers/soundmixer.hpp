@@ -23,7 +23,8 @@
 
 #include "makeunique.hpp"
 #include "singleton.hpp"
-#include "soundbuffer.hpp"
+#include "soundconverter.hpp"
+#include "soundvoice.hpp"
 
 #include <list>
 
@@ -31,17 +32,28 @@ namespace cursedearth
 {
     class sound_mixer_t final: public singleton_t<sound_mixer_t>
     {
+        struct source_t
+        {
+            sound_converter_ptr_t converter;
+            sound_emitter_ptr_t emitter;
+        };
+
     public:
         sound_mixer_t();
         ~sound_mixer_t();
 
-        sound_buffer_ptr_t make_buffer(const sound_format_t&);
+        sound_buffer_ptr_t make_buffer(const sound_format_t&, const sound_emitter_ptr_t&);
+        void remove_buffer(const sound_buffer_ptr_t&);
+
+        // mixes the voice until it stops or pauses; no-op if it is already being mixed
+        void add_voice(const sound_voice_ptr_t&);
 
     private:
         void execute();
 
     private:
-        std::list<sound_buffer_ptr_t> m_buffers;
+        std::list<source_t> m_sources;
+        std::list<sound_voice_ptr_t> m_voices;
         std::mutex m_mutex;
         thread_t m_thread;
     };
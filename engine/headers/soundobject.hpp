@@ -21,6 +21,10 @@
 #ifndef CE_SOUNDOBJECT_HPP
 #define CE_SOUNDOBJECT_HPP
 
+#include "vector3.hpp"
+
+#include <string>
+
 namespace cursedearth
 {
     typedef unsigned long sound_object_t;
@@ -40,6 +44,11 @@ namespace cursedearth
 
     int get_sound_object_state(sound_object_t);
     float get_sound_object_time(sound_object_t);
+
+    // sounds are not positional until placed; with many sounds playing, higher priorities are kept audible first
+    void set_sound_object_position(sound_object_t, const vector3_t&);
+    void set_sound_object_priority(sound_object_t, int);
+    void set_sound_object_volume(sound_object_t, float);
 }
 
 #endif
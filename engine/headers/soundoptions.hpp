@@ -27,8 +27,15 @@ namespace cursedearth
     {
         static const size_t samples_in_block = 1024;
         static const size_t block_count = 16;
+        static const size_t low_latency_block_count = 2;
         static const size_t max_sample_size = 64;
         static const size_t max_block_size = max_sample_size * samples_in_block;
+        static const size_t decode_thread_count = 2;
+        static const size_t max_bank_sample_milliseconds = 2000; // longer sounds are streamed
+        static const size_t voice_count = 32;
+        static constexpr float reference_distance = 5.0f; // full volume up to this distance
+        static constexpr float max_distance = 100.0f; // silent beyond
+        static constexpr float audible_gain = 0.001f; // -60 dB, quieter voices are virtualized
     };
 }
 
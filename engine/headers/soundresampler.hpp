@@ -0,0 +1,67 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_SOUNDRESAMPLER_HPP
+#define CE_SOUNDRESAMPLER_HPP
+
+#include "untransferable.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace cursedearth
+{
+    /*
+     *  Streaming polyphase windowed-sinc resampler.
+     *  Works on interleaved float frames; the conversion ratio is reduced
+     *  to output_rate/input_rate = up/down and every output frame is
+     *  a dot product of one filter phase with the input history.
+    */
+    class sound_resampler_t final: untransferable_t
+    {
+    public:
+        sound_resampler_t(size_t input_rate, size_t output_rate, size_t channel_count);
+
+        size_t channel_count() const { return m_channel_count; }
+
+        // number of input frames required to produce the given number of output frames
+        size_t input_frame_count(size_t output_frame_count) const;
+
+        void push(const float* input, size_t frame_count);
+        size_t pull(float* output, size_t frame_count);
+        void reset();
+
+    private:
+        static const size_t max_phase_count = 1024;
+        static const size_t zero_crossing_count = 16;
+
+        const size_t m_channel_count;
+        size_t m_up;
+        size_t m_down;
+        size_t m_phase_count;
+        size_t m_tap_count;
+        std::vector<float> m_filters;
+        std::vector<float> m_frames;
+        size_t m_position;
+        size_t m_phase;
+    };
+}
+
+#endif
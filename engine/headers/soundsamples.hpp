@@ -0,0 +1,55 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_SOUNDSAMPLES_HPP
+#define CE_SOUNDSAMPLES_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cursedearth
+{
+    /*
+     *  Block kernels used by the sound decoders to turn whole decoded
+     *  frames into interleaved signed 16-bit host order samples.
+     *  SSE2 versions are used for mono and stereo when available,
+     *  other layouts and the tails fall back to scalar code.
+    */
+
+    // TPDF dither generator, one xorshift state per vector lane
+    struct sound_dither_t
+    {
+        uint32_t state[4] = { 0x9e3779b9u, 0x7f4a7c15u, 0x85ebca6bu, 0xc2b2ae35u };
+    };
+
+    // planar floats in [-1, 1] (Vorbis)
+    void interleave_float_to_s16(int16_t* output, const float* const* planes, size_t channel_count, size_t frame_count, sound_dither_t&);
+
+    // planar fixed point numbers, 1.0 == 1 << fraction_bits (MPEG)
+    void interleave_fixed_to_s16(int16_t* output, const int32_t* const* planes, size_t channel_count, size_t frame_count, unsigned int fraction_bits, sound_dither_t&);
+
+    // planar integers of the given width, rescaled to 16 bits without dither (FLAC)
+    void interleave_integer_to_s16(int16_t* output, const int32_t* const* planes, size_t channel_count, size_t frame_count, unsigned int bits_per_sample);
+
+    // splits rounds of 4 bytes per channel into per channel 4-bit codes, low nibble first (IMA ADPCM)
+    void expand_nibbles(uint8_t* const* codes, const uint8_t* data, size_t channel_count, size_t group_count);
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_SOUNDSCHEDULER_HPP
+#define CE_SOUNDSCHEDULER_HPP
+
+#include "makeunique.hpp"
+#include "singleton.hpp"
+#include "conditionvariable.hpp"
+
+#include <list>
+#include <functional>
+#include <condition_variable>
+
+namespace cursedearth
+{
+    class sound_instance_t;
+
+    /**
+     * @brief decodes all sound instances on a small fixed set of threads
+     *        playing instances are refilled by deadline: the buffer that would starve first goes first
+     *        paused and stopped instances are parked and cost nothing
+     *        all functions are thread-safe
+     */
+    class sound_scheduler_t final: public singleton_t<sound_scheduler_t>
+    {
+        struct entry_t
+        {
+            sound_instance_t* instance;
+            bool busy; // being processed by a worker
+            bool dirty; // state changed, must be processed even if parked
+        };
+
+    public:
+        sound_scheduler_t();
+        ~sound_scheduler_t();
+
+        void add(sound_instance_t*);
+        void remove(sound_instance_t*);
+
+        // call after an instance changed its state
+        void notify(sound_instance_t*);
+
+        // runs the task on a decode thread once no instance needs a refill
+        void post(std::function<void ()>);
+
+    private:
+        entry_t* pick(bool& throttled);
+        void execute();
+
+    private:
+        std::mutex m_mutex;
+        condition_variable_ptr_t m_idle;
+        std::condition_variable_any m_released;
+        std::list<entry_t> m_entries;
+        std::list<std::function<void ()>> m_tasks;
+        std::vector<thread_ptr_t> m_threads;
+    };
+
+    typedef std::unique_ptr<sound_scheduler_t> sound_scheduler_ptr_t;
+
+    inline sound_scheduler_ptr_t make_sound_scheduler()
+    {
+        return make_unique<sound_scheduler_t>();
+    }
+}
+
+#endif
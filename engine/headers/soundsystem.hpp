@@ -26,25 +26,48 @@
 #include "soundbuffer.hpp"
 #include "sounddevice.hpp"
 
+#include <chrono>
+
 namespace cursedearth
 {
+    struct sound_statistics_t
+    {
+        size_t mixed_block_count;
+        size_t written_block_count;
+        size_t starved_buffer_count; // buffers that ran dry while awake, summed over mixed blocks
+        size_t underrun_count;
+        size_t suspend_count;
+        double mix_time; // average time to mix one block in seconds
+    };
+
     class sound_system_t final: public singleton_t<sound_system_t>
     {
     public:
         sound_system_t();
+        ~sound_system_t();
 
         const sound_format_t& format() const { return m_format; }
 
-        sound_block_ptr_t map();
-        void unmap(const sound_block_ptr_t&);
+        sound_block_t* map();
+        void unmap(sound_block_t*);
+
+        // called by the mixer for every block it has mixed
+        void account_mix(std::chrono::steady_clock::duration, size_t starved_buffer_count);
+
+        sound_statistics_t statistics() const;
 
     private:
         void execute();
 
     private:
         const sound_format_t m_format;
+        const bool m_low_latency;
         sound_buffer_ptr_t m_buffer;
         sound_device_ptr_t m_device;
+        std::atomic<size_t> m_mixed_block_count;
+        std::atomic<size_t> m_written_block_count;
+        std::atomic<size_t> m_starved_buffer_count;
+        std::atomic<int64_t> m_mix_time;
         thread_t m_thread;
     };
 
@@ -0,0 +1,95 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_SOUNDVOICE_HPP
+#define CE_SOUNDVOICE_HPP
+
+#include "untransferable.hpp"
+#include "soundinstance.hpp"
+
+#include <vector>
+
+namespace cursedearth
+{
+    /**
+     * @brief fully decoded sound, already converted to the native format as floats
+     *        shared by all voices playing it
+     */
+    class sound_sample_t final: untransferable_t
+    {
+    public:
+        sound_sample_t(std::vector<float>&& values, size_t channel_count):
+            m_values(std::move(values)),
+            m_frame_count(m_values.size() / channel_count)
+        {
+        }
+
+        const float* data() const { return m_values.data(); }
+        size_t frame_count() const { return m_frame_count; }
+
+    private:
+        const std::vector<float> m_values;
+        const size_t m_frame_count;
+    };
+
+    typedef std::shared_ptr<const sound_sample_t> sound_sample_ptr_t;
+
+    /**
+     * @brief plays a sound sample straight from memory: no decoder, no buffer;
+     *        the mixer reads it only while it is playing
+     */
+    class sound_voice_t final: public std::enable_shared_from_this<sound_voice_t>, untransferable_t
+    {
+    public:
+        explicit sound_voice_t(const sound_sample_ptr_t&);
+
+        sound_instance_state_t state() const { return m_state; }
+        void change_state(sound_instance_state_t);
+
+        float time() const { return m_position * m_seconds_per_frame; }
+
+        const sound_emitter_ptr_t& emitter() const { return m_emitter; }
+
+        void advance(float) {}
+
+    private:
+        friend class sound_mixer_t;
+
+        // called by the mixer only: adds up to frame_count frames to output, returns false when the end is reached
+        bool mix(float* output, size_t frame_count, size_t channel_count, const float* gains);
+
+        // called by the mixer only: advances as mix does, for virtual voices
+        bool skip(size_t frame_count);
+
+        bool advance_position(size_t position, size_t count);
+
+    private:
+        const sound_sample_ptr_t m_sample;
+        const sound_emitter_ptr_t m_emitter;
+        const float m_seconds_per_frame;
+        std::atomic<sound_instance_state_t> m_state;
+        std::atomic<size_t> m_position;
+        bool m_active = false; // listed by the mixer, guarded by its mutex
+    };
+
+    typedef std::shared_ptr<sound_voice_t> sound_voice_ptr_t;
+}
+
+#endif
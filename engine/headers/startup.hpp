@@ -0,0 +1,91 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_STARTUP_HPP
+#define CE_STARTUP_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "untransferable.hpp"
+
+namespace cursedearth
+{
+    /**
+     * @brief startup phases with dependencies
+     *        a phase starts as soon as all of its dependencies are done: main thread phases run on the caller,
+     *        the rest on their own threads, so independent subsystems initialize in parallel
+     *        wall time of every phase is logged when the graph is done
+     */
+    class startup_graph_t final: untransferable_t
+    {
+        typedef std::function<void ()> task_t;
+        typedef std::chrono::steady_clock steady_clock_t;
+
+    public:
+        enum class affinity_t
+        {
+            main_thread,
+            any_thread
+        };
+
+        // dependencies must be added before; names are used for the trace only
+        void add(const std::string& name, const std::vector<std::string>& dependencies, affinity_t, const task_t&);
+
+        // rethrows the first error once every started phase is finished
+        void run();
+
+    private:
+        enum class state_t
+        {
+            pending,
+            running,
+            done
+        };
+
+        struct phase_t
+        {
+            std::string name;
+            std::vector<size_t> dependencies;
+            affinity_t affinity;
+            task_t task;
+            state_t state;
+            steady_clock_t::time_point start;
+            steady_clock_t::time_point finish;
+        };
+
+        bool ready(const phase_t&) const;
+        void execute(phase_t&);
+        void trace(steady_clock_t::time_point) const;
+
+    private:
+        std::vector<phase_t> m_phases;
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+        std::exception_ptr m_error;
+    };
+}
+
+#endif
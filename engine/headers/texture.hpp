@@ -49,11 +49,27 @@ namespace cursedearth
     bool ce_texture_is_equal(const ce_texture* texture, const ce_texture* other);
 
     void ce_texture_replace(ce_texture* texture, ce_mmpfile* mmpfile);
+
+    // GL capabilities are per thread, so the ones needed off the render thread are
+    // copied once by the render system on initialization
+    void ce_texture_query_capabilities(void);
+
+    // do the CPU conversions ce_texture_replace would do, so that replacing is upload only;
+    // thread-safe once the render system is initialized
+    void ce_texture_prepare(ce_mmpfile* mmpfile);
+
+    // single-channel 8-bit plane (e.g. a video Y, Cb or Cr plane), rows tightly packed;
+    // storage is reallocated only when the size changes, otherwise updated in place
+    void ce_texture_replace_plane(ce_texture* texture, unsigned int width, unsigned int height, const void* data);
     void ce_texture_wrap(ce_texture* texture, ce_texture_wrap_mode mode);
 
     void ce_texture_bind(ce_texture* texture);
     void ce_texture_unbind(ce_texture* texture);
 
+    // multitexturing: unit is relative to GL_TEXTURE0, active unit is reset to 0 afterwards
+    void ce_texture_bind_unit(ce_texture* texture, unsigned int unit);
+    void ce_texture_unbind_unit(ce_texture* texture, unsigned int unit);
+
     inline ce_texture* ce_texture_add_ref(ce_texture* texture)
     {
         ++texture->ref_count;
@@ -22,6 +22,7 @@
 #define CE_TEXTUREMANAGER_HPP
 
 #include <string>
+#include <vector>
 
 #include "string.hpp"
 #include "vector.hpp"
@@ -32,7 +33,9 @@ namespace cursedearth
 {
     extern struct ce_texture_manager {
         ce_vector* res_files;
+        ce_vector* res_indices; // content indices of the archives above, only if archive indexing is enabled
         ce_vector* textures;
+        struct ce_texture_preloader* preloader;
     }* ce_texture_manager;
 
     void ce_texture_manager_init();
@@ -41,10 +44,10 @@ namespace cursedearth
     // search mmp file only in cache directory; thread-safe
     ce_mmpfile* ce_texture_manager_open_mmpfile_from_cache(const std::string& name);
 
-    // search mmp file only in resources; not thread-safe
+    // search mmp file only in resources; thread-safe, res files are not changed after init
     ce_mmpfile* ce_texture_manager_open_mmpfile_from_resources(const std::string& name);
 
-    // search mmp file in both cache directory and resources
+    // search mmp file in both cache directory and resources; thread-safe
     ce_mmpfile* ce_texture_manager_open_mmpfile(const std::string& name);
 
     // save mmp file in cache directory; thread-safe
@@ -55,6 +58,10 @@ namespace cursedearth
 
     // add new texture, not thread-safe
     void ce_texture_manager_put(ce_texture* texture);
+
+    // decode and prepare mmp files on the thread pool, textures are created on the render thread
+    // as soon as they are ready or when they are first acquired; thread-safe
+    void ce_texture_manager_preload(const std::vector<std::string>& names);
 }
 
 #endif
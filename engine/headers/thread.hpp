@@ -37,6 +37,12 @@ namespace cursedearth
 
     void interruption_point();
 
+    /**
+     * @brief hint the scheduler that the calling thread is latency sensitive;
+     *        returns false if the system refused to raise its priority
+     */
+    bool promote_thread_priority();
+
     /**
      * @brief thread with interruption support
      */
@@ -24,6 +24,7 @@
 #include "conditionvariable.hpp"
 
 #include <atomic>
+#include <mutex>
 
 namespace cursedearth
 {
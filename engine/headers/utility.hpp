@@ -40,8 +40,15 @@ namespace cursedearth
     extern const float g_deg2rad;
     extern const float g_rad2deg;
 
+    extern const uint64_t g_fnv1a64_basis;
+
     float relative_difference(float a, float b);
 
+    /**
+     * @brief 64-bit FNV-1a hash; pass previous result as a basis to hash data in chunks
+     */
+    uint64_t fnv1a64(const void* data, size_t size, uint64_t basis = g_fnv1a64_basis);
+
     template <typename T, typename U>
     inline T clamp(T value, U min, U max)
     {
@@ -23,43 +23,47 @@
 
 #include "ringbuffer.hpp"
 #include "videooptions.hpp"
-#include "mmpfile.hpp"
+#include "videoframe.hpp"
+
+#include <vector>
 
 namespace cursedearth
 {
     class video_buffer_t final: untransferable_t
     {
     public:
-        video_buffer_t():
-            m_buffer(video_options_t::frame_count)
+        explicit video_buffer_t(size_t frame_count):
+            m_capacity(frame_count),
+            m_buffer(frame_count)
         {
         }
 
+        size_t capacity() const { return m_capacity; }
         size_t read_available() const { return m_buffer.read_available(); }
 
-        void push(const mmpfile_ptr_t& frame) { m_buffer.push(frame); }
+        void push(const video_frame_ptr_t& frame) { m_buffer.push(frame); }
 
-        bool try_pop(mmpfile_ptr_t& frame)
+        bool try_pop(video_frame_ptr_t& frame)
         {
             return m_buffer.pop(frame, false);
         }
 
-        mmpfile_ptr_t acquire_from_cache(size_t width, size_t height)
+        video_frame_ptr_t acquire_from_cache(unsigned int width, unsigned int height)
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             std::ignore = lock;
 
             if (m_frames.empty()) {
-                return mmpfile_ptr_t(ce_mmpfile_new(width, height, 1, CE_MMPFILE_FORMAT_YCBCR, 0), mmpfile_dtor_t());
+                return std::make_shared<video_frame_t>(width, height);
             }
 
-            mmpfile_ptr_t frame = m_frames.back();
+            video_frame_ptr_t frame = m_frames.back();
             m_frames.pop_back();
 
-            return std::move(frame);
+            return frame;
         }
 
-        void release_to_cache(const mmpfile_ptr_t& frame)
+        void release_to_cache(const video_frame_ptr_t& frame)
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             std::ignore = lock;
@@ -67,16 +71,17 @@ namespace cursedearth
         }
 
     private:
+        const size_t m_capacity;
         std::mutex m_mutex;
-        std::vector<mmpfile_ptr_t> m_frames;
-        ring_buffer_t<mmpfile_ptr_t> m_buffer;
+        std::vector<video_frame_ptr_t> m_frames;
+        ring_buffer_t<video_frame_ptr_t> m_buffer;
     };
 
     typedef std::shared_ptr<video_buffer_t> video_buffer_ptr_t;
 
-    inline video_buffer_ptr_t make_video_buffer()
+    inline video_buffer_ptr_t make_video_buffer(size_t frame_count = video_options_t::frame_count)
     {
-        return std::make_shared<video_buffer_t>();
+        return std::make_shared<video_buffer_t>(frame_count);
     }
 }
 
@@ -0,0 +1,64 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CE_VIDEOFRAME_HPP
+#define CE_VIDEOFRAME_HPP
+
+#include "untransferable.hpp"
+#include "makeunique.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace cursedearth
+{
+    /**
+     * @brief decoded YCbCr 4:2:0 picture kept as three separate planes,
+     *        so that each one can be uploaded or converted without repacking
+     */
+    class video_frame_t final: untransferable_t
+    {
+    public:
+        struct plane_t
+        {
+            unsigned int width, height; // rows are tightly packed
+            std::unique_ptr<uint8_t[]> data;
+        };
+
+        video_frame_t(unsigned int width, unsigned int height)
+        {
+            for (size_t i = 0; i < 3; ++i) {
+                planes[i].width = 0 == i ? width : width / 2;
+                planes[i].height = 0 == i ? height : height / 2;
+                planes[i].data = make_unique<uint8_t[]>(planes[i].width * planes[i].height);
+            }
+        }
+
+        unsigned int width() const { return planes[0].width; }
+        unsigned int height() const { return planes[0].height; }
+
+        plane_t planes[3];
+        size_t index = 0;
+    };
+
+    typedef std::shared_ptr<video_frame_t> video_frame_ptr_t;
+}
+
+#endif
@@ -54,6 +54,7 @@ namespace cursedearth
 
     private:
         void do_advance();
+        void upload(const video_frame_t&);
         void execute();
 
     private:
@@ -61,10 +62,12 @@ namespace cursedearth
         ce_video_resource* m_resource;
         state_t m_state = state_t::stopped;
         int m_frame = -1;
-        float m_play_time = 0.0f;
+        std::atomic<float> m_play_time;
+        size_t m_dropped_frame_count = 0;
         ce_texture* m_texture;
+        ce_texture* m_planes[3]; // Y, Cb, Cr; used with the shader
         ce_material* m_material;
-        ce_mmpfile* m_rgba_frame;
+        ce_mmpfile* m_rgba_frame; // used without the shader
         video_buffer_ptr_t m_buffer;
         thread_t m_thread;
     };
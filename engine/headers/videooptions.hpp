@@ -26,6 +26,7 @@ namespace cursedearth
     struct video_options_t
     {
         static const size_t frame_count = 32;
+        static const size_t max_decode_thread_count = 4;
     };
 }
 
@@ -41,6 +41,8 @@ namespace cursedearth
         unsigned int width, height;
         float fps, time;
         size_t frame_index, frame_count;
+        size_t ycbcr_frame_index; // index of the frame in ycbcr; lags behind frame_index with frame-threaded decoders
+        bool hurry_up; // set by the player when decoding falls behind; decoders may trade quality for speed
         ycbcr_t ycbcr;
         ce_mem_file* mem_file;
         ce_video_resource_vtable vtable;
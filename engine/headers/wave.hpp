@@ -37,6 +37,10 @@ namespace cursedearth
         CE_WAVE_FORMAT_IMA_ADPCM = 0x11,
     };
 
+    enum {
+        CE_WAVE_IMA_ADPCM_MAX_CHANNEL_COUNT = 8
+    };
+
     typedef struct {
         uint8_t four_cc[4];
         uint32_t size;
@@ -86,7 +90,8 @@ namespace cursedearth
 
     bool ce_wave_header_read(ce_wave_header* wave_header, ce_mem_file* mem_file);
 
-    void ce_wave_ima_adpcm_decode(void* dst, const void* src, const ce_wave_header* wave_header);
+    // codes is a scratch buffer of ce_wave_ima_adpcm_codes_storage_size bytes
+    void ce_wave_ima_adpcm_decode(void* dst, const void* src, void* codes, const ce_wave_header* wave_header);
 
     inline size_t ce_wave_ima_adpcm_samples_storage_size(const ce_wave_header* wave_header)
     {
@@ -97,6 +102,11 @@ namespace cursedearth
     {
         return wave_header->format.block_align;
     }
+
+    inline size_t ce_wave_ima_adpcm_codes_storage_size(const ce_wave_header* wave_header)
+    {
+        return (wave_header->format.extra.ima_adpcm.samples_per_block - 1) * wave_header->format.channel_count;
+    }
 }
 
 #endif
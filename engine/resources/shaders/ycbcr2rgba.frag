@@ -1,11 +1,12 @@
-uniform sampler2D texture;
+uniform sampler2D y_texture;
+uniform sampler2D cb_texture;
+uniform sampler2D cr_texture;
 
 void main()
 {
-    vec4 ycbcr = texture2D(texture, gl_TexCoord[0].st);
-    float y = 1.1643 * (ycbcr[0] - 0.0625);
-    float cb = ycbcr[1] - 0.5;
-    float cr = ycbcr[2] - 0.5;
+    float y = 1.1643 * (texture2D(y_texture, gl_TexCoord[0].st).r - 0.0625);
+    float cb = texture2D(cb_texture, gl_TexCoord[0].st).r - 0.5;
+    float cr = texture2D(cr_texture, gl_TexCoord[0].st).r - 0.5;
     gl_FragColor.r = y + 1.5958 * cr;
     gl_FragColor.g = y - 0.39173 * cb - 0.81290 * cr;
     gl_FragColor.b = y + 2.017 * cb;
@@ -28,13 +28,12 @@ namespace cursedearth
     {
         ce_anmfile* anmfile = (ce_anmfile*)ce_alloc(sizeof(ce_anmfile));
         anmfile->name = ce_string_dup(res_file->name);
-        anmfile->size = ce_res_file_node_size(res_file, index);
-        anmfile->data = ce_res_file_node_data(res_file, index);
+        anmfile->block = ce_anm_store_acquire(res_file, index);
 
         union {
-            float* f;
-            uint32_t* u32;
-        } ptr = { (float*)anmfile->data };
+            const float* f;
+            const uint32_t* u32;
+        } ptr = { (const float*)anmfile->block->data };
 
         anmfile->rotation_frame_count = le2cpu(*ptr.u32++);
         anmfile->rotations = ptr.f;
@@ -54,7 +53,7 @@ namespace cursedearth
     void ce_anmfile_close(ce_anmfile* anmfile)
     {
         if (NULL != anmfile) {
-            ce_free(anmfile->data, anmfile->size);
+            ce_anm_store_release(anmfile->block);
             ce_string_del(anmfile->name);
             ce_free(anmfile, sizeof(ce_anmfile));
         }
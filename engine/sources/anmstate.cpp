@@ -19,15 +19,66 @@
  */
 
 #include <cassert>
+#include <cctype>
 #include <cmath>
+#include <algorithm>
 
 #include <boost/algorithm/string.hpp>
 
 #include "alloc.hpp"
+#include "utility.hpp"
 #include "anmstate.hpp"
 
 namespace cursedearth
 {
+    namespace
+    {
+        uint64_t ce_anm_index_hash(const char* name)
+        {
+            uint64_t hash = g_fnv1a64_basis;
+            for (; '\0' != *name; ++name) {
+                const char ch = tolower(static_cast<unsigned char>(*name));
+                hash = fnv1a64(&ch, 1, hash);
+            }
+            return hash;
+        }
+
+        bool ce_anm_index_less(const std::pair<uint64_t, ce_anmfile*>& a, const std::pair<uint64_t, ce_anmfile*>& b)
+        {
+            return a.first < b.first;
+        }
+    }
+
+    ce_anm_index* ce_anm_index_new(const ce_vector* anmfiles)
+    {
+        ce_anm_index* anm_index = new ce_anm_index;
+        anm_index->entries.reserve(anmfiles->count);
+        for (size_t i = 0; i < anmfiles->count; ++i) {
+            ce_anmfile* anmfile = (ce_anmfile*)anmfiles->items[i];
+            anm_index->entries.push_back(std::make_pair(ce_anm_index_hash(anmfile->name->str), anmfile));
+        }
+        // stable: the first of equally named animations wins, as the linear search did
+        std::stable_sort(anm_index->entries.begin(), anm_index->entries.end(), ce_anm_index_less);
+        return anm_index;
+    }
+
+    void ce_anm_index_del(ce_anm_index* anm_index)
+    {
+        delete anm_index;
+    }
+
+    ce_anmfile* ce_anm_index_find(const ce_anm_index* anm_index, const std::string& name)
+    {
+        const std::pair<uint64_t, ce_anmfile*> key(ce_anm_index_hash(name.c_str()), NULL);
+        auto range = std::equal_range(anm_index->entries.begin(), anm_index->entries.end(), key, ce_anm_index_less);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (boost::algorithm::iequals(name, it->second->name->str)) {
+                return it->second;
+            }
+        }
+        return NULL;
+    }
+
     ce_anmstate* ce_anmstate_new()
     {
         ce_anmstate* anmstate = (ce_anmstate*)ce_alloc(sizeof(ce_anmstate));
@@ -58,22 +109,20 @@ namespace cursedearth
         }
     }
 
-    bool ce_anmstate_play_animation(ce_anmstate* anmstate, ce_vector* anmfiles, const std::string& name)
+    bool ce_anmstate_play_animation(ce_anmstate* anmstate, const ce_anm_index* anm_index, const std::string& name)
     {
-        for (size_t i = 0; i < anmfiles->count; ++i) {
-            ce_anmfile* anmfile = (ce_anmfile*)anmfiles->items[i];
-            if (boost::algorithm::iequals(name, anmfile->name->str)) {
-                assert(anmfile->rotation_frame_count == anmfile->translation_frame_count);
-                anmstate->anmfile = anmfile;
-                anmstate->frame_count = anmfile->rotation_frame_count;
-                anmstate->prev_frame = 0.0f;
-                anmstate->next_frame = 0.0f;
-                anmstate->frame = 0.0f;
-                anmstate->coef = 0.0f;
-                return true;
-            }
+        ce_anmfile* anmfile = ce_anm_index_find(anm_index, name);
+        if (NULL == anmfile) {
+            return false;
         }
-        return false;
+        assert(anmfile->rotation_frame_count == anmfile->translation_frame_count);
+        anmstate->anmfile = anmfile;
+        anmstate->frame_count = anmfile->rotation_frame_count;
+        anmstate->prev_frame = 0.0f;
+        anmstate->next_frame = 0.0f;
+        anmstate->frame = 0.0f;
+        anmstate->coef = 0.0f;
+        return true;
     }
 
     void ce_anmstate_stop_animation(ce_anmstate* anmstate)
@@ -0,0 +1,90 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstring>
+#include <tuple>
+#include <mutex>
+#include <unordered_map>
+
+#include "alloc.hpp"
+#include "utility.hpp"
+#include "anmstore.hpp"
+
+namespace cursedearth
+{
+    namespace
+    {
+        std::mutex g_mutex;
+        std::unordered_multimap<uint64_t, ce_anm_block*> g_blocks; // by content hash
+    }
+
+    ce_anm_block* ce_anm_store_acquire(ce_res_file* res_file, size_t index)
+    {
+        const size_t size = ce_res_file_node_size(res_file, index);
+        void* data = ce_alloc(size);
+        ce_res_file_node_read(res_file, index, data);
+
+        const uint64_t hash = fnv1a64(data, size);
+
+        std::lock_guard<std::mutex> lock(g_mutex);
+        std::ignore = lock;
+
+        auto range = g_blocks.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            ce_anm_block* block = it->second;
+            if (size == block->size && 0 == memcmp(data, block->data, size)) {
+                ++block->ref_count;
+                ce_free(data, size);
+                return block;
+            }
+        }
+
+        ce_anm_block* block = (ce_anm_block*)ce_alloc(sizeof(ce_anm_block));
+        block->hash = hash;
+        block->size = size;
+        block->ref_count = 1;
+        block->data = data;
+
+        g_blocks.insert(std::make_pair(hash, block));
+        return block;
+    }
+
+    void ce_anm_store_release(ce_anm_block* block)
+    {
+        if (NULL != block) {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            std::ignore = lock;
+
+            assert(block->ref_count > 0);
+            if (0 == --block->ref_count) {
+                auto range = g_blocks.equal_range(block->hash);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (block == it->second) {
+                        g_blocks.erase(it);
+                        break;
+                    }
+                }
+                ce_free(block->data, block->size);
+                ce_free(block, sizeof(ce_anm_block));
+            }
+        }
+    }
+}
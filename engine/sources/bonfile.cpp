@@ -27,15 +27,15 @@ namespace cursedearth
     {
         size_t index = ce_res_file_node_index(res_file, name);
         ce_bonfile* bonfile = (ce_bonfile*)ce_alloc(sizeof(ce_bonfile));
-        bonfile->size = ce_res_file_node_size(res_file, index);
-        bonfile->bone = (float*)ce_res_file_node_data(res_file, index);
+        bonfile->block = ce_anm_store_acquire(res_file, index);
+        bonfile->bone = (const float*)bonfile->block->data;
         return bonfile;
     }
 
     void ce_bonfile_close(ce_bonfile* bonfile)
     {
         if (NULL != bonfile) {
-            ce_free(bonfile->bone, bonfile->size);
+            ce_anm_store_release(bonfile->block);
             ce_free(bonfile, sizeof(ce_bonfile));
         }
     }
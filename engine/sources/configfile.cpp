@@ -21,7 +21,6 @@
 #include <cstdio>
 #include <cstring>
 
-#include "alloc.hpp"
 #include "logging.hpp"
 #include "configfile.hpp"
 
@@ -76,8 +75,7 @@ namespace cursedearth
         };
 
         char line[MAX_LINE_SIZE], temp1[MAX_LINE_SIZE], temp2[MAX_LINE_SIZE];
-        ce_config_section* section = NULL;
-        ce_config_option* option = NULL;
+        bool in_section = false;
         bool was_continuation_character = false;
 
         for (int line_number = 1; NULL != fgets(temp1, MAX_LINE_SIZE, file); ++line_number) {
@@ -115,12 +113,11 @@ namespace cursedearth
 
                 ce_strmid(temp1, line, 1, line_length - 2);
 
-                section = (ce_config_section*)ce_alloc(sizeof(ce_config_section));
-                section->name = ce_string_new_str(ce_strtrim(temp2, temp1));
-                section->options = ce_vector_new();
-                ce_vector_push_back(config_file->sections, section);
+                ce_strtrim(temp2, temp1);
+                ce_key_table_add_section(&config_file->key_table, temp2, strlen(temp2));
+                in_section = true;
             } else {
-                if (NULL == section) {
+                if (!in_section) {
                     // skip comments on top of the file
                     continue;
                 }
@@ -148,25 +145,26 @@ namespace cursedearth
                 }
 
                 if (was_continuation_character) {
-                    ce_string_append(option->value, line);
+                    // value of the last option is at the tail of the pool
+                    config_file->values.pop_back();
+                    config_file->values.insert(config_file->values.end(), line, line + strlen(line));
+                    config_file->values.push_back('\0');
                 } else {
-                    option = (ce_config_option*)ce_alloc(sizeof(ce_config_option));
-                    option->name = ce_string_new();
-                    option->value = ce_string_new();
-                    ce_vector_push_back(section->options, option);
-
                     ce_strleft(temp1, line, eq - line);
-                    ce_string_assign(option->name, ce_strtrim(temp2, temp1));
+                    ce_strtrim(temp2, temp1);
+                    ce_key_table_add_option(&config_file->key_table, temp2, strlen(temp2));
 
-                    if (ce_string_empty(option->name)) {
+                    if ('\0' == temp2[0]) {
                         ce_logging_warning("config file: %s:%d: missing option name: `%s'", path, line_number, line);
                     }
 
                     ce_strright(temp1, line, line_length - (eq - line) - 1);
-                    ce_string_assign(option->value, ce_strtrim(temp2, temp1));
+                    ce_strtrim(temp2, temp1);
+                    config_file->value_offsets.push_back(config_file->values.size());
+                    config_file->values.insert(config_file->values.end(), temp2, temp2 + strlen(temp2) + 1);
                 }
 
-                if (ce_string_empty(option->value)) {
+                if ('\0' == config_file->values[config_file->value_offsets.back()]) {
                     ce_logging_warning("config file: %s:%d: missing option value: `%s'", path, line_number, line);
                 }
 
@@ -185,8 +183,7 @@ namespace cursedearth
             return NULL;
         }
 
-        ce_config_file* config_file = (ce_config_file*)ce_alloc(sizeof(ce_config_file));
-        config_file->sections = ce_vector_new();
+        ce_config_file* config_file = new ce_config_file;
 
         if (!ce_config_file_parse(config_file, path.string().c_str(), file)) {
             ce_logging_error("config file: failed to parse `%s'", path.string().c_str());
@@ -201,48 +198,24 @@ namespace cursedearth
 
     void ce_config_file_close(ce_config_file* config_file)
     {
-        if (NULL != config_file) {
-            for (size_t i = 0; i < config_file->sections->count; ++i) {
-                ce_config_section* section = (ce_config_section*)config_file->sections->items[i];
-                for (size_t j = 0; j < section->options->count; ++j) {
-                    ce_config_option* option = (ce_config_option*)section->options->items[j];
-                    ce_string_del(option->value);
-                    ce_string_del(option->name);
-                    ce_free(option, sizeof(ce_config_option));
-                }
-                ce_vector_del(section->options);
-                ce_string_del(section->name);
-                ce_free(section, sizeof(ce_config_section));
-            }
-            ce_vector_del(config_file->sections);
-            ce_free(config_file, sizeof(ce_config_file));
-        }
+        delete config_file;
     }
 
-    size_t ce_config_file_section_index(ce_config_file* config_file, const char* section_name)
+    size_t ce_config_file_section_index(const ce_config_file* config_file, const char* section_name)
     {
-        for (size_t i = 0; i < config_file->sections->count; ++i) {
-            ce_config_section* section = (ce_config_section*)config_file->sections->items[i];
-            if (0 == strcmp(section_name, section->name->str)) {
-                return i;
-            }
-        }
-        return config_file->sections->count;
+        return ce_key_table_section_index(&config_file->key_table, section_name);
     }
 
-    size_t ce_config_file_option_index(ce_config_file* config_file, size_t section_index, const char* option_name)
+    size_t ce_config_file_option_index(const ce_config_file* config_file, size_t section_index, const char* option_name)
     {
-        ce_config_section* section = (ce_config_section*)config_file->sections->items[section_index];
-        for (size_t i = 0; i < section->options->count; ++i) {
-            ce_config_option* option = (ce_config_option*)section->options->items[i];
-            if (0 == strcmp(option_name, option->name->str)) {
-                return i;
-            }
+        uint32_t index = ce_key_table_option_index(&config_file->key_table, section_index, option_name);
+        if (CE_KEY_TABLE_NPOS == index) {
+            return ce_config_file_option_count(config_file, section_index);
         }
-        return section->options->count;
+        return index - config_file->key_table.sections[section_index].first_option;
     }
 
-    const char* ce_config_file_find(ce_config_file* config_file, const char* section_name, const char* option_name)
+    const char* ce_config_file_find(const ce_config_file* config_file, const char* section_name, const char* option_name)
     {
         size_t section_index = ce_config_file_section_index(config_file, section_name);
         if (section_index != ce_config_file_section_count(config_file)) {
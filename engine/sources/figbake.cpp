@@ -0,0 +1,390 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "alloc.hpp"
+#include "utility.hpp"
+#include "figbake.hpp"
+
+namespace cursedearth
+{
+    /*
+     *  Vertices and normals are stored in blocks of four (see doc/formats/fig.txt):
+     *  each component of each complection parameter keeps four consecutive lanes,
+     *  one per vertex, so a whole block is blended at once with 4-wide vectors.
+     */
+
+#ifdef __SSE__
+    inline __m128 ce_figbake_lerp(__m128 a, __m128 b, __m128 coef)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), coef));
+    }
+
+    // same operation order as ce_figfile_value_fig8, results are bit-exact
+    inline __m128 ce_figbake_trilerp(const float* params, __m128 dexterity, __m128 strength, __m128 height)
+    {
+        __m128 temp1 = ce_figbake_lerp(_mm_loadu_ps(params + 0), _mm_loadu_ps(params + 4), strength);
+        __m128 temp2 = ce_figbake_lerp(_mm_loadu_ps(params + 8), _mm_loadu_ps(params + 12), strength);
+        __m128 value = ce_figbake_lerp(temp1, temp2, dexterity);
+        temp1 = ce_figbake_lerp(_mm_loadu_ps(params + 16), _mm_loadu_ps(params + 20), strength);
+        temp2 = ce_figbake_lerp(_mm_loadu_ps(params + 24), _mm_loadu_ps(params + 28), strength);
+        temp1 = ce_figbake_lerp(temp1, temp2, dexterity);
+        return ce_figbake_lerp(value, temp1, height);
+    }
+#endif
+
+    void ce_figbake_eval_vertices(float* array, const ce_figfile* figfile, const complection_t* complection)
+    {
+        const size_t block_size = 3 * figfile->value_count * 4;
+        const size_t component_size = figfile->value_count * 4;
+
+        for (int block = 0; block < figfile->vertex_count; ++block) {
+            const float* params = figfile->vertices + block_size * block;
+            float* vertices = array + 3 * 4 * block;
+
+            if (1 == figfile->value_count) {
+                for (size_t lane = 0; lane < 4; ++lane) {
+                    vertices[3 * lane + 0] = params[0 * component_size + lane];
+                    vertices[3 * lane + 1] = params[1 * component_size + lane];
+                    vertices[3 * lane + 2] = params[2 * component_size + lane];
+                }
+                continue;
+            }
+
+#ifdef __SSE__
+            const __m128 dexterity = _mm_set1_ps(complection->dexterity);
+            const __m128 strength = _mm_set1_ps(complection->strength);
+            const __m128 height = _mm_set1_ps(complection->height);
+
+            float values[3][4];
+            for (size_t i = 0; i < 3; ++i) {
+                _mm_storeu_ps(values[i], ce_figbake_trilerp(params + i * component_size, dexterity, strength, height));
+            }
+
+            for (size_t lane = 0; lane < 4; ++lane) {
+                vertices[3 * lane + 0] = values[0][lane];
+                vertices[3 * lane + 1] = values[1][lane];
+                vertices[3 * lane + 2] = values[2][lane];
+            }
+#else
+            for (size_t lane = 0; lane < 4; ++lane) {
+                for (size_t i = 0; i < 3; ++i) {
+                    vertices[3 * lane + i] = figfile->value_callback(params + i * component_size + lane, 4, complection);
+                }
+            }
+#endif
+        }
+    }
+
+    void ce_figbake_eval_normals(float* array, const ce_figfile* figfile)
+    {
+        for (int block = 0; block < figfile->normal_count; ++block) {
+            const float* params = figfile->normals + 4 * 4 * block;
+            float* normals = array + 3 * 4 * block;
+
+#ifdef __SSE__
+            const __m128 inv_w = _mm_div_ps(_mm_set1_ps(1.0f), _mm_loadu_ps(params + 12));
+
+            float values[3][4];
+            for (size_t i = 0; i < 3; ++i) {
+                _mm_storeu_ps(values[i], _mm_mul_ps(_mm_loadu_ps(params + 4 * i), inv_w));
+            }
+
+            for (size_t lane = 0; lane < 4; ++lane) {
+                normals[3 * lane + 0] = values[0][lane];
+                normals[3 * lane + 1] = values[1][lane];
+                normals[3 * lane + 2] = values[2][lane];
+            }
+#else
+            for (size_t lane = 0; lane < 4; ++lane) {
+                float inv_w = 1.0f / params[lane + 12];
+                normals[3 * lane + 0] = params[lane + 0] * inv_w;
+                normals[3 * lane + 1] = params[lane + 4] * inv_w;
+                normals[3 * lane + 2] = params[lane + 8] * inv_w;
+            }
+#endif
+        }
+    }
+
+    ce_figbake* ce_figbake_new(const ce_figfile* figfile, const complection_t* complection)
+    {
+        ce_figbake* figbake = (ce_figbake*)ce_alloc(sizeof(ce_figbake));
+        figbake->vertex_count = figfile->index_count;
+        figbake->vertices = (float*)ce_alloc(sizeof(float) * 3 * figbake->vertex_count);
+        figbake->normals = (float*)ce_alloc(sizeof(float) * 3 * figbake->vertex_count);
+        figbake->texcoords = (float*)ce_alloc(sizeof(float) * 2 * figbake->vertex_count);
+
+        // evaluate every source vertex and normal once, then expand by indices
+        std::vector<float> vertices(3 * 4 * figfile->vertex_count);
+        std::vector<float> normals(3 * 4 * figfile->normal_count);
+
+        ce_figbake_eval_vertices(vertices.data(), figfile, complection);
+        ce_figbake_eval_normals(normals.data(), figfile);
+
+        for (int i = 0; i < figbake->vertex_count; ++i) {
+            int index = figfile->indices[i];
+            int vertex_index = figfile->vertex_components[3 * index + 0];
+            int normal_index = figfile->vertex_components[3 * index + 1];
+            int texcoord_index = figfile->vertex_components[3 * index + 2];
+
+            for (size_t j = 0; j < 3; ++j) {
+                figbake->vertices[3 * i + j] = vertices[3 * vertex_index + j];
+                figbake->normals[3 * i + j] = normals[3 * normal_index + j];
+            }
+
+            figbake->texcoords[2 * i + 0] = figfile->texcoords[2 * texcoord_index + 0];
+            figbake->texcoords[2 * i + 1] = figfile->texcoords[2 * texcoord_index + 1];
+        }
+
+        return figbake;
+    }
+
+    void ce_figbake_del(ce_figbake* figbake)
+    {
+        if (NULL != figbake) {
+            ce_free(figbake->texcoords, sizeof(float) * 2 * figbake->vertex_count);
+            ce_free(figbake->normals, sizeof(float) * 3 * figbake->vertex_count);
+            ce_free(figbake->vertices, sizeof(float) * 3 * figbake->vertex_count);
+            ce_free(figbake, sizeof(ce_figbake));
+        }
+    }
+
+    struct ce_figweld_key {
+        float values[CE_FIGWELD_VERTEX_SIZE];
+
+        bool operator ==(const ce_figweld_key& other) const
+        {
+            return 0 == memcmp(values, other.values, sizeof(values));
+        }
+    };
+
+    struct ce_figweld_key_hash {
+        size_t operator ()(const ce_figweld_key& key) const
+        {
+            return fnv1a64(key.values, sizeof(key.values));
+        }
+    };
+
+    /*
+     *  Linear-speed vertex cache optimisation.
+     *  Forsyth, Tom. "Linear-Speed Vertex Cache Optimisation", 2006.
+     */
+
+    enum {
+        CE_FIGWELD_CACHE_SIZE = 32,
+    };
+
+    const float CE_FIGWELD_CACHE_DECAY_POWER = 1.5f;
+    const float CE_FIGWELD_LAST_TRIANGLE_SCORE = 0.75f;
+    const float CE_FIGWELD_VALENCE_BOOST_SCALE = 2.0f;
+    const float CE_FIGWELD_VALENCE_BOOST_POWER = 0.5f;
+
+    struct ce_figweld_vertex {
+        int cache_position = -1;
+        int active_triangle_count = 0;
+        float score = 0.0f;
+        std::vector<int> triangles;
+    };
+
+    float ce_figweld_vertex_score(const ce_figweld_vertex& vertex)
+    {
+        if (0 == vertex.active_triangle_count) {
+            return -1.0f; // no triangles left, never needed again
+        }
+
+        float score = 0.0f;
+        if (vertex.cache_position >= 0) {
+            if (vertex.cache_position < 3) {
+                // used by the last triangle, deliberately low to avoid strips
+                score = CE_FIGWELD_LAST_TRIANGLE_SCORE;
+            } else {
+                const float scaler = 1.0f / (CE_FIGWELD_CACHE_SIZE - 3);
+                score = powf(1.0f - (vertex.cache_position - 3) * scaler, CE_FIGWELD_CACHE_DECAY_POWER);
+            }
+        }
+
+        // bonus for vertices with few triangles left, to get rid of lone ones
+        return score + CE_FIGWELD_VALENCE_BOOST_SCALE * powf(vertex.active_triangle_count, -CE_FIGWELD_VALENCE_BOOST_POWER);
+    }
+
+    void ce_figweld_optimize(uint16_t* indices, int index_count, int vertex_count)
+    {
+        const int triangle_count = index_count / 3;
+
+        std::vector<ce_figweld_vertex> vertices(vertex_count);
+        for (int i = 0; i < 3 * triangle_count; ++i) {
+            vertices[indices[i]].triangles.push_back(i / 3);
+            ++vertices[indices[i]].active_triangle_count;
+        }
+
+        for (auto& vertex: vertices) {
+            vertex.score = ce_figweld_vertex_score(vertex);
+        }
+
+        std::vector<float> triangle_scores(triangle_count);
+        std::vector<bool> triangle_added(triangle_count, false);
+        for (int i = 0; i < triangle_count; ++i) {
+            triangle_scores[i] = vertices[indices[3 * i + 0]].score + vertices[indices[3 * i + 1]].score + vertices[indices[3 * i + 2]].score;
+        }
+
+        std::vector<uint16_t> output;
+        output.reserve(3 * triangle_count);
+
+        std::vector<int> cache;
+        cache.reserve(CE_FIGWELD_CACHE_SIZE + 3);
+
+        int best_triangle = -1;
+        for (int added_count = 0; added_count < triangle_count; ++added_count) {
+            if (-1 == best_triangle) {
+                // nothing scored in the cache, fall back to a full search
+                float best_score = -1.0f;
+                for (int i = 0; i < triangle_count; ++i) {
+                    if (!triangle_added[i] && triangle_scores[i] > best_score) {
+                        best_score = triangle_scores[i];
+                        best_triangle = i;
+                    }
+                }
+            }
+
+            triangle_added[best_triangle] = true;
+
+            std::vector<int> new_cache;
+            new_cache.reserve(CE_FIGWELD_CACHE_SIZE + 3);
+
+            for (int i = 0; i < 3; ++i) {
+                const int index = indices[3 * best_triangle + i];
+                ce_figweld_vertex& vertex = vertices[index];
+                output.push_back(index);
+                --vertex.active_triangle_count;
+                for (auto& triangle: vertex.triangles) {
+                    if (triangle == best_triangle) {
+                        std::swap(triangle, vertex.triangles.back());
+                        vertex.triangles.pop_back();
+                        break;
+                    }
+                }
+                new_cache.push_back(index);
+            }
+
+            for (const auto& index: cache) {
+                if (index != new_cache[0] && index != new_cache[1] && index != new_cache[2]) {
+                    new_cache.push_back(index);
+                }
+            }
+
+            // vertices pushed out of the cache lose their cache bonus
+            for (size_t i = CE_FIGWELD_CACHE_SIZE; i < new_cache.size(); ++i) {
+                vertices[new_cache[i]].cache_position = -1;
+                vertices[new_cache[i]].score = ce_figweld_vertex_score(vertices[new_cache[i]]);
+            }
+
+            if (new_cache.size() > CE_FIGWELD_CACHE_SIZE) {
+                new_cache.resize(CE_FIGWELD_CACHE_SIZE);
+            }
+
+            for (size_t i = 0; i < new_cache.size(); ++i) {
+                vertices[new_cache[i]].cache_position = i;
+                vertices[new_cache[i]].score = ce_figweld_vertex_score(vertices[new_cache[i]]);
+            }
+
+            // rescore triangles touching the cache and pick the next one
+            best_triangle = -1;
+            float best_score = -1.0f;
+            for (const auto& index: new_cache) {
+                for (const auto& triangle: vertices[index].triangles) {
+                    const float score = vertices[indices[3 * triangle + 0]].score +
+                                        vertices[indices[3 * triangle + 1]].score +
+                                        vertices[indices[3 * triangle + 2]].score;
+                    triangle_scores[triangle] = score;
+                    if (score > best_score) {
+                        best_score = score;
+                        best_triangle = triangle;
+                    }
+                }
+            }
+
+            cache.swap(new_cache);
+        }
+
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    ce_figweld* ce_figweld_new(const ce_figbake* figbake)
+    {
+        std::unordered_map<ce_figweld_key, int, ce_figweld_key_hash> unique_indices;
+        std::vector<ce_figweld_key> unique_vertices;
+        std::vector<uint16_t> indices(figbake->vertex_count);
+
+        for (int i = 0; i < figbake->vertex_count; ++i) {
+            ce_figweld_key key;
+            memcpy(key.values + 0, figbake->vertices + 3 * i, sizeof(float) * 3);
+            memcpy(key.values + 3, figbake->normals + 3 * i, sizeof(float) * 3);
+            memcpy(key.values + 6, figbake->texcoords + 2 * i, sizeof(float) * 2);
+
+            auto result = unique_indices.insert(std::make_pair(key, (int)unique_vertices.size()));
+            if (result.second) {
+                if (unique_vertices.size() > UINT16_MAX) {
+                    return NULL;
+                }
+                unique_vertices.push_back(key);
+            }
+            indices[i] = result.first->second;
+        }
+
+        ce_figweld_optimize(indices.data(), indices.size(), unique_vertices.size());
+
+        ce_figweld* figweld = (ce_figweld*)ce_alloc(sizeof(ce_figweld));
+        figweld->vertex_count = unique_vertices.size();
+        figweld->index_count = indices.size();
+        figweld->vertices = (float*)ce_alloc(sizeof(float) * CE_FIGWELD_VERTEX_SIZE * figweld->vertex_count);
+        figweld->indices = (uint16_t*)ce_alloc(sizeof(uint16_t) * figweld->index_count);
+
+        // store vertices in order of first use, so fetches walk memory forward
+        std::vector<int> remap(figweld->vertex_count, -1);
+        int vertex_count = 0;
+        for (int i = 0; i < figweld->index_count; ++i) {
+            int& index = remap[indices[i]];
+            if (-1 == index) {
+                index = vertex_count++;
+                memcpy(figweld->vertices + CE_FIGWELD_VERTEX_SIZE * index, unique_vertices[indices[i]].values, sizeof(float) * CE_FIGWELD_VERTEX_SIZE);
+            }
+            figweld->indices[i] = index;
+        }
+
+        return figweld;
+    }
+
+    void ce_figweld_del(ce_figweld* figweld)
+    {
+        if (NULL != figweld) {
+            ce_free(figweld->indices, sizeof(uint16_t) * figweld->index_count);
+            ce_free(figweld->vertices, sizeof(float) * CE_FIGWELD_VERTEX_SIZE * figweld->vertex_count);
+            ce_free(figweld, sizeof(ce_figweld));
+        }
+    }
+}
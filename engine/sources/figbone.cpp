@@ -124,7 +124,7 @@ namespace cursedearth
 
     bool ce_figbone_play_animation(ce_figbone* figbone, const ce_fignode* fignode, const char* name)
     {
-        bool ok = ce_anmstate_play_animation(figbone->anmstate, fignode->anmfiles, name);
+        bool ok = ce_anmstate_play_animation(figbone->anmstate, fignode->anm_index, name);
         for (size_t i = 0; i < figbone->childs->count; ++i) {
             ok = ce_figbone_play_animation((ce_figbone*)figbone->childs->items[i], (ce_fignode*)fignode->childs->items[i], name) || ok;
         }
@@ -101,6 +101,10 @@ namespace cursedearth
             }
         }
 
+        if (0 != figentity->sound_object) {
+            set_sound_object_position(figentity->sound_object, figentity->scenenode->world_position);
+        }
+
         ce_figentity_enqueue(figentity, figentity->figmesh->figproto->fignode);
     }
 
@@ -129,11 +133,11 @@ namespace cursedearth
         }
     }
 
-    ce_figentity* ce_figentity_new(ce_figmesh* figmesh, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[], ce_scenenode* scenenode)
+    ce_figentity* ce_figentity_new(ce_figmesh* figmesh, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[], ce_figbone* figbone, ce_scenenode* scenenode)
     {
         ce_figentity* figentity = (ce_figentity*)ce_alloc_zero(sizeof(ce_figentity));
         figentity->figmesh = ce_figmesh_add_ref(figmesh);
-        figentity->figbone = ce_figbone_new(figmesh->figproto->fignode, &figmesh->complection, NULL);
+        figentity->figbone = NULL != figbone ? figbone : ce_figbone_new(figmesh->figproto->fignode, &figmesh->complection, NULL);
         figentity->textures = ce_vector_new_reserved(2);
         figentity->renderlayers = ce_vector_new();
         figentity->scenenode = ce_scenenode_new(scenenode);
@@ -167,6 +171,9 @@ namespace cursedearth
     void ce_figentity_del(ce_figentity* figentity)
     {
         if (NULL != figentity) {
+            if (0 != figentity->sound_object) {
+                remove_sound_object(figentity->sound_object);
+            }
             ce_scenenode_del(figentity->scenenode);
             ce_vector_del(figentity->renderlayers);
             ce_vector_for_each(figentity->textures, (void(*)(void*))ce_texture_del);
@@ -182,6 +189,20 @@ namespace cursedearth
         figentity->height_correction = height;
     }
 
+    void ce_figentity_attach_sound(ce_figentity* figentity, sound_object_t sound_object, int priority)
+    {
+        if (0 != figentity->sound_object) {
+            remove_sound_object(figentity->sound_object);
+        }
+        figentity->sound_object = sound_object;
+
+        // until the scene node is updated, the entity stands at its own position
+        vector3_t position = figentity->position;
+        position.y += figentity->height_correction;
+        set_sound_object_position(sound_object, position);
+        set_sound_object_priority(sound_object, priority);
+    }
+
     int ce_figentity_get_animation_count(ce_figentity* figentity)
     {
         return figentity->figmesh->figproto->fignode->anmfiles->count;
@@ -29,7 +29,9 @@ namespace cursedearth
 {
     void ce_figmesh_create_renderitems(ce_figmesh* figmesh, const ce_fignode* fignode)
     {
-        ce_renderitem* renderitem = ce_figrenderitem_new(fignode, &figmesh->complection);
+        ce_figbake* figbake = ce_figbake_new(fignode->figfile, &figmesh->complection);
+        ce_renderitem* renderitem = ce_figrenderitem_new(fignode, figbake);
+        ce_figbake_del(figbake);
         ce_fighlp_get_aabb(&renderitem->aabb, fignode->figfile, &figmesh->complection);
         ce_vector_push_back(figmesh->renderitems, renderitem);
         for (size_t i = 0; i < fignode->childs->count; ++i) {
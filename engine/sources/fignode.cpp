@@ -47,6 +47,8 @@ namespace cursedearth
             } // else ok, there is no animation for this node
         }
 
+        fignode->anm_index = ce_anm_index_new(fignode->anmfiles);
+
         while (lnkfile->link_index < lnkfile->link_count && boost::algorithm::iequals(fignode->name->str, lnkfile->links[lnkfile->link_index].parent_name->str)) {
             ce_vector_push_back(fignode->childs, ce_fignode_new(mod_res_file, bon_res_file, anm_res_files, lnkfile));
         }
@@ -58,6 +60,7 @@ namespace cursedearth
     {
         if (NULL != fignode) {
             ce_vector_for_each(fignode->childs, (void(*)(void*))ce_fignode_del);
+            ce_anm_index_del(fignode->anm_index);
             ce_vector_for_each(fignode->anmfiles, (void(*)(void*))ce_anmfile_close);
             ce_vector_del(fignode->childs);
             ce_material_del(fignode->material);
@@ -27,25 +27,27 @@
 #include "utility.hpp"
 #include "opengl.hpp"
 #include "anmstate.hpp"
-#include "fighelpers.hpp"
 #include "figrenderitem.hpp"
 
 namespace cursedearth
 {
     /**
-     * @brief fig renderitem static (without morphs): GL's display list
+     * @brief fig renderitem static (without morphs): GL's vertex and index buffer objects
+     *        with welded geometry or, as a fallback, GL's display list
      */
     struct ce_figcookie_static
     {
         std::atomic<int> ref_count;
-        GLuint id;
+        GLuint id; // display list, 0 if buffers are used
+        GLuint vertex_buffer;
+        GLuint index_buffer;
+        GLsizei index_count;
     };
 
     ce_figcookie_static* ce_figcookie_static_new(void)
     {
-        ce_figcookie_static* cookie = (ce_figcookie_static*)ce_alloc(sizeof(ce_figcookie_static));
+        ce_figcookie_static* cookie = (ce_figcookie_static*)ce_alloc_zero(sizeof(ce_figcookie_static));
         cookie->ref_count = 1;
-        cookie->id = glGenLists(1);
         return cookie;
     }
 
@@ -54,7 +56,12 @@ namespace cursedearth
         if (NULL != cookie) {
             assert(cookie->ref_count > 0);
             if (0 == --cookie->ref_count) {
-                glDeleteLists(cookie->id, 1);
+                if (0 != cookie->id) {
+                    glDeleteLists(cookie->id, 1);
+                } else {
+                    glDeleteBuffers(1, &cookie->index_buffer);
+                    glDeleteBuffers(1, &cookie->vertex_buffer);
+                }
                 ce_free(cookie, sizeof(ce_figcookie_static));
             }
         }
@@ -70,31 +77,65 @@ namespace cursedearth
         ce_figcookie_static* cookie;
     } ce_figrenderitem_static;
 
+    void ce_figrenderitem_static_draw_weld(const ce_figweld* figweld, const float* vertices, const uint16_t* indices)
+    {
+        const GLsizei stride = sizeof(float) * CE_FIGWELD_VERTEX_SIZE;
+
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+        glVertexPointer(3, GL_FLOAT, stride, vertices + 0);
+        glNormalPointer(GL_FLOAT, stride, vertices + 3);
+        glTexCoordPointer(2, GL_FLOAT, stride, vertices + 6);
+
+        glDrawElements(GL_TRIANGLES, figweld->index_count, GL_UNSIGNED_SHORT, indices);
+
+        glPopClientAttrib();
+    }
+
     void ce_figrenderitem_static_ctor(ce_renderitem* renderitem, va_list args)
     {
         ce_figrenderitem_static* figrenderitem = (ce_figrenderitem_static*)renderitem->impl;
 
-        const ce_figfile* figfile = va_arg(args, const ce_figfile*);
-        const complection_t* complection = va_arg(args, const complection_t*);
+        const ce_figbake* figbake = va_arg(args, const ce_figbake*);
+        const ce_figweld* figweld = va_arg(args, const ce_figweld*);
 
         figrenderitem->cookie = ce_figcookie_static_new();
 
-        glNewList(figrenderitem->cookie->id, GL_COMPILE);
+        if (NULL != figweld && GLEW_VERSION_1_5) {
+            figrenderitem->cookie->index_count = figweld->index_count;
 
-        float array[3];
+            glGenBuffers(1, &figrenderitem->cookie->vertex_buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, figrenderitem->cookie->vertex_buffer);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * CE_FIGWELD_VERTEX_SIZE * figweld->vertex_count, figweld->vertices, GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glBegin(GL_TRIANGLES);
-        for (int i = 0, n = figfile->index_count; i < n; ++i) {
-            int index = figfile->indices[i];
-            int vertex_index = figfile->vertex_components[3 * index + 0];
-            int normal_index = figfile->vertex_components[3 * index + 1];
-            int texcoord_index = figfile->vertex_components[3 * index + 2];
+            glGenBuffers(1, &figrenderitem->cookie->index_buffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, figrenderitem->cookie->index_buffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * figweld->index_count, figweld->indices, GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            return;
+        }
+
+        figrenderitem->cookie->id = glGenLists(1);
+
+        glNewList(figrenderitem->cookie->id, GL_COMPILE);
 
-            glTexCoord2fv(figfile->texcoords + 2 * texcoord_index);
-            glNormal3fv(ce_fighlp_get_normal(array, figfile, normal_index));
-            glVertex3fv(ce_fighlp_get_vertex(array, figfile, vertex_index, complection));
+        if (NULL != figweld) {
+            // client arrays are dereferenced at compile time
+            ce_figrenderitem_static_draw_weld(figweld, figweld->vertices, figweld->indices);
+        } else {
+            glBegin(GL_TRIANGLES);
+            for (int i = 0; i < figbake->vertex_count; ++i) {
+                glTexCoord2fv(figbake->texcoords + 2 * i);
+                glNormal3fv(figbake->normals + 3 * i);
+                glVertex3fv(figbake->vertices + 3 * i);
+            }
+            glEnd();
         }
-        glEnd();
 
         glEndList();
     }
@@ -108,7 +149,32 @@ namespace cursedearth
     void ce_figrenderitem_static_render(ce_renderitem* renderitem)
     {
         ce_figrenderitem_static* figrenderitem = (ce_figrenderitem_static*)renderitem->impl;
-        glCallList(figrenderitem->cookie->id);
+        ce_figcookie_static* cookie = figrenderitem->cookie;
+
+        if (0 != cookie->id) {
+            glCallList(cookie->id);
+        } else {
+            const GLsizei stride = sizeof(float) * CE_FIGWELD_VERTEX_SIZE;
+
+            glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_NORMAL_ARRAY);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+            glBindBuffer(GL_ARRAY_BUFFER, cookie->vertex_buffer);
+            glVertexPointer(3, GL_FLOAT, stride, (const GLvoid*)(sizeof(float) * 0));
+            glNormalPointer(GL_FLOAT, stride, (const GLvoid*)(sizeof(float) * 3));
+            glTexCoordPointer(2, GL_FLOAT, stride, (const GLvoid*)(sizeof(float) * 6));
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cookie->index_buffer);
+            glDrawElements(GL_TRIANGLES, cookie->index_count, GL_UNSIGNED_SHORT, NULL);
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            glPopClientAttrib();
+        }
     }
 
     void ce_figrenderitem_static_clone(const ce_renderitem* renderitem, ce_renderitem* clone_renderitem)
@@ -184,50 +250,24 @@ namespace cursedearth
     {
         ce_figrenderitem_dynamic* figrenderitem = (ce_figrenderitem_dynamic*)renderitem->impl;
 
-        const ce_figfile* figfile = va_arg(args, const ce_figfile*);
-        const complection_t* complection = va_arg(args, const complection_t*);
+        const ce_figbake* figbake = va_arg(args, const ce_figbake*);
 
-        figrenderitem->cookie = ce_figcookie_dynamic_new(figfile->index_count);
-        figrenderitem->vertices = (float*)ce_alloc(sizeof(float) * 3 * figfile->index_count);
+        figrenderitem->cookie = ce_figcookie_dynamic_new(figbake->vertex_count);
+        figrenderitem->vertices = (float*)ce_alloc(sizeof(float) * 3 * figbake->vertex_count);
 
-        float* normals;
-        float* texcoords;
+        memcpy(figrenderitem->cookie->vertices, figbake->vertices, sizeof(float) * 3 * figbake->vertex_count);
+        memcpy(figrenderitem->vertices, figbake->vertices, sizeof(float) * 3 * figbake->vertex_count);
 
         if (GLEW_VERSION_1_5) {
             glBindBuffer(GL_ARRAY_BUFFER, figrenderitem->cookie->normals.buffer);
-            glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float) * figfile->index_count, NULL, GL_STATIC_DRAW);
-            normals = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-
+            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * figbake->vertex_count, figbake->normals, GL_STATIC_DRAW);
             glBindBuffer(GL_ARRAY_BUFFER, figrenderitem->cookie->texcoords.buffer);
-            glBufferData(GL_ARRAY_BUFFER, 2 * sizeof(float) * figfile->index_count, NULL, GL_STATIC_DRAW);
-            texcoords = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        } else {
-            normals = figrenderitem->cookie->normals.pointer;
-            texcoords = figrenderitem->cookie->texcoords.pointer;
-        }
-
-        for (int i = 0, n = figfile->index_count; i < n; ++i) {
-            int index = figfile->indices[i];
-            int vertex_index = figfile->vertex_components[3 * index + 0];
-            int normal_index = figfile->vertex_components[3 * index + 1];
-            int texcoord_index = figfile->vertex_components[3 * index + 2];
-
-            ce_fighlp_get_vertex(figrenderitem->cookie->vertices + 3 * i, figfile, vertex_index, complection);
-            ce_fighlp_get_normal(normals + 3 * i, figfile, normal_index);
-
-            texcoords[2 * i + 0] = figfile->texcoords[2 * texcoord_index + 0];
-            texcoords[2 * i + 1] = figfile->texcoords[2 * texcoord_index + 1];
-        }
-
-        if (GLEW_VERSION_1_5) {
-            glBindBuffer(GL_ARRAY_BUFFER, figrenderitem->cookie->normals.buffer);
-            glUnmapBuffer(GL_ARRAY_BUFFER);
-            glBindBuffer(GL_ARRAY_BUFFER, figrenderitem->cookie->texcoords.buffer);
-            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2 * figbake->vertex_count, figbake->texcoords, GL_STATIC_DRAW);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
+        } else {
+            memcpy(figrenderitem->cookie->normals.pointer, figbake->normals, sizeof(float) * 3 * figbake->vertex_count);
+            memcpy(figrenderitem->cookie->texcoords.pointer, figbake->texcoords, sizeof(float) * 2 * figbake->vertex_count);
         }
-
-        memcpy(figrenderitem->vertices, figrenderitem->cookie->vertices, sizeof(float) * 3 * figfile->index_count);
     }
 
     void ce_figrenderitem_dynamic_dtor(ce_renderitem* renderitem)
@@ -324,13 +364,19 @@ namespace cursedearth
         sizeof(ce_figrenderitem_dynamic)
     };
 
-    ce_renderitem* ce_figrenderitem_new(const ce_fignode* fignode, const complection_t* complection)
+    ce_renderitem* ce_figrenderitem_new(const ce_fignode* fignode, const ce_figbake* figbake)
     {
         bool has_morphing = false;
         for (size_t i = 0; i < fignode->anmfiles->count; ++i) {
             ce_anmfile* anmfile = (ce_anmfile*)fignode->anmfiles->items[i];
             has_morphing = has_morphing || NULL != anmfile->morphs;
         }
-        return ce_renderitem_new(ce_figrenderitem_vtables[has_morphing], ce_figrenderitem_sizes[has_morphing], fignode->figfile, complection);
+
+        // morphs address vertices by their source index, so only static geometry is welded
+        ce_figweld* figweld = has_morphing ? NULL : ce_figweld_new(figbake);
+        ce_renderitem* renderitem = ce_renderitem_new(ce_figrenderitem_vtables[has_morphing], ce_figrenderitem_sizes[has_morphing], figbake, figweld);
+        ce_figweld_del(figweld);
+
+        return renderitem;
     }
 }
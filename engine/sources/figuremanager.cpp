@@ -19,12 +19,14 @@
  */
 
 #include <vector>
+#include <algorithm>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
 #include "alloc.hpp"
 #include "logging.hpp"
+#include "utility.hpp"
 #include "resfile.hpp"
 #include "optionmanager.hpp"
 #include "fighelpers.hpp"
@@ -41,6 +43,24 @@ namespace cursedearth
     const std::vector<std::string> ce_figure_resource_exts = { ".res" };
     const std::vector<std::string> ce_figure_resource_names = { "figures", "menus" };
 
+    bool ce_figmesh_key::operator ==(const ce_figmesh_key& other) const
+    {
+        // exact match: complections come from level files and are never computed
+        return figproto == other.figproto &&
+            complection.dexterity == other.complection.dexterity &&
+            complection.strength == other.complection.strength &&
+            complection.height == other.complection.height;
+    }
+
+    size_t ce_figmesh_key_hash::operator ()(const ce_figmesh_key& key) const
+    {
+        uint64_t hash = fnv1a64(&key.figproto, sizeof(key.figproto));
+        hash = fnv1a64(&key.complection.dexterity, sizeof(float), hash);
+        hash = fnv1a64(&key.complection.strength, sizeof(float), hash);
+        hash = fnv1a64(&key.complection.height, sizeof(float), hash);
+        return hash;
+    }
+
     void ce_notify_figproto_created(ce_vector* listeners, ce_figproto* figproto)
     {
         for (size_t i = 0; i < listeners->count; ++i) {
@@ -76,22 +96,28 @@ namespace cursedearth
         return fs::path();
     }
 
-    // TODO: cleanup unused protos and meshes
+    // estimated memory footprint: raw figure data for protos, vertices, normals and texcoords per index for meshes
 
-    void ce_figure_manager_init()
+    size_t ce_figproto_estimate_size(const ce_fignode* fignode)
     {
-        ce_figure_manager = (struct ce_figure_manager*)ce_alloc_zero(sizeof(struct ce_figure_manager));
-        ce_figure_manager->res_files = ce_vector_new();
-        ce_figure_manager->figprotos = ce_vector_new();
-        ce_figure_manager->figmeshes = ce_vector_new();
-        ce_figure_manager->entities = ce_vector_new_reserved(512);
-        ce_figure_manager->listeners = ce_vector_new();
+        size_t size = sizeof(ce_fignode) + fignode->figfile->size;
+        for (size_t i = 0; i < fignode->childs->count; ++i) {
+            size += ce_figproto_estimate_size((const ce_fignode*)fignode->childs->items[i]);
+        }
+        return size;
+    }
 
-        for (const auto& dir: ce_figure_resource_dirs) {
-            fs::path path = option_manager_t::instance()->ei_path() / dir;
-            ce_logging_info("figure manager: using path `%s'", path.string().c_str());
+    size_t ce_figmesh_estimate_size(const ce_fignode* fignode)
+    {
+        size_t size = sizeof(float) * (3 + 3 + 2) * fignode->figfile->index_count;
+        for (size_t i = 0; i < fignode->childs->count; ++i) {
+            size += ce_figmesh_estimate_size((const ce_fignode*)fignode->childs->items[i]);
         }
+        return size;
+    }
 
+    void ce_figure_manager_open_resources()
+    {
         for (const auto& name: ce_figure_resource_names) {
             ce_res_file* res_file;
             fs::path path = find_figure_resource(name);
@@ -104,47 +130,178 @@ namespace cursedearth
         }
     }
 
+    void ce_figure_manager_init()
+    {
+        ce_figure_manager = (struct ce_figure_manager*)ce_alloc_zero(sizeof(struct ce_figure_manager));
+        ce_figure_manager->cache_budget = option_manager_t::instance()->figure_cache_size() * 1024 * 1024;
+        ce_figure_manager->res_files = ce_vector_new();
+        ce_figure_manager->res_files_flag = new std::once_flag;
+        ce_figure_manager->figprotos = new ce_figproto_map;
+        ce_figure_manager->pending_figprotos = ce_vector_new();
+        ce_figure_manager->figmeshes = new ce_figmesh_map;
+        ce_figure_manager->entities = ce_vector_new_reserved(512);
+        ce_figure_manager->listeners = ce_vector_new();
+        ce_figure_manager->mutex = ce_mutex_new();
+
+        for (const auto& dir: ce_figure_resource_dirs) {
+            fs::path path = option_manager_t::instance()->ei_path() / dir;
+            ce_logging_info("figure manager: using path `%s'", path.string().c_str());
+        }
+    }
+
     void ce_figure_manager_term()
     {
         if (NULL != ce_figure_manager) {
             ce_figure_manager_clear();
-            ce_vector_for_each(ce_figure_manager->figmeshes, (void(*)(void*))ce_figmesh_del);
-            ce_vector_for_each(ce_figure_manager->figprotos, (void(*)(void*))ce_figproto_del);
+            for (const auto& pair: *ce_figure_manager->figmeshes) {
+                ce_figmesh_del(pair.second.figmesh);
+            }
+            ce_vector_for_each(ce_figure_manager->pending_figprotos, (void(*)(void*))ce_figproto_del);
+            for (const auto& pair: *ce_figure_manager->figprotos) {
+                ce_figproto_del(pair.second.figproto);
+            }
             ce_vector_for_each(ce_figure_manager->res_files, (void(*)(void*))ce_res_file_del);
+            ce_mutex_del(ce_figure_manager->mutex);
             ce_vector_del(ce_figure_manager->listeners);
             ce_vector_del(ce_figure_manager->entities);
-            ce_vector_del(ce_figure_manager->figmeshes);
-            ce_vector_del(ce_figure_manager->figprotos);
+            delete ce_figure_manager->figmeshes;
+            ce_vector_del(ce_figure_manager->pending_figprotos);
+            delete ce_figure_manager->figprotos;
             ce_vector_del(ce_figure_manager->res_files);
+            delete ce_figure_manager->res_files_flag;
             ce_free(ce_figure_manager, sizeof(struct ce_figure_manager));
         }
     }
 
+    // queued render items, materials and textures of deleted figures must not be reachable from render queues
+    void ce_notify_figures_removing(ce_vector* listeners)
+    {
+        for (size_t i = 0; i < listeners->count; ++i) {
+            ce_figure_manager_listener* listener = (ce_figure_manager_listener*)listeners->items[i];
+            if (NULL != listener->figures_removing) {
+                (*listener->figures_removing)(listener->listener);
+            }
+        }
+    }
+
     void ce_figure_manager_clear()
     {
+        ce_notify_figures_removing(ce_figure_manager->listeners);
         ce_vector_for_each(ce_figure_manager->entities, (void(*)(void*))ce_figentity_del);
         ce_vector_clear(ce_figure_manager->entities);
+        ce_figure_manager_trim();
     }
 
-    ce_figproto* ce_figure_manager_create_proto(const std::string& name)
+    void ce_figure_manager_trim()
+    {
+        // protos referenced by queued listener notifications are in use as well
+        ce_figure_manager_flush_protos();
+
+        size_t unused_size = 0;
+        std::vector<ce_figmesh_map::iterator> unused_figmeshes;
+
+        for (auto it = ce_figure_manager->figmeshes->begin(); it != ce_figure_manager->figmeshes->end(); ++it) {
+            if (1 == it->second.figmesh->ref_count) {
+                unused_size += it->second.size;
+                unused_figmeshes.push_back(it);
+            }
+        }
+
+        std::sort(unused_figmeshes.begin(), unused_figmeshes.end(), [](ce_figmesh_map::iterator a, ce_figmesh_map::iterator b) {
+            return a->second.last_use < b->second.last_use;
+        });
+
+        size_t figmesh_count = 0;
+        for (auto it: unused_figmeshes) {
+            if (unused_size <= ce_figure_manager->cache_budget) {
+                break;
+            }
+            if (0 == figmesh_count) {
+                ce_notify_figures_removing(ce_figure_manager->listeners);
+            }
+            unused_size -= it->second.size;
+            ce_figmesh_del(it->second.figmesh); // frees GL objects
+            ce_figure_manager->figmeshes->erase(it);
+            ++figmesh_count;
+        }
+
+        // workers may take references to protos concurrently
+        ce_mutex_lock(ce_figure_manager->mutex);
+
+        std::vector<ce_figproto_map::iterator> unused_figprotos;
+        for (auto it = ce_figure_manager->figprotos->begin(); it != ce_figure_manager->figprotos->end(); ++it) {
+            if (1 == it->second.figproto->ref_count) {
+                unused_size += it->second.size;
+                unused_figprotos.push_back(it);
+            }
+        }
+
+        std::sort(unused_figprotos.begin(), unused_figprotos.end(), [](ce_figproto_map::iterator a, ce_figproto_map::iterator b) {
+            return a->second.last_use < b->second.last_use;
+        });
+
+        size_t figproto_count = 0;
+        for (auto it: unused_figprotos) {
+            if (unused_size <= ce_figure_manager->cache_budget) {
+                break;
+            }
+            if (0 == figmesh_count && 0 == figproto_count) {
+                ce_notify_figures_removing(ce_figure_manager->listeners);
+            }
+            unused_size -= it->second.size;
+            ce_figproto_del(it->second.figproto);
+            ce_figure_manager->figprotos->erase(it);
+            ++figproto_count;
+        }
+
+        ce_mutex_unlock(ce_figure_manager->mutex);
+
+        if (0 != figmesh_count || 0 != figproto_count) {
+            ce_logging_debug("figure manager: evicted %zu meshes and %zu protos, %zu bytes of unused figures kept", figmesh_count, figproto_count, unused_size);
+        }
+    }
+
+    ce_figproto* ce_figure_manager_resolve_proto(const std::string& name)
     {
         std::string base_name = name.substr(0, name.find_last_of("."));
+        std::string key = boost::algorithm::to_lower_copy(base_name);
 
         // find in cache
-        for (size_t i = 0; i < ce_figure_manager->figprotos->count; ++i) {
-            ce_figproto* figproto = (ce_figproto*)ce_figure_manager->figprotos->items[i];
-            if (boost::algorithm::iequals(base_name, figproto->name->str)) {
-                return figproto;
-            }
+        ce_mutex_lock(ce_figure_manager->mutex);
+        ce_figproto* figproto = NULL;
+        auto it = ce_figure_manager->figprotos->find(key);
+        if (ce_figure_manager->figprotos->end() != it) {
+            it->second.last_use = ++ce_figure_manager->use_count;
+            figproto = ce_figproto_add_ref(it->second.figproto);
+        }
+        ce_mutex_unlock(ce_figure_manager->mutex);
+
+        if (NULL != figproto) {
+            return figproto;
         }
 
+        std::call_once(*ce_figure_manager->res_files_flag, ce_figure_manager_open_resources);
+
+        // parse outside the lock, so that workers may load different protos concurrently
         std::string file_name = name + ce_figure_exts[0];
         for (size_t i = 0; i < ce_figure_manager->res_files->count; ++i) {
             ce_res_file* res_file = (ce_res_file*)ce_figure_manager->res_files->items[i];
             if (res_file->node_count != ce_res_file_node_index(res_file, file_name.c_str())) {
-                ce_figproto* figproto = ce_figproto_new(base_name.data(), res_file);
-                ce_vector_push_back(ce_figure_manager->figprotos, figproto);
-                ce_notify_figproto_created(ce_figure_manager->listeners, figproto);
+                ce_figproto* new_figproto = ce_figproto_new(base_name.data(), res_file);
+                ce_figproto_entry entry = { new_figproto, ce_figproto_estimate_size(new_figproto->fignode), 0 };
+
+                ce_mutex_lock(ce_figure_manager->mutex);
+                entry.last_use = ++ce_figure_manager->use_count;
+                auto result = ce_figure_manager->figprotos->insert(std::make_pair(key, entry));
+                if (result.second) {
+                    ce_vector_push_back(ce_figure_manager->pending_figprotos, ce_figproto_add_ref(new_figproto));
+                    new_figproto = NULL;
+                }
+                figproto = ce_figproto_add_ref(result.first->second.figproto);
+                ce_mutex_unlock(ce_figure_manager->mutex);
+
+                // another thread was faster
+                ce_figproto_del(new_figproto);
                 return figproto;
             }
         }
@@ -153,47 +310,89 @@ namespace cursedearth
         return NULL;
     }
 
-    ce_figmesh* ce_figure_manager_create_mesh(const std::string& name, const complection_t* complection)
+    void ce_figure_manager_flush_protos()
     {
-        std::string base_name = name.substr(0, name.find_last_of("."));
+        ce_mutex_lock(ce_figure_manager->mutex);
+        std::vector<ce_figproto*> figprotos(ce_figure_manager->pending_figprotos->count);
+        for (size_t i = 0; i < figprotos.size(); ++i) {
+            figprotos[i] = (ce_figproto*)ce_figure_manager->pending_figprotos->items[i];
+        }
+        ce_vector_clear(ce_figure_manager->pending_figprotos);
+        ce_mutex_unlock(ce_figure_manager->mutex);
 
-        for (size_t i = 0; i < ce_figure_manager->figmeshes->count; ++i) {
-            ce_figmesh* figmesh = (ce_figmesh*)ce_figure_manager->figmeshes->items[i];
-            if (boost::algorithm::iequals(base_name, figmesh->figproto->name->str) && ce_complection_equal(complection, &figmesh->complection)) {
-                return figmesh;
-            }
+        // listeners touch render state, do not hold the lock
+        for (const auto& figproto: figprotos) {
+            ce_notify_figproto_created(ce_figure_manager->listeners, figproto);
+            ce_figproto_del(figproto);
         }
+    }
 
+    ce_figproto* ce_figure_manager_create_proto(const std::string& name)
+    {
+        ce_figproto* figproto = ce_figure_manager_resolve_proto(name);
+        ce_figure_manager_flush_protos();
+        // the cache keeps its own reference until the proto is evicted by trim on this thread
+        ce_figproto_del(figproto);
+        return figproto;
+    }
+
+    ce_figmesh* ce_figure_manager_create_mesh(const std::string& name, const complection_t* complection)
+    {
         ce_figproto* figproto = ce_figure_manager_create_proto(name);
         if (NULL != figproto) {
-            ce_figmesh* figmesh = ce_figmesh_new(figproto, complection);
-            ce_vector_push_back(ce_figure_manager->figmeshes, figmesh);
-            ce_notify_figmesh_created(ce_figure_manager->listeners, figmesh);
-            return figmesh;
+            return ce_figure_manager_create_mesh_proto(figproto, complection);
         }
 
         ce_logging_error("figure manager: could not create figure mesh `%s'", name.c_str());
         return NULL;
     }
 
+    ce_figmesh* ce_figure_manager_create_mesh_proto(ce_figproto* figproto, const complection_t* complection)
+    {
+        const ce_figmesh_key key = { figproto, *complection };
+
+        auto it = ce_figure_manager->figmeshes->find(key);
+        if (ce_figure_manager->figmeshes->end() != it) {
+            it->second.last_use = ++ce_figure_manager->use_count;
+            return it->second.figmesh;
+        }
+
+        ce_figmesh* figmesh = ce_figmesh_new(figproto, complection);
+        ce_figmesh_entry entry = { figmesh, ce_figmesh_estimate_size(figproto->fignode), ++ce_figure_manager->use_count };
+        ce_figure_manager->figmeshes->insert(std::make_pair(key, entry));
+        ce_notify_figmesh_created(ce_figure_manager->listeners, figmesh);
+        return figmesh;
+    }
+
     ce_figentity* ce_figure_manager_create_entity(const std::string& name, const complection_t* complection, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[])
     {
-        ce_figmesh* mesh = ce_figure_manager_create_mesh(name, complection);
-        if (NULL != mesh) {
-            ce_figentity* entity = ce_figentity_new(mesh, position, orientation, parts, textures, NULL);
-            if (NULL != entity) {
-                ce_vector_push_back(ce_figure_manager->entities, entity);
-                return entity;
-            }
+        ce_figproto* figproto = ce_figure_manager_create_proto(name);
+        if (NULL != figproto) {
+            return ce_figure_manager_create_entity_proto(figproto, complection, position, orientation, parts, textures, NULL);
         }
 
         ce_logging_error("figure manager: could not create figure entity `%s'", name.c_str());
         return NULL;
     }
 
+    ce_figentity* ce_figure_manager_create_entity_proto(ce_figproto* figproto, const complection_t* complection, const vector3_t* position, const quaternion_t* orientation, const char* parts[], const char* textures[], ce_figbone* figbone)
+    {
+        ce_figmesh* mesh = ce_figure_manager_create_mesh_proto(figproto, complection);
+        ce_figentity* entity = ce_figentity_new(mesh, position, orientation, parts, textures, figbone, NULL);
+        if (NULL != entity) {
+            ce_vector_push_back(ce_figure_manager->entities, entity);
+            return entity;
+        }
+
+        ce_logging_error("figure manager: could not create figure entity `%s'", figproto->name->str);
+        return NULL;
+    }
+
     void ce_figure_manager_remove_entity(ce_figentity* entity)
     {
+        ce_notify_figures_removing(ce_figure_manager->listeners);
         ce_vector_remove_all(ce_figure_manager->entities, entity);
         ce_figentity_del(entity);
+        ce_figure_manager_trim();
     }
 }
@@ -0,0 +1,213 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <algorithm>
+
+#include "utility.hpp"
+#include "keytable.hpp"
+
+namespace cursedearth
+{
+    namespace
+    {
+        const size_t initial_slot_count = 64;
+
+        inline uint32_t name_hash(const char* name, size_t length)
+        {
+            uint64_t hash = fnv1a64(name, length);
+            return static_cast<uint32_t>(hash ^ (hash >> 32));
+        }
+
+        inline size_t key_hash(uint64_t key)
+        {
+            return static_cast<size_t>(fnv1a64(&key, sizeof(key)));
+        }
+
+        inline uint64_t section_key(uint32_t name)
+        {
+            return static_cast<uint64_t>(CE_KEY_TABLE_NPOS) << 32 | name;
+        }
+
+        inline uint64_t option_key(size_t section_index, uint32_t name)
+        {
+            return static_cast<uint64_t>(section_index) << 32 | name;
+        }
+
+        inline bool name_equal(const ce_key_table* key_table, uint32_t id, const char* name, size_t length)
+        {
+            const char* interned = key_table->names.data() + id;
+            return 0 == memcmp(interned, name, length) && '\0' == interned[length];
+        }
+
+        uint32_t find_name(const ce_key_table* key_table, const char* name, size_t length, uint32_t hash)
+        {
+            if (key_table->name_slots.empty()) {
+                return CE_KEY_TABLE_NPOS;
+            }
+            const size_t mask = key_table->name_slots.size() - 1;
+            for (size_t i = hash & mask; CE_KEY_TABLE_NPOS != key_table->name_slots[i].name; i = (i + 1) & mask) {
+                const ce_key_table::name_slot_t& slot = key_table->name_slots[i];
+                if (hash == slot.hash && name_equal(key_table, slot.name, name, length)) {
+                    return slot.name;
+                }
+            }
+            return CE_KEY_TABLE_NPOS;
+        }
+
+        void place_name(std::vector<ce_key_table::name_slot_t>& slots, uint32_t hash, uint32_t name)
+        {
+            const size_t mask = slots.size() - 1;
+            size_t i = hash & mask;
+            while (CE_KEY_TABLE_NPOS != slots[i].name) {
+                i = (i + 1) & mask;
+            }
+            slots[i].hash = hash;
+            slots[i].name = name;
+        }
+
+        uint32_t find_key(const ce_key_table* key_table, uint64_t key)
+        {
+            if (key_table->key_slots.empty()) {
+                return CE_KEY_TABLE_NPOS;
+            }
+            const size_t mask = key_table->key_slots.size() - 1;
+            for (size_t i = key_hash(key) & mask; CE_KEY_TABLE_NPOS != key_table->key_slots[i].value; i = (i + 1) & mask) {
+                if (key == key_table->key_slots[i].key) {
+                    return key_table->key_slots[i].value;
+                }
+            }
+            return CE_KEY_TABLE_NPOS;
+        }
+
+        void place_key(std::vector<ce_key_table::key_slot_t>& slots, uint64_t key, uint32_t value)
+        {
+            const size_t mask = slots.size() - 1;
+            size_t i = key_hash(key) & mask;
+            while (CE_KEY_TABLE_NPOS != slots[i].value) {
+                i = (i + 1) & mask;
+            }
+            slots[i].key = key;
+            slots[i].value = value;
+        }
+
+        // keep load factor under 1/2; the first inserted value wins, as linear scans did
+        void insert_key(ce_key_table* key_table, uint64_t key, uint32_t value)
+        {
+            if (CE_KEY_TABLE_NPOS != find_key(key_table, key)) {
+                return;
+            }
+            if (2 * (key_table->key_count + 1) > key_table->key_slots.size()) {
+                std::vector<ce_key_table::key_slot_t> slots(std::max(initial_slot_count, 2 * key_table->key_slots.size()), ce_key_table::key_slot_t{0, CE_KEY_TABLE_NPOS});
+                for (const auto& slot: key_table->key_slots) {
+                    if (CE_KEY_TABLE_NPOS != slot.value) {
+                        place_key(slots, slot.key, slot.value);
+                    }
+                }
+                key_table->key_slots.swap(slots);
+            }
+            place_key(key_table->key_slots, key, value);
+            ++key_table->key_count;
+        }
+    }
+
+    uint32_t ce_key_table_intern(ce_key_table* key_table, const char* name, size_t length)
+    {
+        const uint32_t hash = name_hash(name, length);
+        uint32_t id = find_name(key_table, name, length, hash);
+        if (CE_KEY_TABLE_NPOS != id) {
+            return id;
+        }
+
+        if (2 * (key_table->name_count + 1) > key_table->name_slots.size()) {
+            std::vector<ce_key_table::name_slot_t> slots(std::max(initial_slot_count, 2 * key_table->name_slots.size()), ce_key_table::name_slot_t{0, CE_KEY_TABLE_NPOS});
+            for (const auto& slot: key_table->name_slots) {
+                if (CE_KEY_TABLE_NPOS != slot.name) {
+                    place_name(slots, slot.hash, slot.name);
+                }
+            }
+            key_table->name_slots.swap(slots);
+        }
+
+        id = static_cast<uint32_t>(key_table->names.size());
+        key_table->names.insert(key_table->names.end(), name, name + length);
+        key_table->names.push_back('\0');
+
+        place_name(key_table->name_slots, hash, id);
+        ++key_table->name_count;
+        return id;
+    }
+
+    uint32_t ce_key_table_name(const ce_key_table* key_table, const char* name)
+    {
+        const size_t length = strlen(name);
+        return find_name(key_table, name, length, name_hash(name, length));
+    }
+
+    size_t ce_key_table_add_section(ce_key_table* key_table, const char* name, size_t length)
+    {
+        const uint32_t section_index = static_cast<uint32_t>(key_table->sections.size());
+        const uint32_t id = ce_key_table_intern(key_table, name, length);
+        key_table->sections.push_back({ id, static_cast<uint32_t>(key_table->options.size()), 0, CE_KEY_TABLE_NPOS });
+
+        uint32_t index = find_key(key_table, section_key(id));
+        if (CE_KEY_TABLE_NPOS == index) {
+            insert_key(key_table, section_key(id), section_index);
+        } else {
+            // sections with the same name are rare; chain them in file order
+            while (CE_KEY_TABLE_NPOS != key_table->sections[index].next) {
+                index = key_table->sections[index].next;
+            }
+            key_table->sections[index].next = section_index;
+        }
+        return section_index;
+    }
+
+    size_t ce_key_table_add_option(ce_key_table* key_table, const char* name, size_t length)
+    {
+        const uint32_t option_index = static_cast<uint32_t>(key_table->options.size());
+        const uint32_t id = ce_key_table_intern(key_table, name, length);
+        key_table->options.push_back(id);
+
+        ce_key_table::section_t& section = key_table->sections.back();
+        ++section.option_count;
+
+        insert_key(key_table, option_key(key_table->sections.size() - 1, id), option_index);
+        return option_index;
+    }
+
+    size_t ce_key_table_section_index(const ce_key_table* key_table, const char* section_name)
+    {
+        uint32_t id = ce_key_table_name(key_table, section_name);
+        if (CE_KEY_TABLE_NPOS != id) {
+            uint32_t index = find_key(key_table, section_key(id));
+            if (CE_KEY_TABLE_NPOS != index) {
+                return index;
+            }
+        }
+        return key_table->sections.size();
+    }
+
+    uint32_t ce_key_table_option_index(const ce_key_table* key_table, size_t section_index, const char* option_name)
+    {
+        uint32_t id = ce_key_table_name(key_table, option_name);
+        return CE_KEY_TABLE_NPOS != id ? find_key(key_table, option_key(section_index, id)) : CE_KEY_TABLE_NPOS;
+    }
+}
@@ -18,6 +18,8 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
+
 #include "alloc.hpp"
 #include "material.hpp"
 
@@ -26,6 +28,7 @@ namespace cursedearth
     ce_material* ce_material_new(void)
     {
         ce_material* material = (ce_material*)ce_alloc_zero(sizeof(ce_material));
+        material->ref_count = 1;
         material->mode = CE_MATERIAL_MODE_MODULATE;
         ce_color_init(&material->ambient, 0.2f, 0.2f, 0.2f, 1.0f);
         ce_color_init(&material->diffuse, 0.8f, 0.8f, 0.8f, 1.0f);
@@ -37,8 +40,11 @@ namespace cursedearth
     void ce_material_del(ce_material* material)
     {
         if (NULL != material) {
-            ce_shader_del(material->shader);
-            ce_free(material, sizeof(ce_material));
+            assert(material->ref_count > 0);
+            if (0 == --material->ref_count) {
+                ce_shader_del(material->shader);
+                ce_free(material, sizeof(ce_material));
+            }
         }
     }
 }
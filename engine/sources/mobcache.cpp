@@ -0,0 +1,453 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "alloc.hpp"
+#include "logging.hpp"
+#include "byteorder.hpp"
+#include "utility.hpp"
+#include "mobcache.hpp"
+
+namespace cursedearth
+{
+    namespace fs = boost::filesystem;
+    namespace ip = boost::interprocess;
+
+    const uint32_t CE_MOB_CACHE_SIGNATURE = 0x434d4543; // CEMC
+
+    typedef enum {
+        CE_MOB_CACHE_TABLE_TYPES,
+        CE_MOB_CACHE_TABLE_IDS,
+        CE_MOB_CACHE_TABLE_PARENT_IDS,
+        CE_MOB_CACHE_TABLE_OWNERS,
+        CE_MOB_CACHE_TABLE_QUESTS,
+        CE_MOB_CACHE_TABLE_SHADOWS,
+        CE_MOB_CACHE_TABLE_POSITIONS,
+        CE_MOB_CACHE_TABLE_ROTATIONS,
+        CE_MOB_CACHE_TABLE_COMPLECTIONS,
+        CE_MOB_CACHE_TABLE_NAMES,
+        CE_MOB_CACHE_TABLE_MODEL_NAMES,
+        CE_MOB_CACHE_TABLE_PARENT_NAMES,
+        CE_MOB_CACHE_TABLE_PRIMARY_TEXTURES,
+        CE_MOB_CACHE_TABLE_SECONDARY_TEXTURES,
+        CE_MOB_CACHE_TABLE_COMMENTS,
+        CE_MOB_CACHE_TABLE_QUEST_INFOS,
+        CE_MOB_CACHE_TABLE_PART_OFFSETS,
+        CE_MOB_CACHE_TABLE_PARTS,
+        CE_MOB_CACHE_TABLE_STRINGS,
+        CE_MOB_CACHE_TABLE_COUNT
+    } ce_mob_cache_table;
+
+    /**
+     * @brief on-disk header; all tables follow it, each one 8-byte aligned
+     */
+    struct ce_mob_cache_header {
+        uint32_t signature;
+        uint32_t version;
+        uint64_t source_size;
+        int64_t source_mtime;
+        uint64_t source_hash;
+        uint32_t name, script;
+        uint32_t object_count;
+        uint32_t part_count;
+        uint32_t string_pool_size;
+        uint32_t table_offsets[CE_MOB_CACHE_TABLE_COUNT];
+    };
+
+    struct ce_mob_cache_impl {
+        std::vector<uint8_t> image; // compiled in memory
+        ip::file_mapping mapping;
+        ip::mapped_region region;
+    };
+
+    // first entry of any pool is an empty string: length (4 bytes) + null character
+    const uint32_t CE_MOB_CACHE_EMPTY_STRING = 4;
+
+    struct ce_mob_cache_string_pool {
+        std::vector<char> data;
+        std::unordered_map<std::string, uint32_t> offsets;
+    };
+
+    uint32_t ce_mob_cache_intern(ce_mob_cache_string_pool& pool, const char* str, size_t length)
+    {
+        std::string key(str, length);
+        auto iterator = pool.offsets.find(key);
+        if (pool.offsets.end() != iterator) {
+            return iterator->second;
+        }
+
+        // keep lengths aligned
+        pool.data.resize((pool.data.size() + 3) & ~size_t(3));
+
+        const uint32_t length32 = length;
+        const char* length_bytes = reinterpret_cast<const char*>(&length32);
+        pool.data.insert(pool.data.end(), length_bytes, length_bytes + 4);
+
+        const uint32_t offset = pool.data.size();
+        pool.data.insert(pool.data.end(), str, str + length);
+        pool.data.push_back('\0');
+
+        pool.offsets.emplace(std::move(key), offset);
+        return offset;
+    }
+
+    uint32_t ce_mob_cache_intern(ce_mob_cache_string_pool& pool, const ce_string* string)
+    {
+        return NULL == string ? CE_MOB_CACHE_EMPTY_STRING : ce_mob_cache_intern(pool, string->str, string->length);
+    }
+
+    template <typename T>
+    void ce_mob_cache_append(std::vector<uint8_t>& image, ce_mob_cache_header& header, ce_mob_cache_table table, const std::vector<T>& values)
+    {
+        image.resize((image.size() + 7) & ~size_t(7));
+        header.table_offsets[table] = image.size();
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        image.insert(image.end(), bytes, bytes + sizeof(T) * values.size());
+    }
+
+    template <typename T>
+    const T* ce_mob_cache_table_ptr(const uint8_t* image, size_t size, const ce_mob_cache_header* header, ce_mob_cache_table table, size_t count)
+    {
+        const size_t offset = header->table_offsets[table];
+        if (0 != offset % alignof(T) || offset > size || count > (size - offset) / sizeof(T)) {
+            return NULL;
+        }
+        return reinterpret_cast<const T*>(image + offset);
+    }
+
+    bool ce_mob_cache_check_strings(const ce_mob_cache* mob_cache, const uint32_t* offsets, size_t count, size_t pool_size)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            if (offsets[i] < 4 || offsets[i] >= pool_size || 0 != offsets[i] % 4 ||
+                    ce_mob_cache_string_length(mob_cache, offsets[i]) >= pool_size - offsets[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ce_mob_cache_bind(ce_mob_cache* mob_cache, const uint8_t* image, size_t size)
+    {
+        if (size < sizeof(ce_mob_cache_header)) {
+            return false;
+        }
+
+        const ce_mob_cache_header* header = reinterpret_cast<const ce_mob_cache_header*>(image);
+        if (CE_MOB_CACHE_SIGNATURE != header->signature || CE_MOB_CACHE_VERSION != header->version) {
+            return false;
+        }
+
+        const size_t n = header->object_count;
+
+        mob_cache->source_size = header->source_size;
+        mob_cache->source_mtime = header->source_mtime;
+        mob_cache->source_hash = header->source_hash;
+        mob_cache->name = header->name;
+        mob_cache->script = header->script;
+        mob_cache->object_count = header->object_count;
+        mob_cache->types = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_TYPES, n);
+        mob_cache->ids = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_IDS, n);
+        mob_cache->parent_ids = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_PARENT_IDS, n);
+        mob_cache->owners = ce_mob_cache_table_ptr<uint8_t>(image, size, header, CE_MOB_CACHE_TABLE_OWNERS, n);
+        mob_cache->quests = ce_mob_cache_table_ptr<uint8_t>(image, size, header, CE_MOB_CACHE_TABLE_QUESTS, n);
+        mob_cache->shadows = ce_mob_cache_table_ptr<uint8_t>(image, size, header, CE_MOB_CACHE_TABLE_SHADOWS, n);
+        mob_cache->positions = ce_mob_cache_table_ptr<float>(image, size, header, CE_MOB_CACHE_TABLE_POSITIONS, 3 * n);
+        mob_cache->rotations = ce_mob_cache_table_ptr<float>(image, size, header, CE_MOB_CACHE_TABLE_ROTATIONS, 4 * n);
+        mob_cache->complections = ce_mob_cache_table_ptr<float>(image, size, header, CE_MOB_CACHE_TABLE_COMPLECTIONS, 3 * n);
+        mob_cache->names = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_NAMES, n);
+        mob_cache->model_names = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_MODEL_NAMES, n);
+        mob_cache->parent_names = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_PARENT_NAMES, n);
+        mob_cache->primary_textures = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_PRIMARY_TEXTURES, n);
+        mob_cache->secondary_textures = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_SECONDARY_TEXTURES, n);
+        mob_cache->comments = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_COMMENTS, n);
+        mob_cache->quest_infos = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_QUEST_INFOS, n);
+        mob_cache->part_offsets = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_PART_OFFSETS, n + 1);
+        mob_cache->parts = ce_mob_cache_table_ptr<uint32_t>(image, size, header, CE_MOB_CACHE_TABLE_PARTS, header->part_count);
+        mob_cache->strings = ce_mob_cache_table_ptr<char>(image, size, header, CE_MOB_CACHE_TABLE_STRINGS, header->string_pool_size);
+
+        const void* tables[] = {
+            mob_cache->types, mob_cache->ids, mob_cache->parent_ids,
+            mob_cache->owners, mob_cache->quests, mob_cache->shadows,
+            mob_cache->positions, mob_cache->rotations, mob_cache->complections,
+            mob_cache->names, mob_cache->model_names, mob_cache->parent_names,
+            mob_cache->primary_textures, mob_cache->secondary_textures,
+            mob_cache->comments, mob_cache->quest_infos,
+            mob_cache->part_offsets, mob_cache->parts, mob_cache->strings
+        };
+
+        for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); ++i) {
+            if (NULL == tables[i]) {
+                return false;
+            }
+        }
+
+        // do not trust the image: a corrupted cache must not crash the loader
+        const size_t pool_size = header->string_pool_size;
+        if (pool_size <= CE_MOB_CACHE_EMPTY_STRING || 0 != header->table_offsets[CE_MOB_CACHE_TABLE_STRINGS] % 4 || '\0' != mob_cache->strings[pool_size - 1]) {
+            return false;
+        }
+
+        if (0 != mob_cache->part_offsets[0] || header->part_count != mob_cache->part_offsets[n]) {
+            return false;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (mob_cache->part_offsets[i] > mob_cache->part_offsets[i + 1]) {
+                return false;
+            }
+        }
+
+        const uint32_t level_strings[] = { header->name, header->script };
+        const uint32_t* object_strings[] = {
+            mob_cache->names, mob_cache->model_names, mob_cache->parent_names,
+            mob_cache->primary_textures, mob_cache->secondary_textures,
+            mob_cache->comments, mob_cache->quest_infos
+        };
+
+        if (!ce_mob_cache_check_strings(mob_cache, level_strings, 2, pool_size) ||
+                !ce_mob_cache_check_strings(mob_cache, mob_cache->parts, header->part_count, pool_size)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < sizeof(object_strings) / sizeof(object_strings[0]); ++i) {
+            if (!ce_mob_cache_check_strings(mob_cache, object_strings[i], n, pool_size)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    ce_mob_cache* ce_mob_cache_new(const ce_mob_file* mob_file, uint64_t source_size, int64_t source_mtime, uint64_t source_hash)
+    {
+        const size_t n = NULL == mob_file->objects ? 0 : mob_file->objects->count;
+
+        ce_mob_cache_string_pool pool;
+        ce_mob_cache_intern(pool, "", 0);
+
+        ce_mob_cache_header header;
+        memset(&header, 0, sizeof(header));
+        header.signature = CE_MOB_CACHE_SIGNATURE;
+        header.version = CE_MOB_CACHE_VERSION;
+        header.source_size = source_size;
+        header.source_mtime = source_mtime;
+        header.source_hash = source_hash;
+        header.name = ce_mob_cache_intern(pool, mob_file->name);
+        header.script = ce_mob_cache_intern(pool, mob_file->script);
+        header.object_count = n;
+
+        std::vector<uint32_t> types(n), ids(n), parent_ids(n);
+        std::vector<uint8_t> owners(n), quests(n), shadows(n);
+        std::vector<float> positions(3 * n), rotations(4 * n), complections(3 * n);
+        std::vector<uint32_t> names(n), model_names(n), parent_names(n);
+        std::vector<uint32_t> primary_textures(n), secondary_textures(n);
+        std::vector<uint32_t> comments(n), quest_infos(n);
+        std::vector<uint32_t> part_offsets(n + 1), parts;
+
+        for (size_t i = 0; i < n; ++i) {
+            const ce_mob_object* mob_object = (const ce_mob_object*)mob_file->objects->items[i];
+
+            types[i] = mob_object->type;
+            ids[i] = mob_object->id;
+            parent_ids[i] = mob_object->parent_id;
+            owners[i] = mob_object->owner;
+            quests[i] = mob_object->quest;
+            shadows[i] = mob_object->shadow;
+
+            memcpy(positions.data() + 3 * i, mob_object->position, sizeof(float) * 3);
+            memcpy(rotations.data() + 4 * i, mob_object->rotation, sizeof(float) * 4);
+            memcpy(complections.data() + 3 * i, mob_object->complection, sizeof(float) * 3);
+
+            names[i] = ce_mob_cache_intern(pool, mob_object->name);
+            model_names[i] = ce_mob_cache_intern(pool, mob_object->model_name);
+            parent_names[i] = ce_mob_cache_intern(pool, mob_object->parent_name);
+            primary_textures[i] = ce_mob_cache_intern(pool, mob_object->primary_texture);
+            secondary_textures[i] = ce_mob_cache_intern(pool, mob_object->secondary_texture);
+            comments[i] = ce_mob_cache_intern(pool, mob_object->comment);
+            quest_infos[i] = ce_mob_cache_intern(pool, mob_object->quest_info);
+
+            part_offsets[i] = parts.size();
+            if (NULL != mob_object->parts) {
+                for (size_t j = 0; j < mob_object->parts->count; ++j) {
+                    parts.push_back(ce_mob_cache_intern(pool, (const ce_string*)mob_object->parts->items[j]));
+                }
+            }
+        }
+
+        part_offsets[n] = parts.size();
+
+        header.part_count = parts.size();
+        header.string_pool_size = pool.data.size();
+
+        ce_mob_cache_impl* impl = new ce_mob_cache_impl;
+        std::vector<uint8_t>& image = impl->image;
+        image.resize(sizeof(ce_mob_cache_header));
+
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_TYPES, types);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_IDS, ids);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_PARENT_IDS, parent_ids);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_OWNERS, owners);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_QUESTS, quests);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_SHADOWS, shadows);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_POSITIONS, positions);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_ROTATIONS, rotations);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_COMPLECTIONS, complections);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_NAMES, names);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_MODEL_NAMES, model_names);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_PARENT_NAMES, parent_names);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_PRIMARY_TEXTURES, primary_textures);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_SECONDARY_TEXTURES, secondary_textures);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_COMMENTS, comments);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_QUEST_INFOS, quest_infos);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_PART_OFFSETS, part_offsets);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_PARTS, parts);
+        ce_mob_cache_append(image, header, CE_MOB_CACHE_TABLE_STRINGS, pool.data);
+
+        memcpy(image.data(), &header, sizeof(header));
+
+        ce_mob_cache* mob_cache = (ce_mob_cache*)ce_alloc_zero(sizeof(ce_mob_cache));
+        mob_cache->impl = impl;
+
+        bool ok = ce_mob_cache_bind(mob_cache, image.data(), image.size());
+        assert(ok && "inconsistent mob cache image");
+        (void)ok;
+
+        return mob_cache;
+    }
+
+    ce_mob_cache* ce_mob_cache_open(const fs::path& path)
+    {
+        if (endian_t::little != host_order()) {
+            return NULL;
+        }
+
+        ce_mob_cache_impl* impl = new ce_mob_cache_impl;
+        try {
+            ip::file_mapping mapping(path.string().c_str(), ip::read_only);
+            ip::mapped_region region(mapping, ip::read_only);
+            impl->mapping.swap(mapping);
+            impl->region.swap(region);
+        } catch (const ip::interprocess_exception& error) {
+            ce_logging_error("mob cache: could not map `%s': %s", path.string().c_str(), error.what());
+            delete impl;
+            return NULL;
+        }
+
+        ce_mob_cache* mob_cache = (ce_mob_cache*)ce_alloc_zero(sizeof(ce_mob_cache));
+        mob_cache->impl = impl;
+
+        if (!ce_mob_cache_bind(mob_cache, static_cast<const uint8_t*>(impl->region.get_address()), impl->region.get_size())) {
+            ce_logging_warning("mob cache: `%s' is corrupted or outdated", path.string().c_str());
+            ce_mob_cache_del(mob_cache);
+            return NULL;
+        }
+
+        return mob_cache;
+    }
+
+    void ce_mob_cache_del(ce_mob_cache* mob_cache)
+    {
+        if (NULL != mob_cache) {
+            delete static_cast<ce_mob_cache_impl*>(mob_cache->impl);
+            ce_free(mob_cache, sizeof(ce_mob_cache));
+        }
+    }
+
+    void ce_mob_cache_write(const uint8_t* image, size_t image_size, const fs::path& path)
+    {
+        boost::system::error_code error_code;
+        fs::create_directories(path.parent_path(), error_code);
+
+        // several processes may compile the same level at the same time
+        fs::path temporary_path = path;
+        temporary_path += fs::unique_path(".%%%%-%%%%");
+
+        FILE* file = fopen(temporary_path.string().c_str(), "wb");
+        if (NULL == file) {
+            ce_logging_error("mob cache: could not save file `%s'", path.string().c_str());
+            return;
+        }
+
+        const size_t size = fwrite(image, 1, image_size, file);
+        fclose(file);
+
+        if (image_size == size) {
+            fs::rename(temporary_path, path, error_code);
+        }
+
+        if (image_size != size || error_code) {
+            ce_logging_error("mob cache: could not save file `%s'", path.string().c_str());
+            fs::remove(temporary_path, error_code);
+        }
+    }
+
+    void ce_mob_cache_save(const ce_mob_cache* mob_cache, const fs::path& path)
+    {
+        const ce_mob_cache_impl* impl = static_cast<const ce_mob_cache_impl*>(mob_cache->impl);
+
+        // only images compiled in memory on little-endian hosts are suitable
+        if (impl->image.empty() || endian_t::little != host_order()) {
+            return;
+        }
+
+        ce_mob_cache_write(impl->image.data(), impl->image.size(), path);
+    }
+
+    void ce_mob_cache_restamp(ce_mob_cache* mob_cache, int64_t source_mtime, const fs::path& path)
+    {
+        const ce_mob_cache_impl* impl = static_cast<const ce_mob_cache_impl*>(mob_cache->impl);
+        if (NULL == impl->region.get_address()) {
+            return;
+        }
+
+        // the mapping is read-only: write a patched copy, the old file stays mapped until it's closed
+        const uint8_t* region = static_cast<const uint8_t*>(impl->region.get_address());
+        std::vector<uint8_t> image(region, region + impl->region.get_size());
+        reinterpret_cast<ce_mob_cache_header*>(image.data())->source_mtime = source_mtime;
+
+        ce_mob_cache_write(image.data(), image.size(), path);
+        mob_cache->source_mtime = source_mtime;
+    }
+
+    uint64_t ce_mob_cache_hash_source(const fs::path& path)
+    {
+        uint64_t hash = g_fnv1a64_basis;
+        FILE* file = fopen(path.string().c_str(), "rb");
+        if (NULL != file) {
+            std::vector<uint8_t> buffer(64 * 1024);
+            size_t size;
+            while (0 != (size = fread(buffer.data(), 1, buffer.size(), file))) {
+                hash = fnv1a64(buffer.data(), size, hash);
+            }
+            fclose(file);
+        }
+        return hash;
+    }
+}
@@ -20,7 +20,10 @@
 
 #include <cstdio>
 #include <cstring>
+#include <tuple>
+#include <functional>
 #include <algorithm>
+#include <unordered_set>
 
 #include "alloc.hpp"
 #include "utility.hpp"
@@ -28,7 +31,9 @@
 #include "event.hpp"
 #include "threadpool.hpp"
 #include "rendersystem.hpp"
+#include "mprhelpers.hpp"
 #include "figuremanager.hpp"
+#include "texturemanager.hpp"
 #include "mobmanager.hpp"
 #include "mobloader.hpp"
 
@@ -36,21 +41,94 @@ namespace cursedearth
 {
     struct ce_mob_loader* ce_mob_loader;
 
+    enum {
+        CE_MOB_LOADER_BATCH_SIZE = 64,
+    };
+
     typedef struct {
-        ce_mob_task* mob_task;
-        const char* model_name;
+        ce_figproto* figproto; // reference taken by the worker
+        ce_figbone* figbone;
+        float height;
         vector3_t position;
         quaternion_t orientation;
         complection_t complection;
         const char* textures[2 + 1]; // NULL-terminated
         const char* parts[32]; // NULL-terminated
-    } ce_mob_object_event;
+    } ce_mob_entry;
+
+    /*
+     *  Objects are prepared on workers in batches: protos are resolved,
+     *  bones built and heights computed there. The render thread receives
+     *  one event per batch and only creates meshes and entities (GL work).
+     */
+    typedef struct {
+        ce_mob_task* mob_task;
+        size_t first_index;
+        size_t object_count;
+        ce_mob_entry entries[CE_MOB_LOADER_BATCH_SIZE];
+    } ce_mob_batch;
 
-    void ce_mob_object_event_react(ce_event* event)
+    void ce_mob_loader_enqueue(const std::function<void ()>& job)
     {
-        ce_mob_object_event* mob_event = (ce_mob_object_event*)event->impl;
-        ce_mob_task* mob_task = mob_event->mob_task;
-        ce_figure_manager_create_entity(mob_event->model_name, &mob_event->complection, &mob_event->position, &mob_event->orientation, mob_event->parts, mob_event->textures);
+        {
+            std::lock_guard<std::mutex> lock(*ce_mob_loader->mutex);
+            std::ignore = lock;
+            ++ce_mob_loader->worker_job_count;
+        }
+        thread_pool_t::instance()->enqueue(job);
+    }
+
+    void ce_mob_loader_finish_job()
+    {
+        std::lock_guard<std::mutex> lock(*ce_mob_loader->mutex);
+        std::ignore = lock;
+        if (0 == --ce_mob_loader->worker_job_count) {
+            ce_mob_loader->idle->notify_all();
+        }
+    }
+
+    ce_mob_batch* ce_mob_batch_new(ce_mob_task* mob_task, size_t first_index, size_t object_count)
+    {
+        ce_mob_batch* mob_batch = (ce_mob_batch*)ce_alloc_zero(sizeof(ce_mob_batch));
+        mob_batch->mob_task = mob_task;
+        mob_batch->first_index = first_index;
+        mob_batch->object_count = object_count;
+        return mob_batch;
+    }
+
+    void ce_mob_batch_del(ce_mob_batch* mob_batch)
+    {
+        if (NULL != mob_batch) {
+            for (size_t i = 0; i < mob_batch->object_count; ++i) {
+                ce_figbone_del(mob_batch->entries[i].figbone);
+                ce_figproto_del(mob_batch->entries[i].figproto);
+            }
+            ce_free(mob_batch, sizeof(ce_mob_batch));
+        }
+    }
+
+    void ce_mob_batch_react(ce_event* event)
+    {
+        ce_mob_batch* mob_batch = (ce_mob_batch*)((ce_event_ptr*)event->impl)->ptr;
+        ce_mob_task* mob_task = mob_batch->mob_task;
+
+        // protos loaded by workers must reach the render queue before use
+        ce_figure_manager_flush_protos();
+
+        for (size_t i = 0; i < mob_batch->object_count; ++i) {
+            ce_mob_entry* mob_entry = mob_batch->entries + i;
+            if (NULL != mob_entry->figproto) {
+                ce_figentity* figentity = ce_figure_manager_create_entity_proto(mob_entry->figproto, &mob_entry->complection,
+                    &mob_entry->position, &mob_entry->orientation, mob_entry->parts, mob_entry->textures, mob_entry->figbone);
+                mob_entry->figbone = NULL; // entity takes ownership
+
+                if (NULL != figentity && NULL != mob_task->mprfile) {
+                    ce_figentity_fix_height(figentity, mob_entry->height);
+                }
+            }
+        }
+
+        ce_mob_batch_del(mob_batch);
 
         if (++mob_task->processed_event_count == mob_task->posted_event_count) {
             ce_logging_info("mob task: done loading `%s'", mob_task->name->str);
@@ -66,64 +144,100 @@ namespace cursedearth
         }
     }
 
-    void ce_mob_task_exec(ce_mob_task* mob_task)
+    void ce_mob_batch_exec(ce_mob_batch* mob_batch)
     {
-        mob_task->mob_file = ce_mob_manager_open(mob_task->name->str);
-        if (NULL == mob_task->mob_file) {
-            ce_logging_error("mob task: could not load `%s'", mob_task->name->str);
-            return;
-        }
+        const ce_mob_task* mob_task = mob_batch->mob_task;
+        const ce_mob_cache* mob_cache = mob_task->mob_cache;
 
-        mob_task->posted_event_count = mob_task->mob_file->objects->count;
-
-        ce_logging_info("mob task: loading `%s'...", mob_task->name->str);
-        ce_logging_info("mob task: posting %zu events...", mob_task->posted_event_count);
+        for (size_t i = 0; i < mob_batch->object_count; ++i) {
+            const size_t index = mob_batch->first_index + i;
+            ce_mob_entry* mob_entry = mob_batch->entries + i;
 
-        for (size_t i = 0; i < mob_task->mob_file->objects->count; ++i) {
-            ce_mob_object* mob_object = (ce_mob_object*)mob_task->mob_file->objects->items[i];
-            ce_event* event = ce_event_new(ce_mob_object_event_react, sizeof(ce_mob_object_event));
-            ce_mob_object_event* mob_object_event = (ce_mob_object_event*)event->impl;
-
-            mob_object_event->mob_task = mob_task;
-            mob_object_event->model_name = mob_object->model_name->str;
-
-            ce_vec3_init_array(&mob_object_event->position, mob_object->position);
-            std::swap(mob_object_event->position.y, mob_object_event->position.z);
+            ce_vec3_init_array(&mob_entry->position, mob_cache->positions + 3 * index);
+            std::swap(mob_entry->position.y, mob_entry->position.z);
 
             // FIXME: GL's hard-code
-            mob_object_event->position.z = -mob_object_event->position.z;
+            mob_entry->position.z = -mob_entry->position.z;
 
             quaternion_t quat1, quat2;
-            ce_quat_init_array(&quat1, mob_object->rotation);
+            ce_quat_init_array(&quat1, mob_cache->rotations + 4 * index);
             ce_quat_init_polar(&quat2, deg2rad(-90.0f), &CE_VEC3_UNIT_X);
-            ce_quat_mul(&mob_object_event->orientation, &quat2, &quat1);
+            ce_quat_mul(&mob_entry->orientation, &quat2, &quat1);
+
+            ce_complection_init_array(&mob_entry->complection, mob_cache->complections + 3 * index);
+
+            const size_t part_count = ce_mob_cache_part_count(mob_cache, index);
+            for (size_t j = 0; j < part_count; ++j) {
+                mob_entry->parts[j] = ce_mob_cache_string(mob_cache, mob_cache->parts[mob_cache->part_offsets[index] + j]);
+            }
+
+            mob_entry->textures[0] = ce_mob_cache_string(mob_cache, mob_cache->primary_textures[index]);
+            mob_entry->textures[1] = ce_mob_cache_string(mob_cache, mob_cache->secondary_textures[index]);
+
+            mob_entry->figproto = ce_figure_manager_resolve_proto(ce_mob_cache_string(mob_cache, mob_cache->model_names[index]));
+            if (NULL != mob_entry->figproto) {
+                mob_entry->figbone = ce_figbone_new(mob_entry->figproto->fignode, &mob_entry->complection, NULL);
+            }
+
+            if (NULL != mob_task->mprfile) {
+                mob_entry->height = ce_mpr_get_height(mob_task->mprfile, &mob_entry->position);
+            }
+        }
+
+        ce_event_manager_post_ptr(ce_render_system_thread_id(), ce_mob_batch_react, mob_batch);
+        ce_mob_loader_finish_job();
+    }
+
+    void ce_mob_task_exec(ce_mob_task* mob_task)
+    {
+        mob_task->mob_cache = ce_mob_manager_open_cache(mob_task->name->str);
+        if (NULL == mob_task->mob_cache) {
+            ce_logging_error("mob task: could not load `%s'", mob_task->name->str);
+            ce_mob_loader_finish_job();
+            return;
+        }
 
-            ce_complection_init_array(&mob_object_event->complection, mob_object->complection);
+        const size_t object_count = mob_task->mob_cache->object_count;
 
-            for (size_t j = 0; j < mob_object->parts->count; ++j) {
-                ce_string* part = (ce_string*)mob_object->parts->items[j];
-                mob_object_event->parts[j] = part->str;
+        // strings are interned, so equal names share an offset
+        std::vector<std::string> texture_names;
+        std::unordered_set<uint32_t> texture_offsets;
+        for (size_t i = 0; i < object_count; ++i) {
+            for (uint32_t offset: { mob_task->mob_cache->primary_textures[i], mob_task->mob_cache->secondary_textures[i] }) {
+                if (0 != ce_mob_cache_string_length(mob_task->mob_cache, offset) && texture_offsets.insert(offset).second) {
+                    texture_names.push_back(ce_mob_cache_string(mob_task->mob_cache, offset));
+                }
             }
+        }
+        ce_texture_manager_preload(texture_names);
 
-            mob_object_event->textures[0] = mob_object->primary_texture->str;
-            mob_object_event->textures[1] = mob_object->secondary_texture->str;
+        mob_task->posted_event_count = (object_count + CE_MOB_LOADER_BATCH_SIZE - 1) / CE_MOB_LOADER_BATCH_SIZE;
 
-            ce_event_manager_post_event(ce_render_system_thread_id(), event);
+        ce_logging_info("mob task: loading `%s'...", mob_task->name->str);
+        ce_logging_info("mob task: preparing %zu objects in %zu batches...", object_count, mob_task->posted_event_count);
+
+        // counters are final here, batches may be processed in any order
+        for (size_t i = 0; i < object_count; i += CE_MOB_LOADER_BATCH_SIZE) {
+            ce_mob_batch* mob_batch = ce_mob_batch_new(mob_task, i, std::min<size_t>(CE_MOB_LOADER_BATCH_SIZE, object_count - i));
+            ce_mob_loader_enqueue(std::bind(ce_mob_batch_exec, mob_batch));
         }
+
+        ce_mob_loader_finish_job();
     }
 
-    ce_mob_task* ce_mob_task_new(const char* name)
+    ce_mob_task* ce_mob_task_new(const char* name, const ce_mprfile* mprfile)
     {
         ce_mob_task* mob_task = (ce_mob_task*)ce_alloc_zero(sizeof(ce_mob_task));
         mob_task->name = ce_string_new_str(name);
-        thread_pool_t::instance()->enqueue(std::bind(ce_mob_task_exec, mob_task));
+        mob_task->mprfile = mprfile;
+        ce_mob_loader_enqueue(std::bind(ce_mob_task_exec, mob_task));
         return mob_task;
     }
 
     void ce_mob_task_del(ce_mob_task* mob_task)
     {
         if (NULL != mob_task) {
-            ce_mob_file_close(mob_task->mob_file);
+            ce_mob_cache_del(mob_task->mob_cache);
             ce_string_del(mob_task->name);
             ce_free(mob_task, sizeof(ce_mob_task));
         }
@@ -133,6 +247,8 @@ namespace cursedearth
     {
         ce_mob_loader = (struct ce_mob_loader*)ce_alloc_zero(sizeof(struct ce_mob_loader));
         ce_mob_loader->mob_tasks = ce_vector_new_reserved(2);
+        ce_mob_loader->mutex = new std::mutex;
+        ce_mob_loader->idle = new std::condition_variable;
     }
 
     void ce_mob_loader_term(void)
@@ -140,14 +256,35 @@ namespace cursedearth
         if (NULL != ce_mob_loader) {
             ce_vector_for_each(ce_mob_loader->mob_tasks, (void(*)(void*))ce_mob_task_del);
             ce_vector_del(ce_mob_loader->mob_tasks);
+            delete ce_mob_loader->idle;
+            delete ce_mob_loader->mutex;
             ce_free(ce_mob_loader, sizeof(struct ce_mob_loader));
         }
     }
 
-    void ce_mob_loader_load_mob(const std::string& name)
+    void ce_mob_loader_load_mob(const std::string& name, const ce_mprfile* mprfile)
     {
         ++ce_mob_loader->queued_job_count;
-        ce_vector_push_back(ce_mob_loader->mob_tasks, ce_mob_task_new(name.c_str()));
+        ce_vector_push_back(ce_mob_loader->mob_tasks, ce_mob_task_new(name.c_str(), mprfile));
         ce_logging_info("mob loader: '%s' queued", name.c_str());
     }
+
+    void ce_mob_loader_release_mprfile(const ce_mprfile* mprfile)
+    {
+        if (NULL == mprfile) {
+            return;
+        }
+
+        // batches read heights on workers, so none of them may outlive the mpr file
+        std::unique_lock<std::mutex> lock(*ce_mob_loader->mutex);
+        ce_mob_loader->idle->wait(lock, [] { return 0 == ce_mob_loader->worker_job_count; });
+        lock.unlock();
+
+        for (size_t i = 0; i < ce_mob_loader->mob_tasks->count; ++i) {
+            ce_mob_task* mob_task = (ce_mob_task*)ce_mob_loader->mob_tasks->items[i];
+            if (mprfile == mob_task->mprfile) {
+                mob_task->mprfile = NULL;
+            }
+        }
+    }
 }
@@ -35,6 +35,8 @@ namespace cursedearth
 
     const std::vector<std::string> ce_mob_dirs = { "Maps" };
     const std::vector<std::string> ce_mob_exts = { ".mob" };
+    const std::vector<std::string> ce_mob_cache_dirs = { "Cache" };
+    const std::vector<std::string> ce_mob_cache_exts = { ".mobc" };
 
     void ce_mob_manager_init(void)
     {
@@ -42,6 +44,10 @@ namespace cursedearth
             fs::path path = option_manager_t::instance()->ei_path() / dir;
             ce_logging_info("mob manager: using path `%s'", path.string().c_str());
         }
+        for (const auto& dir: ce_mob_cache_dirs) {
+            fs::path path = option_manager_t::instance()->ce_path() / dir;
+            ce_logging_info("mob manager: using cache path `%s'", path.string().c_str());
+        }
         ce_mob_manager = (struct ce_mob_manager*)ce_alloc_zero(sizeof(struct ce_mob_manager));
     }
 
@@ -75,4 +81,56 @@ namespace cursedearth
         }
         return NULL;
     }
+
+    ce_mob_cache* ce_mob_manager_open_cache(const std::string& name)
+    {
+        fs::path path = find_mob_resource(name);
+        if (path.empty()) {
+            return NULL;
+        }
+
+        boost::system::error_code error_code;
+        const uint64_t source_size = file_size(path, error_code);
+        const int64_t source_mtime = last_write_time(path, error_code);
+
+        const fs::path cache_path = option_manager_t::instance()->ce_path() / ce_mob_cache_dirs[0] / (name + ce_mob_cache_exts[0]);
+
+        // the hash only serves the cache: computed at most once, and not at all without caching
+        const bool level_caching = option_manager_t::instance()->level_caching();
+        uint64_t source_hash = 0;
+
+        if (level_caching && exists(cache_path)) {
+            ce_mob_cache* mob_cache = ce_mob_cache_open(cache_path);
+            if (NULL != mob_cache && source_size == mob_cache->source_size) {
+                if (source_mtime == mob_cache->source_mtime) {
+                    return mob_cache;
+                }
+                // a touched but unchanged mob file is still valid; restamp it to skip hashing next time
+                source_hash = ce_mob_cache_hash_source(path);
+                if (source_hash == mob_cache->source_hash) {
+                    ce_mob_cache_restamp(mob_cache, source_mtime, cache_path);
+                    return mob_cache;
+                }
+            }
+            ce_mob_cache_del(mob_cache);
+        }
+
+        ce_mob_file* mob_file = ce_mob_file_open(path);
+        if (NULL == mob_file) {
+            return NULL;
+        }
+
+        if (level_caching && 0 == source_hash) {
+            source_hash = ce_mob_cache_hash_source(path);
+        }
+
+        ce_mob_cache* mob_cache = ce_mob_cache_new(mob_file, source_size, source_mtime, source_hash);
+        ce_mob_file_close(mob_file);
+
+        if (level_caching) {
+            ce_mob_cache_save(mob_cache, cache_path);
+        }
+
+        return mob_cache;
+    }
 }
@@ -21,11 +21,13 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
 #include "alloc.hpp"
 #include "byteorder.hpp"
-#include "resball.hpp"
+#include "semaphore.hpp"
+#include "threadpool.hpp"
 #include "mprfile.hpp"
 
 namespace cursedearth
@@ -33,75 +35,110 @@ namespace cursedearth
     const unsigned int MP_SIGNATURE = 0xce4af672;
     const unsigned int SEC_SIGNATURE = 0xcf4bf774;
 
-    void read_vertex(ce_mprvertex* ver, ce_mem_file* mem)
+    // vertices are stored packed exactly as ce_mprvertex is laid out
+    static_assert(sizeof(ce_mprvertex) == 8, "unexpected vertex layout");
+
+    // signature and water flag precede the vertices in a sector payload;
+    // the padding places the vertex arrays at an aligned offset
+    const size_t SEC_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint8_t);
+    const size_t SEC_PADDING = sizeof(ce_mprvertex) - SEC_HEADER_SIZE;
+
+    void convert_sector(ce_mprsector* sec, unsigned int layer_count)
     {
-        ce_mem_file_read(mem, &ver->offset_x, sizeof(int8_t), 1);
-        ce_mem_file_read(mem, &ver->offset_z, sizeof(int8_t), 1);
-        ce_mem_file_read(mem, &ver->coord_y, sizeof(uint16_t), 1);
-        ce_mem_file_read(mem, &ver->normal, sizeof(uint32_t), 1);
-        ver->coord_y = le2cpu(ver->coord_y);
-        ver->normal = le2cpu(ver->normal);
+        ce_mprvertex* vertices[] = { sec->land_vertices, sec->water_vertices };
+        uint16_t* textures[] = { sec->land_textures, sec->water_textures, reinterpret_cast<uint16_t*>(sec->water_allow) };
+
+        for (unsigned int j = 0; j < layer_count; ++j) {
+            for (unsigned int i = 0; i < CE_MPRFILE_VERTEX_COUNT; ++i) {
+                vertices[j][i].coord_y = le2cpu(vertices[j][i].coord_y);
+                vertices[j][i].normal = le2cpu(vertices[j][i].normal);
+            }
+        }
+
+        for (unsigned int j = 0; j < 2 * layer_count - 1; ++j) {
+            for (unsigned int i = 0; i < CE_MPRFILE_TEXTURE_COUNT; ++i) {
+                textures[j][i] = le2cpu(textures[j][i]);
+            }
+        }
     }
 
-    void read_sectors(ce_mprfile* mpr, ce_res_file* res)
+    void decode_sector(const ce_mprfile* mpr, size_t index)
     {
-        mpr->sectors = (ce_mprsector*)ce_alloc_zero(sizeof(ce_mprsector) * mpr->sector_x_count * mpr->sector_z_count);
+        ce_mprsector* sec = mpr->sectors + index;
+        size_t node = mpr->sector_nodes[index];
+        size_t size = ce_res_file_node_size(mpr->res_file, node);
 
-        // mpr name + xxxzzz.sec
-        std::vector<char> sec_name(mpr->name->length + 3 + 3 + 4 + 1);
+        // the payload is read once and the sector arrays are mapped onto it
+        sec->size = SEC_PADDING + size;
+        sec->data = ce_alloc(sec->size);
 
-        for (int z = 0, z_count = mpr->sector_z_count; z < z_count; ++z) {
-            for (int x = 0, x_count = mpr->sector_x_count; x < x_count; ++x) {
-                snprintf(sec_name.data(), sec_name.size(), "%s%03d%03d.sec", mpr->name->str, x, z);
+        uint8_t* data = (uint8_t*)sec->data + SEC_PADDING;
+        ce_res_file_node_read(mpr->res_file, node, data);
 
-                ce_mprsector* sec = mpr->sectors + z * x_count + x;
-                ce_mem_file* mem = ce_res_ball_extract_mem_file_by_name(res, sec_name.data());
+        uint32_t signature;
+        memcpy(&signature, data, sizeof(uint32_t));
+        assert(SEC_SIGNATURE == le2cpu(signature) && "wrong signature");
 
-                uint32_t signature;
-                ce_mem_file_read(mem, &signature, sizeof(uint32_t), 1);
-                assert(SEC_SIGNATURE == le2cpu(signature) && "wrong signature");
+        sec->water = data[sizeof(uint32_t)];
 
-                ce_mem_file_read(mem, &sec->water, sizeof(uint8_t), 1);
+        const unsigned int layer_count = 0 != sec->water ? 2 : 1;
+        assert(size >= SEC_HEADER_SIZE + layer_count * sizeof(ce_mprvertex) * CE_MPRFILE_VERTEX_COUNT +
+                       (2 * layer_count - 1) * sizeof(uint16_t) * CE_MPRFILE_TEXTURE_COUNT && "wrong sector size");
 
-                sec->land_vertices = (ce_mprvertex*)ce_alloc(sizeof(ce_mprvertex) * CE_MPRFILE_VERTEX_COUNT);
-                for (unsigned int i = 0; i < CE_MPRFILE_VERTEX_COUNT; ++i) {
-                    read_vertex(sec->land_vertices + i, mem);
-                }
+        ce_mprvertex* vertices = (ce_mprvertex*)(data + SEC_HEADER_SIZE);
+        sec->land_vertices = vertices;
+        vertices += CE_MPRFILE_VERTEX_COUNT;
 
-                if (0 != sec->water) {
-                    sec->water_vertices = (ce_mprvertex*)ce_alloc(sizeof(ce_mprvertex) * CE_MPRFILE_VERTEX_COUNT);
-                    for (unsigned int i = 0; i < CE_MPRFILE_VERTEX_COUNT; ++i) {
-                        read_vertex(sec->water_vertices + i, mem);
-                    }
-                }
+        if (0 != sec->water) {
+            sec->water_vertices = vertices;
+            vertices += CE_MPRFILE_VERTEX_COUNT;
+        }
 
-                sec->land_textures = (uint16_t*)ce_alloc(sizeof(uint16_t) * CE_MPRFILE_TEXTURE_COUNT);
-                ce_mem_file_read(mem, sec->land_textures, sizeof(uint16_t), CE_MPRFILE_TEXTURE_COUNT);
-                for (unsigned int i = 0; i < CE_MPRFILE_TEXTURE_COUNT; ++i) {
-                    sec->land_textures[i] = le2cpu(sec->land_textures[i]);
-                }
+        uint16_t* textures = (uint16_t*)vertices;
+        sec->land_textures = textures;
+        textures += CE_MPRFILE_TEXTURE_COUNT;
 
-                if (0 != sec->water) {
-                    sec->water_textures = (uint16_t*)ce_alloc(sizeof(uint16_t) * CE_MPRFILE_TEXTURE_COUNT);
-                    sec->water_allow = (int16_t*)ce_alloc(sizeof(int16_t) * CE_MPRFILE_TEXTURE_COUNT);
+        if (0 != sec->water) {
+            sec->water_textures = textures;
+            textures += CE_MPRFILE_TEXTURE_COUNT;
+            sec->water_allow = (int16_t*)textures;
+        }
 
-                    ce_mem_file_read(mem, sec->water_textures, sizeof(uint16_t), CE_MPRFILE_TEXTURE_COUNT);
-                    ce_mem_file_read(mem, sec->water_allow, sizeof(int16_t), CE_MPRFILE_TEXTURE_COUNT);
+        if (endian_t::little != host_order()) {
+            convert_sector(sec, layer_count);
+        }
+    }
 
-                    for (unsigned int i = 0; i < CE_MPRFILE_TEXTURE_COUNT; ++i) {
-                        sec->water_textures[i] = le2cpu(sec->water_textures[i]);
-                        sec->water_allow[i] = le2cpu(sec->water_allow[i]);
-                    }
-                }
+    void find_sectors(ce_mprfile* mpr)
+    {
+        const size_t count = mpr->sector_x_count * mpr->sector_z_count;
+        mpr->sectors = (ce_mprsector*)ce_alloc_zero(sizeof(ce_mprsector) * count);
+        mpr->sector_nodes = (size_t*)ce_alloc(sizeof(size_t) * count);
+        mpr->sector_flags = new std::once_flag[count];
 
-                ce_mem_file_del(mem);
+        // mpr name + xxxzzz.sec
+        std::vector<char> sec_name(mpr->name->length + 3 + 3 + 4 + 1);
+
+        for (int z = 0, z_count = mpr->sector_z_count; z < z_count; ++z) {
+            for (int x = 0, x_count = mpr->sector_x_count; x < x_count; ++x) {
+                snprintf(sec_name.data(), sec_name.size(), "%s%03d%03d.sec", mpr->name->str, x, z);
+                size_t node = ce_res_file_node_index(mpr->res_file, sec_name.data());
+                assert(mpr->res_file->node_count != node && "missing sector");
+                mpr->sector_nodes[z * x_count + x] = node;
             }
         }
     }
 
+    inline ce_mprsector* use_sector(const ce_mprfile* mpr, size_t index)
+    {
+        std::call_once(mpr->sector_flags[index], decode_sector, mpr, index);
+        return mpr->sectors + index;
+    }
+
     ce_mprfile* ce_mprfile_open(ce_res_file* res_file)
     {
         ce_mprfile* mprfile = (ce_mprfile*)ce_alloc_zero(sizeof(ce_mprfile));
+        mprfile->res_file = res_file;
 
         // mpr name = res name without extension (.mpr)
         mprfile->name = ce_string_dup_n(res_file->name, res_file->name->length - 4);
@@ -149,7 +186,7 @@ namespace cursedearth
             mprfile->anim_tiles[i] = le2cpu(mprfile->anim_tiles[i]);
         }
 
-        read_sectors(mprfile, res_file);
+        find_sectors(mprfile);
 
         return mprfile;
     }
@@ -158,17 +195,41 @@ namespace cursedearth
     {
         if (NULL != mprfile) {
             ce_free(mprfile->data, mprfile->size);
-            for (int i = 0, n = mprfile->sector_x_count * mprfile->sector_z_count; i < n; ++i) {
-                ce_mprsector* sector = mprfile->sectors + i;
-                ce_free(sector->water_allow, sizeof(int16_t) * CE_MPRFILE_TEXTURE_COUNT);
-                ce_free(sector->water_textures, sizeof(uint16_t) * CE_MPRFILE_TEXTURE_COUNT);
-                ce_free(sector->land_textures, sizeof(uint16_t) * CE_MPRFILE_TEXTURE_COUNT);
-                ce_free(sector->water_vertices, sizeof(ce_mprvertex) * CE_MPRFILE_VERTEX_COUNT);
-                ce_free(sector->land_vertices, sizeof(ce_mprvertex) * CE_MPRFILE_VERTEX_COUNT);
+            const size_t count = mprfile->sector_x_count * mprfile->sector_z_count;
+            for (size_t i = 0; i < count; ++i) {
+                ce_free(mprfile->sectors[i].data, mprfile->sectors[i].size);
             }
-            ce_free(mprfile->sectors, sizeof(ce_mprsector) * mprfile->sector_x_count * mprfile->sector_z_count);
+            delete[] mprfile->sector_flags;
+            ce_free(mprfile->sector_nodes, sizeof(size_t) * count);
+            ce_free(mprfile->sectors, sizeof(ce_mprsector) * count);
+            ce_res_file_del(mprfile->res_file);
             ce_string_del(mprfile->name);
             ce_free(mprfile, sizeof(ce_mprfile));
         }
     }
+
+    ce_mprsector* ce_mprfile_sector(const ce_mprfile* mprfile, int sector_x, int sector_z)
+    {
+        return use_sector(mprfile, sector_z * mprfile->sector_x_count + sector_x);
+    }
+
+    void ce_mprfile_decode_sectors(const ce_mprfile* mprfile)
+    {
+        const size_t count = mprfile->sector_x_count * mprfile->sector_z_count;
+        semaphore_ptr_t done = make_semaphore(0);
+
+        for (size_t i = 0; i < count; ++i) {
+            thread_pool_t::instance()->enqueue([mprfile, i, done] {
+                use_sector(mprfile, i);
+                done->release();
+            });
+        }
+
+        // the pool takes tasks from the back, help it from the front
+        for (size_t i = 0; i < count; ++i) {
+            use_sector(mprfile, i);
+        }
+
+        done->acquire(count);
+    }
 }
@@ -38,7 +38,7 @@ namespace cursedearth
         const float y_coef = CE_MPR_HEIGHT_Y_COEF * mprfile->max_y;
         float y = 0.0f;
 
-        ce_mprsector* sector = mprfile->sectors + sector_z * mprfile->sector_x_count + sector_x;
+        ce_mprsector* sector = ce_mprfile_sector(mprfile, sector_x, sector_z);
         ce_mprvertex* vertices = water ? sector->water_vertices : sector->land_vertices;
         int16_t* water_allow = water ? sector->water_allow : nullptr;
 
@@ -69,7 +69,7 @@ namespace cursedearth
     bool ce_mpr_get_height_triangle(const ce_mprfile* mprfile, int sector_x, int sector_z, int vertex_x1, int vertex_z1,
                                     int vertex_x2, int vertex_z2, int vertex_x3, int vertex_z3, float x, float z, float* y)
     {
-        const ce_mprsector* sector = mprfile->sectors + sector_z * mprfile->sector_x_count + sector_x;
+        const ce_mprsector* sector = ce_mprfile_sector(mprfile, sector_x, sector_z);
         const ce_mprvertex* vertex1 = sector->land_vertices + vertex_z1 * CE_MPRFILE_VERTEX_SIDE + vertex_x1;
         const ce_mprvertex* vertex2 = sector->land_vertices + vertex_z2 * CE_MPRFILE_VERTEX_SIDE + vertex_x2;
         const ce_mprvertex* vertex3 = sector->land_vertices + vertex_z3 * CE_MPRFILE_VERTEX_SIDE + vertex_x3;
@@ -242,7 +242,7 @@ namespace cursedearth
         // TODO: comments
 
         ce_mmpfile* first_mmpfile = (ce_mmpfile*)tile_mmp_files->items[0];
-        ce_mprsector* sector = mprfile->sectors + z * mprfile->sector_x_count + x;
+        ce_mprsector* sector = ce_mprfile_sector(mprfile, x, z);
 
         uint16_t* textures = water ? sector->water_textures :
                                     sector->land_textures;
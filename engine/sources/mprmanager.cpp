@@ -80,9 +80,6 @@ namespace cursedearth
             return NULL;
         }
 
-        ce_mprfile* mprfile = ce_mprfile_open(res_file);
-        ce_res_file_del(res_file);
-
-        return mprfile;
+        return ce_mprfile_open(res_file);
     }
 }
@@ -54,7 +54,7 @@ namespace cursedearth
         int sector_z = va_arg(args, int);
         int water = va_arg(args, int);
 
-        ce_mprsector* sector = mprfile->sectors + sector_z * mprfile->sector_x_count + sector_x;
+        ce_mprsector* sector = ce_mprfile_sector(mprfile, sector_x, sector_z);
         ce_mprvertex* vertices = water ? sector->water_vertices : sector->land_vertices;
         int16_t* water_allow = water ? sector->water_allow : NULL;
 
@@ -160,7 +160,7 @@ namespace cursedearth
         int water = va_arg(args, int);
         ce_vector* tile_textures = va_arg(args, ce_vector*);
 
-        ce_mprsector* sector = mprfile->sectors + sector_z * mprfile->sector_x_count + sector_x;
+        ce_mprsector* sector = ce_mprfile_sector(mprfile, sector_x, sector_z);
         ce_mprvertex* vertices = water ? sector->water_vertices : sector->land_vertices;
         uint16_t* textures = water ? sector->water_textures : sector->land_textures;
         int16_t* water_allow = water ? sector->water_allow : NULL;
@@ -333,7 +333,7 @@ namespace cursedearth
         int sector_z = va_arg(args, int);
         int water = va_arg(args, int);
 
-        ce_mprsector* sector = mprfile->sectors + sector_z * mprfile->sector_x_count + sector_x;
+        ce_mprsector* sector = ce_mprfile_sector(mprfile, sector_x, sector_z);
         ce_mprvertex* mprvertices = water ? sector->water_vertices : sector->land_vertices;
         //int16_t* water_allow = water ? sector->water_allow : NULL;
 
@@ -21,6 +21,10 @@
 #include "optionmanager.hpp"
 #include "logging.hpp"
 #include "registry.hpp"
+#include "soundoptions.hpp"
+#include "videooptions.hpp"
+
+#include <algorithm>
 
 #include <boost/filesystem.hpp>
 
@@ -59,10 +63,49 @@ namespace cursedearth
         ce_optparse_get(parser, "inverse_trackball_y", &inverse_trackball_y);
         ce_optparse_get(parser, "enable_terrain_tiling", &m_enable_terrain_tiling);
         ce_optparse_get(parser, "disable_texture_caching", &m_disable_texture_caching);
+        ce_optparse_get(parser, "disable_level_caching", &m_disable_level_caching);
+        ce_optparse_get(parser, "enable_archive_indexing", &m_enable_archive_indexing);
         ce_optparse_get(parser, "disable_sound", &m_disable_sound);
+        ce_optparse_get(parser, "low_latency_sound", &m_low_latency_sound);
+        ce_optparse_get(parser, "sound_buffer_time", &m_sound_buffer_time);
+        ce_optparse_get(parser, "sound_period_time", &m_sound_period_time);
+        ce_optparse_get(parser, "sound_voice_count", &m_sound_voice_count);
+
+        ce_optparse_get(parser, "video_prefetch_frames", &m_video_prefetch_frames);
+
+        const char* sound_output;
+        ce_optparse_get(parser, "sound_output", &sound_output);
+        if (NULL != sound_output) {
+            m_sound_output = sound_output;
+        }
+        ce_optparse_get(parser, "figure_cache_size", &m_figure_cache_size);
         ce_optparse_get(parser, "show_axes", &m_show_axes);
         ce_optparse_get(parser, "show_fps", &m_show_fps);
 
+        if (m_figure_cache_size < 0) {
+            m_figure_cache_size = 0;
+        }
+
+        if (m_sound_voice_count < 1) {
+            m_sound_voice_count = 1;
+        }
+
+        if (m_video_prefetch_frames < 2) {
+            m_video_prefetch_frames = 2;
+        }
+
+        if (m_sound_buffer_time <= 0) {
+            m_sound_buffer_time = m_low_latency_sound ? 40 : 500;
+        }
+
+        if (m_sound_period_time <= 0) {
+            m_sound_period_time = m_low_latency_sound ? 10 : 100;
+        }
+
+        // at least two periods of at least 1 ms must fit into the buffer
+        m_sound_buffer_time = std::max(m_sound_buffer_time, 2);
+        m_sound_period_time = std::min(m_sound_period_time, m_sound_buffer_time / 2);
+
         if (inverse_trackball) {
             inverse_trackball_x = true;
             inverse_trackball_y = true;
@@ -72,6 +115,10 @@ namespace cursedearth
         ce_logging_info("option manager: CE path is `%s'", m_ce_path.string().c_str());
         ce_logging_info("option manager: terrain tiling %s", m_enable_terrain_tiling ? "enabled" : "disabled");
         ce_logging_info("option manager: texture caching %s", m_disable_texture_caching ? "disabled" : "enabled");
+        ce_logging_info("option manager: level caching %s", m_disable_level_caching ? "disabled" : "enabled");
+        ce_logging_info("option manager: archive indexing %s", m_enable_archive_indexing ? "enabled" : "disabled");
+        ce_logging_info("option manager: figure cache size is %d MB", m_figure_cache_size);
+        ce_logging_info("option manager: sound buffer time is %d ms, period time is %d ms%s", m_sound_buffer_time, m_sound_period_time, m_low_latency_sound ? " (low latency)" : "");
     }
 
     ce_optparse_ptr_t option_manager_t::make_parser()
@@ -126,7 +173,40 @@ namespace cursedearth
         ce_optparse_add(parser, "disable_texture_caching", CE_TYPE_BOOL, NULL, false, NULL, "disable-texture-caching",
             "do not save generated textures in cache (usually `Textures' directory, up to 1 GB disk space usage is normal); very slow if you have a prehistoric CPU!");
 
+        ce_optparse_add(parser, "disable_level_caching", CE_TYPE_BOOL, NULL, false, NULL, "disable-level-caching",
+            "do not save compiled levels in cache (usually `Cache' directory); every level will be parsed from scratch");
+
+        ce_optparse_add(parser, "enable_archive_indexing", CE_TYPE_BOOL, NULL, false, NULL, "enable-archive-indexing",
+            "keep a content hash of every archive node in `Cache' for tools that validate derived data; archives are read in full after every change");
+
+        const int figure_cache_size_default = 64;
+        ce_optparse_add(parser, "figure_cache_size", CE_TYPE_INT, &figure_cache_size_default, false, NULL, "figure-cache-size",
+            "memory budget in MB for figures kept after they are no longer used on the scene; 0 frees them immediately");
+
         ce_optparse_add(parser, "disable_sound", CE_TYPE_BOOL, NULL, false, NULL, "disable-sound", "turn off all sounds");
+
+        ce_optparse_add(parser, "low_latency_sound", CE_TYPE_BOOL, NULL, false, NULL, "low-latency-sound",
+            "keep sounds close to the events that trigger them: short device buffers and a high priority output thread; may crackle on a loaded system");
+
+        const int sound_buffer_time_default = 0;
+        ce_optparse_add(parser, "sound_buffer_time", CE_TYPE_INT, &sound_buffer_time_default, false, NULL, "sound-buffer-time",
+            "sound device buffer length in ms; 500 by default, 40 in low latency mode");
+
+        const int sound_period_time_default = 0;
+        ce_optparse_add(parser, "sound_period_time", CE_TYPE_INT, &sound_period_time_default, false, NULL, "sound-period-time",
+            "sound device period length in ms; 100 by default, 10 in low latency mode");
+
+        ce_optparse_add(parser, "sound_output", CE_TYPE_STRING, NULL, false, NULL, "sound-output",
+            "send sound to `null' (discard as fast as possible), `realtime-null' (discard at playback speed) or a WAV file instead of the sound device; for benchmarks");
+
+        const int sound_voice_count_default = sound_options_t::voice_count;
+        ce_optparse_add(parser, "sound_voice_count", CE_TYPE_INT, &sound_voice_count_default, false, NULL, "sound-voice-count",
+            "maximum number of sounds mixed at once; the quietest and least important ones are virtualized");
+
+        const int video_prefetch_frames_default = video_options_t::frame_count;
+        ce_optparse_add(parser, "video_prefetch_frames", CE_TYPE_INT, &video_prefetch_frames_default, false, NULL, "video-prefetch-frames",
+            "number of decoded video frames queued ahead of playback; more smooths out slow frames at the cost of memory");
+
         ce_optparse_add(parser, "show_axes", CE_TYPE_BOOL, NULL, false, NULL, "show-axes", "show x (red), y (green), z (blue) axes");
         ce_optparse_add(parser, "show_fps", CE_TYPE_BOOL, NULL, false, NULL, "show-fps", "show FPS counter");
 
@@ -19,8 +19,6 @@
  */
 
 #include <cassert>
-#include <cstdio>
-#include <cstring>
 #include <vector>
 
 #include "alloc.hpp"
@@ -31,39 +29,39 @@ namespace cursedearth
 {
     const uint32_t CE_REG_SIGNATURE = 0x45ab3efbu;
 
-    ce_property* ce_reg_create_option_int(ce_mem_file* mem_file, const char* name)
+    ce_value* ce_reg_create_value_int(ce_mem_file* mem_file)
     {
-        ce_property* property = ce_property_new(name, CE_TYPE_INT);
-        ce_value_set_int(property->value, ce_mem_file_read_i32le(mem_file));
-        return property;
+        ce_value* value = ce_value_new(CE_TYPE_INT);
+        ce_value_set_int(value, ce_mem_file_read_i32le(mem_file));
+        return value;
     }
 
-    ce_property* ce_reg_create_option_float(ce_mem_file* mem_file, const char* name)
+    ce_value* ce_reg_create_value_float(ce_mem_file* mem_file)
     {
-        ce_property* property = ce_property_new(name, CE_TYPE_FLOAT);
-        ce_value_set_float(property->value, ce_mem_file_read_fle(mem_file));
-        return property;
+        ce_value* value = ce_value_new(CE_TYPE_FLOAT);
+        ce_value_set_float(value, ce_mem_file_read_fle(mem_file));
+        return value;
     }
 
-    ce_property* ce_reg_create_option_string(ce_mem_file* mem_file, const char* name)
+    ce_value* ce_reg_create_value_string(ce_mem_file* mem_file)
     {
         size_t length = ce_mem_file_read_u16le(mem_file);
 
-        std::vector<char> value(length + 1);
-        value[length] = '\0';
+        std::vector<char> data(length + 1);
+        data[length] = '\0';
 
-        ce_mem_file_read(mem_file, value.data(), 1, length);
+        ce_mem_file_read(mem_file, data.data(), 1, length);
 
-        ce_property* property = ce_property_new(name, CE_TYPE_STRING);
-        ce_value_set_string(property->value, value.data());
+        ce_value* value = ce_value_new(CE_TYPE_STRING);
+        ce_value_set_string(value, data.data());
 
-        return property;
+        return value;
     }
 
-    ce_property* (*ce_reg_create_option_procs[])(ce_mem_file*, const char*) = {
-        ce_reg_create_option_int,
-        ce_reg_create_option_float,
-        ce_reg_create_option_string,
+    ce_value* (*ce_reg_create_value_procs[])(ce_mem_file*) = {
+        ce_reg_create_value_int,
+        ce_reg_create_value_float,
+        ce_reg_create_value_string,
     };
 
     ce_reg_file* ce_reg_file_new(ce_mem_file* mem_file)
@@ -73,8 +71,8 @@ namespace cursedearth
 
         uint16_t section_count = ce_mem_file_read_u16le(mem_file);
 
-        ce_reg_file* reg_file = (ce_reg_file*)ce_alloc_zero(sizeof(ce_reg_file));
-        reg_file->sections = ce_vector_new_reserved(section_count);
+        ce_reg_file* reg_file = new ce_reg_file;
+        reg_file->key_table.sections.reserve(section_count);
 
         struct section_t
         {
@@ -95,13 +93,9 @@ namespace cursedearth
             sections[i].option_count = ce_mem_file_read_u16le(mem_file);
             sections[i].name_length = ce_mem_file_read_u16le(mem_file);
 
-            std::vector<char> section_name(sections[i].name_length + 1);
-            section_name[sections[i].name_length] = '\0';
-
+            std::vector<char> section_name(sections[i].name_length);
             ce_mem_file_read(mem_file, section_name.data(), 1, sections[i].name_length);
-
-            ce_object* section = ce_object_new(section_name.data());
-            ce_vector_push_back(reg_file->sections, section);
+            ce_key_table_add_section(&reg_file->key_table, section_name.data(), section_name.size());
 
             struct option_t
             {
@@ -122,10 +116,12 @@ namespace cursedearth
                 options[j].type = ce_mem_file_read_u8(mem_file);
                 options[j].name_length = ce_mem_file_read_u16le(mem_file);
 
-                std::vector<char> option_name(options[j].name_length + 1);
-                option_name[options[j].name_length] = '\0';
-
+                std::vector<char> option_name(options[j].name_length);
                 ce_mem_file_read(mem_file, option_name.data(), 1, options[j].name_length);
+
+                ce_key_table_add_option(&reg_file->key_table, option_name.data(), option_name.size());
+                reg_file->first_values.push_back(reg_file->values.size());
+
                 uint16_t value_count = 1;
 
                 if (options[j].type >= 128) {
@@ -134,36 +130,35 @@ namespace cursedearth
                 }
 
                 for (uint16_t k = 0; k < value_count; ++k) {
-                    std::vector<char> array_name(options[j].name_length + 8);
-                    snprintf(array_name.data(), array_name.size(), "%s%hu", option_name.data(), k);
-                    ce_object_add(section, (*ce_reg_create_option_procs[options[j].type])(mem_file, array_name.data()));
+                    reg_file->values.push_back((*ce_reg_create_value_procs[options[j].type])(mem_file));
                 }
             }
         }
 
+        reg_file->first_values.push_back(reg_file->values.size());
         return reg_file;
     }
 
     void ce_reg_file_del(ce_reg_file* reg_file)
     {
         if (NULL != reg_file) {
-            ce_vector_for_each(reg_file->sections, (void(*)(void*))ce_object_del);
-            ce_vector_del(reg_file->sections);
-            ce_free(reg_file, sizeof(ce_reg_file));
+            for (ce_value* value: reg_file->values) {
+                ce_value_del(value);
+            }
+            delete reg_file;
         }
     }
 
-    ce_value* ce_reg_file_find(ce_reg_file* reg_file, const char* section_name, const char* option_name, size_t index)
+    ce_value* ce_reg_file_find(const ce_reg_file* reg_file, const char* section_name, const char* option_name, size_t index)
     {
-        std::vector<char> array_name(strlen(option_name) + 8);
-        snprintf(array_name.data(), array_name.size(), "%s%zu", option_name, index);
-
-        for (size_t i = 0; i < reg_file->sections->count; ++i) {
-            ce_object* section = (ce_object*)reg_file->sections->items[i];
-            if (0 == strcmp(section_name, section->name->str)) {
-                ce_property* option = ce_object_find(section, array_name.data());
-                if (NULL != option) {
-                    return option->value;
+        const ce_key_table* key_table = &reg_file->key_table;
+        for (size_t i = ce_key_table_section_index(key_table, section_name); i != ce_key_table_section_count(key_table); i = ce_key_table_next_section(key_table, i)) {
+            uint32_t option_index = ce_key_table_option_index(key_table, i, option_name);
+            if (CE_KEY_TABLE_NPOS != option_index) {
+                // arrays and single values share a layout: a run of values per option
+                size_t value_index = reg_file->first_values[option_index] + index;
+                if (value_index < reg_file->first_values[option_index + 1]) {
+                    return reg_file->values[value_index];
                 }
             }
         }
@@ -28,7 +28,7 @@ namespace cursedearth
     {
         ce_rendergroup* rendergroup = (ce_rendergroup*)ce_alloc(sizeof(ce_rendergroup));
         rendergroup->priority = priority;
-        rendergroup->material = material;
+        rendergroup->material = ce_material_add_ref(material);
         rendergroup->renderlayers = ce_vector_new();
         return rendergroup;
     }
@@ -38,6 +38,7 @@ namespace cursedearth
         if (NULL != rendergroup) {
             ce_vector_for_each(rendergroup->renderlayers, (void(*)(void*))ce_renderlayer_del);
             ce_vector_del(rendergroup->renderlayers);
+            ce_material_del(rendergroup->material);
             ce_free(rendergroup, sizeof(ce_rendergroup));
         }
     }
@@ -27,7 +27,7 @@ namespace cursedearth
     ce_renderlayer* ce_renderlayer_new(ce_texture* texture)
     {
         ce_renderlayer* renderlayer = (ce_renderlayer*)ce_alloc(sizeof(ce_renderlayer));
-        renderlayer->texture = texture;
+        renderlayer->texture = NULL != texture ? ce_texture_add_ref(texture) : NULL;
         renderlayer->renderitems = ce_vector_new();
         return renderlayer;
     }
@@ -36,6 +36,7 @@ namespace cursedearth
     {
         if (NULL != renderlayer) {
             ce_vector_del(renderlayer->renderitems);
+            ce_texture_del(renderlayer->texture);
             ce_free(renderlayer, sizeof(ce_renderlayer));
         }
     }
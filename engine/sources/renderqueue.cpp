@@ -58,6 +58,9 @@ namespace cursedearth
         for (size_t i = 0; i < renderqueue->rendergroups->count; ++i) {
             ce_rendergroup* rendergroup = (ce_rendergroup*)renderqueue->rendergroups->items[i];
             if (priority == rendergroup->priority) {
+                // the group keeps its material alive, even if the owner is evicted from a cache
+                ce_material_add_ref(material);
+                ce_material_del(rendergroup->material);
                 rendergroup->material = material;
                 return rendergroup;
             }
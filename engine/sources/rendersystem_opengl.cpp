@@ -69,6 +69,8 @@ namespace cursedearth
                 extensions[i].name, extensions[i].available ? "yes" : "no");
         }
 
+        ce_texture_query_capabilities();
+
         ce_render_system = (struct ce_render_system*)ce_alloc_zero(sizeof(struct ce_render_system));
         ce_render_system->thread_id = ce_thread_self();
         ce_render_system->view = CE_MAT4_IDENTITY;
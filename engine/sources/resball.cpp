@@ -18,10 +18,93 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cerrno>
+#include <algorithm>
+
 #include "resball.hpp"
 
 namespace cursedearth
 {
+    typedef struct {
+        ce_res_file* parent;
+        size_t offset, size, pos;
+    } ce_res_view_file;
+
+    size_t ce_res_view_file_read(ce_mem_file* mem_file, void* ptr, size_t size, size_t n)
+    {
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+        n = std::min(n, (view_file->size - view_file->pos) / size);
+        ce_mutex_lock(view_file->parent->mutex);
+        ce_mem_file_seek(view_file->parent->mem_file, view_file->offset + view_file->pos, CE_MEM_FILE_SEEK_SET);
+        n = ce_mem_file_read(view_file->parent->mem_file, ptr, size, n);
+        ce_mutex_unlock(view_file->parent->mutex);
+        view_file->pos += size * n;
+        return n;
+    }
+
+    int ce_res_view_file_seek(ce_mem_file* mem_file, long int offset, int whence)
+    {
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+
+        long int pos;
+        if (CE_MEM_FILE_SEEK_SET == whence) {
+            pos = offset;
+        } else if (CE_MEM_FILE_SEEK_CUR == whence) {
+            pos = view_file->pos + offset;
+        } else if (CE_MEM_FILE_SEEK_END == whence) {
+            pos = view_file->size + offset;
+        } else {
+            errno = EINVAL;
+            return -1;
+        }
+
+        if (pos < 0 || (size_t)pos > view_file->size) {
+            errno = ERANGE;
+            return -1;
+        }
+
+        view_file->pos = pos;
+        return 0;
+    }
+
+    long int ce_res_view_file_tell(ce_mem_file* mem_file)
+    {
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+        return view_file->pos;
+    }
+
+    int ce_res_view_file_eof(ce_mem_file* mem_file)
+    {
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+        return view_file->pos == view_file->size;
+    }
+
+    int ce_res_view_file_error(ce_mem_file* mem_file)
+    {
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+        return ce_mem_file_error(view_file->parent->mem_file);
+    }
+
+    void ce_res_view_file_advise(ce_mem_file* mem_file, long int offset, size_t size)
+    {
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+        ce_mem_file_advise(view_file->parent->mem_file, view_file->offset + offset, size);
+    }
+
+    ce_mem_file* ce_res_ball_open_mem_file(ce_res_file* res_file, size_t index)
+    {
+        // the parent is not owned, so there is nothing to close
+        ce_mem_file_vtable vt = {sizeof(ce_res_view_file), NULL, ce_res_view_file_read, ce_res_view_file_seek, ce_res_view_file_tell, ce_res_view_file_eof, ce_res_view_file_error, ce_res_view_file_advise};
+        ce_mem_file* mem_file = ce_mem_file_new(vt);
+
+        ce_res_view_file* view_file = (ce_res_view_file*)mem_file->impl;
+        view_file->parent = res_file;
+        view_file->offset = res_file->nodes[index].data_offset;
+        view_file->size = res_file->nodes[index].data_length;
+
+        return mem_file;
+    }
+
     void ce_res_ball_extract_all_mem_files(ce_res_file* res_file, ce_mem_file* mem_files[])
     {
         for (size_t i = 0; i < res_file->node_count; ++i) {
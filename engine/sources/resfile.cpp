@@ -22,6 +22,7 @@
 #include <cstdio>
 #include <cstring>
 #include <cctype>
+#include <vector>
 
 #include <boost/algorithm/string.hpp>
 
@@ -33,12 +34,22 @@
 namespace cursedearth
 {
     const uint32_t CE_RES_SIGNATURE = 0x19ce23c;
+    const size_t CE_RES_NODE_SIZE = 22;
+
+    template <typename T>
+    inline T ce_res_read_le(const uint8_t* data)
+    {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        return le2cpu(value);
+    }
 
     ce_res_file* ce_res_file_new(const std::string& name, ce_mem_file* mem_file)
     {
         ce_res_file* res_file = (ce_res_file*)ce_alloc_zero(sizeof(ce_res_file));
         res_file->name = ce_string_new_str(name.c_str());
         res_file->mem_file = mem_file;
+        res_file->mutex = ce_mutex_new();
 
         uint32_t signature = ce_mem_file_read_u32le(mem_file);
         assert(CE_RES_SIGNATURE == signature && "wrong signature");
@@ -50,13 +61,19 @@ namespace cursedearth
 
         ce_mem_file_seek(mem_file, res_file->metadata_offset, CE_MEM_FILE_SEEK_SET);
 
+        // read the whole node table at once, nested archives are views
+        // that lock their parent on every read
+        std::vector<uint8_t> metadata(CE_RES_NODE_SIZE * res_file->node_count);
+        ce_mem_file_read(mem_file, metadata.data(), CE_RES_NODE_SIZE, res_file->node_count);
+
         for (size_t i = 0; i < res_file->node_count; ++i) {
-            res_file->nodes[i].next_index = ce_mem_file_read_i32le(mem_file);
-            res_file->nodes[i].data_length = ce_mem_file_read_u32le(mem_file);
-            res_file->nodes[i].data_offset = ce_mem_file_read_u32le(mem_file);
-            res_file->nodes[i].modified = ce_mem_file_read_i32le(mem_file);
-            res_file->nodes[i].name_length = ce_mem_file_read_u16le(mem_file);
-            res_file->nodes[i].name_offset = ce_mem_file_read_u32le(mem_file);
+            const uint8_t* node = metadata.data() + CE_RES_NODE_SIZE * i;
+            res_file->nodes[i].next_index = ce_res_read_le<int32_t>(node + 0);
+            res_file->nodes[i].data_length = ce_res_read_le<uint32_t>(node + 4);
+            res_file->nodes[i].data_offset = ce_res_read_le<uint32_t>(node + 8);
+            res_file->nodes[i].modified = ce_res_read_le<int32_t>(node + 12);
+            res_file->nodes[i].name_length = ce_res_read_le<uint16_t>(node + 16);
+            res_file->nodes[i].name_offset = ce_res_read_le<uint32_t>(node + 18);
         }
 
         res_file->names = (char*)ce_alloc(res_file->names_length);
@@ -82,6 +99,7 @@ namespace cursedearth
     void ce_res_file_del(ce_res_file* res_file)
     {
         if (NULL != res_file) {
+            ce_mutex_del(res_file->mutex);
             ce_mem_file_del(res_file->mem_file);
             if (NULL != res_file->nodes) {
                 for (size_t i = 0; i < res_file->node_count; ++i) {
@@ -119,8 +137,28 @@ namespace cursedearth
     void* ce_res_file_node_data(ce_res_file* res_file, size_t index)
     {
         void* data = ce_alloc(res_file->nodes[index].data_length);
-        ce_mem_file_seek(res_file->mem_file, res_file->nodes[index].data_offset, CE_MEM_FILE_SEEK_SET);
-        ce_mem_file_read(res_file->mem_file, data, 1, res_file->nodes[index].data_length);
+        ce_res_file_node_read(res_file, index, data);
         return data;
     }
+
+    bool ce_res_file_node_read(ce_res_file* res_file, size_t index, void* data)
+    {
+        return ce_res_file_read_range(res_file, res_file->nodes[index].data_offset, res_file->nodes[index].data_length, data);
+    }
+
+    bool ce_res_file_read_range(ce_res_file* res_file, size_t offset, size_t size, void* data)
+    {
+        ce_mutex_lock(res_file->mutex);
+        const bool ok = 0 == ce_mem_file_seek(res_file->mem_file, offset, CE_MEM_FILE_SEEK_SET) &&
+                        size == ce_mem_file_read(res_file->mem_file, data, 1, size);
+        ce_mutex_unlock(res_file->mutex);
+        return ok;
+    }
+
+    void ce_res_file_advise_range(ce_res_file* res_file, size_t offset, size_t size)
+    {
+        ce_mutex_lock(res_file->mutex);
+        ce_mem_file_advise(res_file->mem_file, offset, size);
+        ce_mutex_unlock(res_file->mutex);
+    }
 }
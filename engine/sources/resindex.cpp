@@ -0,0 +1,188 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+
+#include "alloc.hpp"
+#include "logging.hpp"
+#include "byteorder.hpp"
+#include "utility.hpp"
+#include "semaphore.hpp"
+#include "threadpool.hpp"
+#include "resindex.hpp"
+
+namespace cursedearth
+{
+    namespace fs = boost::filesystem;
+
+    const uint32_t CE_RES_INDEX_SIGNATURE = 0x49524543; // CERI
+
+    // signature, version, node count, reserved, source size, source mtime
+    const size_t CE_RES_INDEX_HEADER_SIZE = 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+    ce_res_index* ce_res_index_alloc(uint32_t node_count)
+    {
+        ce_res_index* res_index = (ce_res_index*)ce_alloc_zero(sizeof(ce_res_index));
+        res_index->node_count = node_count;
+        res_index->hashes = (uint64_t*)ce_alloc_zero(sizeof(uint64_t) * node_count);
+        return res_index;
+    }
+
+    // nodes are read in chunks of about this size, the last few are hashed meanwhile
+    const size_t CE_RES_INDEX_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    void ce_res_index_hash_nodes(ce_res_file* res_file, ce_res_index* res_index, const size_t* first, const size_t* last, const uint8_t* data)
+    {
+        for (; first != last; ++first) {
+            const size_t size = ce_res_file_node_size(res_file, *first);
+            res_index->hashes[*first] = fnv1a64(data, size);
+            data += size;
+        }
+    }
+
+    ce_res_index* ce_res_index_new(ce_res_file* res_file, uint64_t source_size, int64_t source_mtime)
+    {
+        ce_res_index* res_index = ce_res_index_alloc(res_file->node_count);
+        res_index->source_size = source_size;
+        res_index->source_mtime = source_mtime;
+
+        // one forward pass over the archive on this thread, hashing goes to the thread pool
+        std::vector<size_t> nodes(res_file->node_count);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            nodes[i] = i;
+        }
+        std::sort(nodes.begin(), nodes.end(), [res_file] (size_t a, size_t b) {
+            return res_file->nodes[a].data_offset < res_file->nodes[b].data_offset;
+        });
+
+        const size_t slot_count = std::max(1u, std::thread::hardware_concurrency());
+        semaphore_ptr_t slots = make_semaphore(slot_count);
+
+        for (size_t first = 0, last; first < nodes.size(); first = last) {
+            // a node larger than a chunk gets a chunk of its own
+            size_t size = ce_res_file_node_size(res_file, nodes[first]);
+            for (last = first + 1; last < nodes.size() && size + ce_res_file_node_size(res_file, nodes[last]) <= CE_RES_INDEX_CHUNK_SIZE; ++last) {
+                size += ce_res_file_node_size(res_file, nodes[last]);
+            }
+
+            slots->acquire();
+            std::shared_ptr<std::vector<uint8_t>> buffer = std::make_shared<std::vector<uint8_t>>(size);
+            for (size_t i = first, offset = 0; i < last; offset += ce_res_file_node_size(res_file, nodes[i++])) {
+                ce_res_file_node_read(res_file, nodes[i], buffer->data() + offset);
+            }
+
+            const size_t* chunk = nodes.data();
+            thread_pool_t::instance()->enqueue([res_file, res_index, chunk, first, last, buffer, slots] {
+                ce_res_index_hash_nodes(res_file, res_index, chunk + first, chunk + last, buffer->data());
+                slots->release();
+            });
+        }
+
+        slots->acquire(slot_count);
+        return res_index;
+    }
+
+    ce_res_index* ce_res_index_open(const fs::path& path)
+    {
+        ce_mem_file* mem_file = ce_mem_file_new_path(path);
+        if (NULL == mem_file) {
+            return NULL;
+        }
+
+        const long int size = ce_mem_file_size(mem_file);
+        uint32_t signature = ce_mem_file_read_u32le(mem_file);
+        uint32_t version = ce_mem_file_read_u32le(mem_file);
+        uint32_t node_count = ce_mem_file_read_u32le(mem_file);
+        ce_mem_file_skip(mem_file, sizeof(uint32_t));
+
+        if (CE_RES_INDEX_SIGNATURE != signature || CE_RES_INDEX_VERSION != version ||
+                size != (long int)(CE_RES_INDEX_HEADER_SIZE + sizeof(uint64_t) * node_count)) {
+            ce_logging_warning("res index: `%s' is corrupted or outdated", path.string().c_str());
+            ce_mem_file_del(mem_file);
+            return NULL;
+        }
+
+        ce_res_index* res_index = ce_res_index_alloc(node_count);
+        res_index->source_size = ce_mem_file_read_u64le(mem_file);
+        res_index->source_mtime = ce_mem_file_read_i64le(mem_file);
+        for (uint32_t i = 0; i < node_count; ++i) {
+            res_index->hashes[i] = ce_mem_file_read_u64le(mem_file);
+        }
+
+        ce_mem_file_del(mem_file);
+        return res_index;
+    }
+
+    void ce_res_index_del(ce_res_index* res_index)
+    {
+        if (NULL != res_index) {
+            ce_free(res_index->hashes, sizeof(uint64_t) * res_index->node_count);
+            ce_free(res_index, sizeof(ce_res_index));
+        }
+    }
+
+    void ce_res_index_save(const ce_res_index* res_index, const fs::path& path)
+    {
+        std::vector<uint8_t> image(CE_RES_INDEX_HEADER_SIZE + sizeof(uint64_t) * res_index->node_count);
+        uint32_t* header = reinterpret_cast<uint32_t*>(image.data());
+        header[0] = cpu2le(CE_RES_INDEX_SIGNATURE);
+        header[1] = cpu2le<uint32_t>(CE_RES_INDEX_VERSION);
+        header[2] = cpu2le(res_index->node_count);
+        header[3] = 0;
+
+        uint64_t* values = reinterpret_cast<uint64_t*>(image.data() + 4 * sizeof(uint32_t));
+        values[0] = cpu2le(res_index->source_size);
+        values[1] = cpu2le(res_index->source_mtime);
+        for (uint32_t i = 0; i < res_index->node_count; ++i) {
+            values[2 + i] = cpu2le(res_index->hashes[i]);
+        }
+
+        boost::system::error_code error_code;
+        fs::create_directories(path.parent_path(), error_code);
+
+        // several processes may index the same archive at the same time
+        fs::path temporary_path = path;
+        temporary_path += fs::unique_path(".%%%%-%%%%");
+
+        FILE* file = fopen(temporary_path.string().c_str(), "wb");
+        if (NULL == file) {
+            ce_logging_error("res index: could not save file `%s'", path.string().c_str());
+            return;
+        }
+
+        const size_t size = fwrite(image.data(), 1, image.size(), file);
+        fclose(file);
+
+        if (image.size() == size) {
+            fs::rename(temporary_path, path, error_code);
+        }
+
+        if (image.size() != size || error_code) {
+            ce_logging_error("res index: could not save file `%s'", path.string().c_str());
+            fs::remove(temporary_path, error_code);
+        }
+    }
+}
@@ -18,12 +18,17 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstring>
 #include <vector>
+#include <algorithm>
+#include <functional>
 
 #include <boost/filesystem.hpp>
 
 #include "alloc.hpp"
 #include "logging.hpp"
+#include "threadlock.hpp"
+#include "utility.hpp"
 #include "optionmanager.hpp"
 #include "resourcemanager.hpp"
 
@@ -35,6 +40,8 @@ namespace cursedearth
 
     const std::vector<std::string> ce_resource_dirs = { "Res" };
     const std::vector<std::string> ce_resource_exts = { ".res" };
+    const std::vector<std::string> ce_resource_index_dirs = { "Cache" };
+    const std::vector<std::string> ce_resource_index_exts = { ".resi" };
 
     fs::path find_resource_resource(const std::string& name)
     {
@@ -51,13 +58,16 @@ namespace cursedearth
         return fs::path();
     }
 
-    ce_res_file* ce_resource_manager_open(const std::string& name)
+    ce_res_file* ce_resource_manager_open(const std::string& name, ce_res_index** res_index)
     {
         fs::path path = find_resource_resource(name);
         ce_res_file* res_file = NULL;
 
         if (!path.empty() && NULL != (res_file = ce_res_file_new_path(path))) {
             ce_logging_info("resource manager: loading `%s'... ok", path.string().c_str());
+            if (option_manager_t::instance()->archive_indexing()) {
+                *res_index = ce_resource_manager_open_index(path, res_file);
+            }
         } else {
             ce_logging_error("resource manager: loading `%s'... failed", path.string().c_str());
         }
@@ -72,13 +82,15 @@ namespace cursedearth
             fs::path path = option_manager_t::instance()->ei_path() / directory;
             ce_logging_info("resource manager: using path `%s'", path.string().c_str());
         }
-        ce_resource_manager->database = ce_resource_manager_open("database");
-        ce_resource_manager->menus = ce_resource_manager_open("menus");
+        ce_resource_manager->database = ce_resource_manager_open("database", &ce_resource_manager->database_index);
+        ce_resource_manager->menus = ce_resource_manager_open("menus", &ce_resource_manager->menus_index);
     }
 
     void ce_resource_manager_term()
     {
         if (NULL != ce_resource_manager) {
+            ce_res_index_del(ce_resource_manager->menus_index);
+            ce_res_index_del(ce_resource_manager->database_index);
             ce_res_file_del(ce_resource_manager->menus);
             ce_res_file_del(ce_resource_manager->database);
             ce_free(ce_resource_manager, sizeof(struct ce_resource_manager));
@@ -94,4 +106,207 @@ namespace cursedearth
         }
         return CE_RESOURCE_DATA_COUNT;
     }
+
+    ce_res_index* ce_resource_manager_open_index(const fs::path& archive_path, ce_res_file* res_file)
+    {
+        boost::system::error_code size_error_code, mtime_error_code;
+        const uint64_t source_size = file_size(archive_path, size_error_code);
+        const int64_t source_mtime = last_write_time(archive_path, mtime_error_code);
+
+        if (size_error_code || mtime_error_code) {
+            // a sidecar could not be checked against the archive
+            ce_logging_warning("resource manager: could not stat `%s', indexing without a sidecar", archive_path.string().c_str());
+            return ce_res_index_new(res_file, 0, 0);
+        }
+
+        // archives with the same name may live in different directories
+        const std::string key = fs::absolute(archive_path).generic_string();
+        fs::path index_path = option_manager_t::instance()->ce_path() / ce_resource_index_dirs[0] / archive_path.filename();
+        index_path += "." + std::to_string(fnv1a64(key.data(), key.size())) + ce_resource_index_exts[0];
+
+        if (exists(index_path)) {
+            ce_res_index* res_index = ce_res_index_open(index_path);
+            if (NULL != res_index && res_file->node_count == res_index->node_count &&
+                    source_size == res_index->source_size && source_mtime == res_index->source_mtime) {
+                return res_index;
+            }
+            ce_res_index_del(res_index);
+        }
+
+        ce_logging_info("resource manager: indexing `%s'...", archive_path.string().c_str());
+        ce_res_index* res_index = ce_res_index_new(res_file, source_size, source_mtime);
+        ce_res_index_save(res_index, index_path);
+
+        return res_index;
+    }
+
+    void* resource_data_t::release() const
+    {
+        if (exclusive && !released.exchange(true)) {
+            return data;
+        }
+        void* copy = ce_alloc(size);
+        memcpy(copy, data, size);
+        return copy;
+    }
+
+    resource_loader_t::resource_loader_t():
+        singleton_t<resource_loader_t>(this),
+        m_idle(make_condition_variable()),
+        m_decodes(std::make_shared<decode_registry_t>()),
+        m_thread(make_thread("resource loader", [this]{execute();}))
+    {
+    }
+
+    resource_loader_t::~resource_loader_t()
+    {
+        // stop reading before members go away
+        m_thread.reset();
+
+        // unread requests complete with null, so decodes waiting on them are cleared too
+        for (const auto& pair: m_requests) {
+            const request_ptr_t& request = pair.second;
+            request->promise.set_value(nullptr);
+            for (const auto& continuation: request->continuations) {
+                continuation(nullptr);
+            }
+        }
+        m_requests.clear();
+        m_queue.clear();
+    }
+
+    resource_data_future_t resource_loader_t::read(ce_res_file* res_file, const std::string& name)
+    {
+        return request(res_file, ce_res_file_node_index(res_file, name), continuation_t());
+    }
+
+    resource_data_future_t resource_loader_t::request(ce_res_file* res_file, size_t index, const continuation_t& continuation)
+    {
+        if (res_file->node_count == index) {
+            std::promise<resource_data_ptr_t> promise;
+            promise.set_value(nullptr);
+            if (continuation) {
+                continuation(nullptr);
+            }
+            return promise.get_future().share();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+
+        request_ptr_t& request = m_requests[std::make_pair(res_file, index)];
+        if (!request) {
+            request = std::make_shared<request_t>();
+            request->res_file = res_file;
+            request->index = index;
+            request->future = request->promise.get_future().share();
+            request->consumer_count = 0;
+            m_queue.push_back(request);
+            m_idle->notify_one();
+        }
+
+        if (continuation) {
+            request->continuations.push_back(continuation);
+        }
+        ++request->consumer_count;
+
+        return request->future;
+    }
+
+    void resource_loader_t::complete(const request_ptr_t& request, void* data, size_t size, const std::shared_ptr<uint8_t>& span, thread_lock_t& lock)
+    {
+        // no more consumers may be added once the request is gone
+        lock.lock();
+        m_requests.erase(std::make_pair(request->res_file, request->index));
+        const bool exclusive = 1 == request->consumer_count;
+        lock.unlock();
+
+        resource_data_ptr_t result;
+        if (NULL != data) {
+            result = span ? std::make_shared<resource_data_t>(span, data, size) :
+                            std::make_shared<resource_data_t>(data, size, exclusive);
+        }
+        request->promise.set_value(result);
+        for (const auto& continuation: request->continuations) {
+            continuation(result);
+        }
+    }
+
+    void resource_loader_t::read_run(std::vector<request_ptr_t>::const_iterator first, std::vector<request_ptr_t>::const_iterator last, size_t end, thread_lock_t& lock)
+    {
+        ce_res_file* res_file = (*first)->res_file;
+
+        if (1 == last - first) {
+            const size_t size = ce_res_file_node_size(res_file, (*first)->index);
+            void* data = ce_alloc(size);
+            if (!ce_res_file_node_read(res_file, (*first)->index, data)) {
+                ce_logging_error("resource loader: could not read node `%s'", ce_res_file_node_name(res_file, (*first)->index));
+                ce_free(data, size);
+                data = NULL;
+            }
+            complete(*first, data, size, nullptr, lock);
+            return;
+        }
+
+        // one read for the whole run, nodes are views into it
+        const size_t offset = span_begin(*first);
+        const size_t size = end - offset;
+        std::shared_ptr<uint8_t> span(static_cast<uint8_t*>(ce_alloc(size)), [size] (uint8_t* data) { ce_free(data, size); });
+        if (!ce_res_file_read_range(res_file, offset, size, span.get())) {
+            // garbage is worse than nothing: every node of the run fails
+            ce_logging_error("resource loader: could not read %zu bytes at %zu", size, offset);
+            span.reset();
+        }
+
+        for (auto it = first; it != last; ++it) {
+            complete(*it, span ? span.get() + (span_begin(*it) - offset) : NULL, res_file->nodes[(*it)->index].data_length, span, lock);
+        }
+    }
+
+    void resource_loader_t::execute()
+    {
+        while (true) {
+            thread_lock_t lock(m_mutex, m_idle);
+            if (m_queue.empty()) {
+                m_idle->wait(lock);
+            } else {
+                std::vector<request_ptr_t> batch;
+                batch.swap(m_queue);
+                lock.unlock();
+
+                // one forward pass per archive instead of seeking back and forth
+                std::sort(batch.begin(), batch.end(), [] (const request_ptr_t& a, const request_ptr_t& b) {
+                    // unrelated pointers are only ordered by std::less
+                    return a->res_file != b->res_file ? std::less<ce_res_file*>()(a->res_file, b->res_file) : span_begin(a) < span_begin(b);
+                });
+
+                // merge nodes that are close enough into runs read at once;
+                // a node may end before an earlier one, so runs end at the furthest node end
+                std::vector<std::pair<size_t, size_t>> runs; // one past the last node and the end offset
+                for (size_t i = 0, first = 0, run_end = 0; i < batch.size(); ++i) {
+                    run_end = first == i ? span_end(batch[i]) : std::max(run_end, span_end(batch[i]));
+                    const size_t next = i + 1;
+                    if (batch.size() == next || batch[next]->res_file != batch[i]->res_file ||
+                            span_begin(batch[next]) > run_end + merge_gap ||
+                            std::max(run_end, span_end(batch[next])) - span_begin(batch[first]) > max_span_size) {
+                        runs.push_back(std::make_pair(next, run_end));
+                        first = next;
+                    }
+                }
+
+                // let the system fetch all runs ahead while the first ones are being read
+                for (size_t i = 0, first = 0; i < runs.size(); first = runs[i++].first) {
+                    const size_t offset = span_begin(batch[first]);
+                    ce_res_file_advise_range(batch[first]->res_file, offset, runs[i].second - offset);
+                }
+
+                for (size_t i = 0, first = 0; i < runs.size(); first = runs[i++].first) {
+                    read_run(batch.begin() + first, batch.begin() + runs[i].first, runs[i].second, lock);
+                }
+
+                lock.lock();
+            }
+            interruption_point();
+        }
+    }
 }
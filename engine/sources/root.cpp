@@ -33,6 +33,7 @@
 #include "mobmanager.hpp"
 #include "mobloader.hpp"
 #include "figuremanager.hpp"
+#include "startup.hpp"
 #include "root.hpp"
 
 namespace cursedearth
@@ -66,49 +67,65 @@ namespace cursedearth
 
         m_option_manager = make_option_manager(option_parser);
 
-        ce_resource_manager_init();
-        ce_config_manager_init();
-        ce_event_manager_init();
-
-        m_render_window = make_render_window(option_parser->title->str, m_input_context);
-
-        // TODO: try without window creation
-        if (m_option_manager->list_video_modes) {
-            //ce_displaymng_dump_supported_modes_to_stdout(renderwindow->displaymng);
-            throw game_error("root", "dump_supported_modes_to_stdout failed");
-        }
-
-        // TODO: try without window creation
-        if (m_option_manager->list_video_rotations) {
-            //ce_displaymng_dump_supported_rotations_to_stdout(renderwindow->displaymng);
-            throw game_error("root", "dump_supported_rotations_to_stdout failed");
-        }
-
-        // TODO: try without window creation
-        if (m_option_manager->list_video_reflections) {
-            //ce_displaymng_dump_supported_reflections_to_stdout(renderwindow->displaymng);
-            throw game_error("root", "dump_supported_reflections_to_stdout failed");
-        }
+        m_thread_pool = make_thread_pool();
+        m_resource_loader = make_resource_loader();
+
+        typedef startup_graph_t::affinity_t affinity_t;
+        startup_graph_t startup;
+
+        // archives and config files are read on workers while the main thread brings up the window
+        startup.add("resource manager", {}, affinity_t::any_thread, ce_resource_manager_init);
+        startup.add("config manager", {"resource manager"}, affinity_t::any_thread, ce_config_manager_init);
+        startup.add("texture manager", {}, affinity_t::any_thread, ce_texture_manager_init);
+        startup.add("sound", {}, affinity_t::any_thread, [this] {
+            m_sound_system = make_sound_system();
+            m_sound_mixer = make_sound_mixer();
+            m_sound_scheduler = make_sound_scheduler();
+            m_sound_manager = make_sound_manager();
+        });
+        startup.add("video", {}, affinity_t::any_thread, [this] {
+            initialize_avcodec();
+            m_video_manager = make_video_manager();
+        });
 
-        ce_render_system_init();
+        startup.add("event manager", {}, affinity_t::main_thread, ce_event_manager_init);
+        startup.add("render window", {"event manager"}, affinity_t::main_thread, [this, &option_parser] {
+            m_render_window = make_render_window(option_parser->title->str, m_input_context);
 
-        m_sound_system = make_sound_system();
-        m_sound_mixer = make_sound_mixer();
-        m_sound_manager = make_sound_manager();
-        m_video_manager = make_video_manager();
+            // TODO: try without window creation
+            if (m_option_manager->list_video_modes) {
+                //ce_displaymng_dump_supported_modes_to_stdout(renderwindow->displaymng);
+                throw game_error("root", "dump_supported_modes_to_stdout failed");
+            }
 
-        initialize_avcodec();
+            // TODO: try without window creation
+            if (m_option_manager->list_video_rotations) {
+                //ce_displaymng_dump_supported_rotations_to_stdout(renderwindow->displaymng);
+                throw game_error("root", "dump_supported_rotations_to_stdout failed");
+            }
 
-        ce_texture_manager_init();
-        ce_shader_manager_init();
+            // TODO: try without window creation
+            if (m_option_manager->list_video_reflections) {
+                //ce_displaymng_dump_supported_reflections_to_stdout(renderwindow->displaymng);
+                throw game_error("root", "dump_supported_reflections_to_stdout failed");
+            }
+        });
+        startup.add("render system", {"render window"}, affinity_t::main_thread, ce_render_system_init);
+        startup.add("shader manager", {"render system"}, affinity_t::main_thread, ce_shader_manager_init);
+
+        // cheap bookkeeping only: mob maps are parsed and figure archives opened on first use
+        startup.add("world", {}, affinity_t::main_thread, [] {
+            ce_mpr_manager_init();
+            ce_mob_manager_init();
+            ce_mob_loader_init();
+            ce_figure_manager_init();
+        });
 
-        ce_mpr_manager_init();
-        ce_mob_manager_init();
-        ce_mob_loader_init();
+        startup.add("scene manager", {"config manager", "texture manager", "sound", "video", "shader manager", "world"}, affinity_t::main_thread, [this, &option_parser] {
+            m_scene_manager = make_scene_manager(m_input_context, option_parser);
+        });
 
-        ce_figure_manager_init();
-        m_thread_pool = make_thread_pool();
-        m_scene_manager = make_scene_manager(m_input_context, option_parser);
+        startup.run();
 
         m_render_window->closed.connect([this] { m_done = true; });
         m_render_window->resized.connect([this] (size_t width, size_t height) {
@@ -149,6 +166,7 @@ namespace cursedearth
     root_t::~root_t()
     {
         m_scene_manager.reset();
+        m_resource_loader.reset();
         m_thread_pool.reset();
         ce_figure_manager_term();
         ce_mob_loader_term();
@@ -158,6 +176,7 @@ namespace cursedearth
         ce_texture_manager_term();
         m_video_manager.reset();
         m_sound_manager.reset();
+        m_sound_scheduler.reset();
         terminate_avcodec();
         m_sound_mixer.reset();
         m_sound_system.reset();
@@ -33,6 +33,7 @@
 #include "mprmanager.hpp"
 #include "mprhelpers.hpp"
 #include "mobloader.hpp"
+#include "soundmanager.hpp"
 #include "scenemanager.hpp"
 
 namespace cursedearth
@@ -43,6 +44,13 @@ namespace cursedearth
         ce_figproto_accept_renderqueue(figproto, scenemng->m_renderqueue);
     }
 
+    void ce_scenemng_figures_removing(void* listener)
+    {
+        // drop render items queued for the next frame, they are queued again on update
+        scene_manager_t* scenemng = (scene_manager_t*)listener;
+        ce_renderqueue_clear(scenemng->m_renderqueue);
+    }
+
     scene_manager_t::scene_manager_t(const input_context_const_ptr_t& input_context):
         singleton_t<scene_manager_t>(this),
         m_camera(ce_camera_new()),
@@ -64,7 +72,7 @@ namespace cursedearth
         m_zoom_out_event(m_input_supply->push(input_button_t::mb_wheeldown)),
         m_rotate_on_event(m_input_supply->push(input_button_t::mb_right))
     {
-        m_figure_manager_listener = {ce_scenemng_figproto_created, NULL, this};
+        m_figure_manager_listener = {ce_scenemng_figproto_created, NULL, ce_scenemng_figures_removing, this};
         ce_figure_manager_add_listener(&m_figure_manager_listener);
     }
 
@@ -72,6 +80,9 @@ namespace cursedearth
     {
         // FIXME: figure entities must be removed before terrain
         ce_figure_manager_clear();
+        if (NULL != m_terrain) {
+            ce_mob_loader_release_mprfile(m_terrain->mprfile);
+        }
         ce_terrain_del(m_terrain);
         ce_font_del(m_font);
         ce_camera_del(m_camera);
@@ -135,6 +146,11 @@ namespace cursedearth
                 deg2rad(ycoef * m_input_supply->pointer_offset().y));
         }
 
+        sound_listener_t listener;
+        listener.position = m_camera->position;
+        ce_camera_get_right(m_camera, &listener.right);
+        sound_manager_t::instance()->set_listener(listener);
+
         do_advance(elapsed);
     }
 
@@ -190,6 +206,9 @@ namespace cursedearth
         // TODO: mpr loader?
         ce_mprfile* mprfile = ce_mpr_manager_open(name);
         if (NULL != mprfile) {
+            if (NULL != m_terrain) {
+                ce_mob_loader_release_mprfile(m_terrain->mprfile);
+            }
             ce_terrain_del(m_terrain);
 
             m_terrain = ce_terrain_new(mprfile, m_renderqueue,
@@ -199,7 +218,7 @@ namespace cursedearth
 
     void scene_manager_t::load_mob(const std::string& name)
     {
-        ce_mob_loader_load_mob(name);
+        ce_mob_loader_load_mob(name, NULL != m_terrain ? m_terrain->mprfile : NULL);
     }
 
     void scene_manager_t::add_node(ce_scenenode* node)
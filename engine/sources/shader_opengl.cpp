@@ -165,4 +165,10 @@ namespace cursedearth
     {
         glUseProgram(0);
     }
+
+    void ce_shader_set_uniform_int(ce_shader* shader, const char* name, int value)
+    {
+        ce_shader_opengl* opengl_shader = (ce_shader_opengl*)shader->impl;
+        glUniform1i(glGetUniformLocation(opengl_shader->program, name), value);
+    }
 }
@@ -61,6 +61,20 @@ namespace cursedearth
         return std::move(pair);
     }
 
+    void sound_block_t::consume(size_t size)
+    {
+        assert(0 == size % m_format.sample_size);
+        assert(size <= read_size());
+        m_read_position += size;
+    }
+
+    void sound_block_t::commit(size_t size)
+    {
+        assert(0 == size % m_format.sample_size);
+        assert(size <= write_size());
+        m_write_position += size;
+    }
+
     void sound_block_t::reset()
     {
         m_write_position = 0;
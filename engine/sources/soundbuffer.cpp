@@ -19,72 +19,120 @@
  */
 
 #include "soundbuffer.hpp"
+#include "makeunique.hpp"
+#include "threadlock.hpp"
 
 namespace cursedearth
 {
-    sound_buffer_t::sound_buffer_t(const sound_format_t& format):
+    sound_buffer_t::sound_buffer_t(const sound_format_t& format, size_t block_count):
         m_format(format),
         m_sleeping(false),
         m_granule_position(0),
-        m_buffer(sound_options_t::block_count)
+        m_blocks(block_count),
+        m_write_index(0),
+        m_read_index(0),
+        m_waiter_count(0),
+        m_condition_variable(make_condition_variable())
     {
+        assert(0 != block_count);
+        for (auto& block: m_blocks) {
+            block = make_unique<sound_block_t>(m_format);
+        }
     }
 
-    void sound_buffer_t::push(const sound_block_ptr_t& block)
+    template <typename predicate_t>
+    void sound_buffer_t::wait(predicate_t predicate)
     {
-        m_buffer.push(block);
+        interruption_point();
+        if (predicate()) {
+            return;
+        }
+
+        struct waiter_t
+        {
+            std::atomic<size_t>& count;
+            explicit waiter_t(std::atomic<size_t>& count): count(count) { ++count; }
+            ~waiter_t() { --count; }
+        } waiter(m_waiter_count);
+        std::ignore = waiter;
+
+        thread_lock_t lock(m_mutex, m_condition_variable);
+        while (!predicate()) {
+            m_condition_variable->wait(lock);
+        }
     }
 
-    sound_block_ptr_t sound_buffer_t::pop()
+    void sound_buffer_t::notify()
     {
-        if (!m_current_block) {
-            m_buffer.pop(m_current_block);
+        // the other side registers itself before checking the indices under the mutex, so it can't miss this
+        if (0 != m_waiter_count) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::ignore = lock;
+            m_condition_variable->notify_all();
         }
-        m_granule_position += m_current_block->read_size();
-        return std::move(m_current_block);
     }
 
-    bool sound_buffer_t::try_read_one_sample(uint8_t data[sound_options_t::max_sample_size])
+    sound_block_t* sound_buffer_t::acquire(bool wait)
     {
-        if (!m_current_block) {
-            if (!m_buffer.pop(m_current_block, false)) {
-                return false;
+        if (full()) {
+            if (!wait) {
+                return nullptr;
             }
+            this->wait([this]{ return !full(); });
         }
-
-        const size_t size = m_current_block->read(data, m_format.sample_size);
-        if (0 == size) {
-            release(sound_block_ptr_t(std::move(m_current_block)));
-            return try_read_one_sample(data);
-        }
-
-        assert(size == m_format.sample_size);
-        m_granule_position += size;
-
-        return true;
+        sound_block_t* block = m_blocks[m_write_index % m_blocks.size()].get();
+        block->reset();
+        return block;
     }
 
-    sound_block_ptr_t sound_buffer_t::acquire()
+    void sound_buffer_t::push(sound_block_t* block)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        std::ignore = lock;
+        assert(block == m_blocks[m_write_index % m_blocks.size()].get());
+        std::ignore = block;
+        ++m_write_index;
+        notify();
+    }
 
-        if (m_blocks.empty()) {
-            return std::make_shared<sound_block_t>(m_format);
+    sound_block_t* sound_buffer_t::pop(bool wait)
+    {
+        if (0 == queued_block_count()) {
+            if (!wait) {
+                return nullptr;
+            }
+            this->wait([this]{ return 0 != queued_block_count(); });
         }
+        sound_block_t* block = front();
+        m_granule_position += block->read_size();
+        return block;
+    }
 
-        sound_block_ptr_t block = m_blocks.back();
-        m_blocks.pop_back();
+    void sound_buffer_t::release(sound_block_t* block)
+    {
+        assert(block == front());
+        std::ignore = block;
+        ++m_read_index;
+        notify();
+    }
 
-        block->reset();
-        return std::move(block);
+    std::pair<const uint8_t*, size_t> sound_buffer_t::try_read_span()
+    {
+        while (sound_block_t* block = front()) {
+            if (0 != block->read_size()) {
+                return block->read_span();
+            }
+            release(block);
+        }
+        return std::make_pair(nullptr, 0);
     }
 
-    void sound_buffer_t::release(const sound_block_ptr_t& block)
+    void sound_buffer_t::consume(size_t size)
     {
-        assert(m_format == block->format());
-        std::lock_guard<std::mutex> lock(m_mutex);
-        std::ignore = lock;
-        m_blocks.push_back(block);
+        sound_block_t* block = front();
+        assert(nullptr != block);
+        block->consume(size);
+        m_granule_position += size;
+        if (0 == block->read_size()) {
+            release(block);
+        }
     }
 }
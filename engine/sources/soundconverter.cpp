@@ -0,0 +1,252 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soundconverter.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace cursedearth
+{
+    namespace
+    {
+        void convert_u8_to_float(float* output, const uint8_t* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                output[i] = (static_cast<int>(input[i]) - 128) * (1.0f / 128.0f);
+            }
+        }
+
+        void convert_s16_to_float(float* output, const uint8_t* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                int16_t value;
+                std::memcpy(&value, input + 2 * i, 2);
+                output[i] = value * (1.0f / 32768.0f);
+            }
+        }
+
+        void convert_s24_to_float(float* output, const uint8_t* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, input += 3) {
+                // shift into the top of a 32-bit word to sign-extend
+                const int32_t value = static_cast<int32_t>(static_cast<uint32_t>(input[0]) << 8 |
+                                                           static_cast<uint32_t>(input[1]) << 16 |
+                                                           static_cast<uint32_t>(input[2]) << 24);
+                output[i] = value * (1.0f / 2147483648.0f);
+            }
+        }
+
+        void convert_s32_to_float(float* output, const uint8_t* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                int32_t value;
+                std::memcpy(&value, input + 4 * i, 4);
+                output[i] = value * (1.0f / 2147483648.0f);
+            }
+        }
+
+        void convert_f32_to_float(float* output, const uint8_t* input, size_t count)
+        {
+            std::memcpy(output, input, count * sizeof(float));
+        }
+
+        inline float saturate(float value)
+        {
+            return std::min(std::max(value, -1.0f), 1.0f);
+        }
+
+        void convert_float_to_u8(uint8_t* output, const float* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                output[i] = static_cast<uint8_t>(std::min(std::lrint(saturate(input[i]) * 128.0f), 127l) + 128);
+            }
+        }
+
+        void convert_float_to_s16(uint8_t* output, const float* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                const int16_t value = static_cast<int16_t>(std::min(std::lrint(saturate(input[i]) * 32768.0f), 32767l));
+                std::memcpy(output + 2 * i, &value, 2);
+            }
+        }
+
+        void convert_float_to_s24(uint8_t* output, const float* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, output += 3) {
+                const uint32_t value = static_cast<uint32_t>(std::min(std::lrint(saturate(input[i]) * 8388608.0f), 8388607l));
+                output[0] = value & 0xff;
+                output[1] = value >> 8 & 0xff;
+                output[2] = value >> 16 & 0xff;
+            }
+        }
+
+        void convert_float_to_s32(uint8_t* output, const float* input, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                // float can't hold 2^31 - 1 exactly, so saturate in double
+                const int32_t value = static_cast<int32_t>(std::min(std::llrint(saturate(input[i]) * 2147483648.0), 2147483647ll));
+                std::memcpy(output + 4 * i, &value, 4);
+            }
+        }
+
+        void convert_float_to_f32(uint8_t* output, const float* input, size_t count)
+        {
+            std::memcpy(output, input, count * sizeof(float));
+        }
+    }
+
+    void convert_to_float(float* output, const uint8_t* input, size_t value_count, const sound_format_t& format)
+    {
+        switch (format.bits_per_sample) {
+        case 8:
+            convert_u8_to_float(output, input, value_count);
+            break;
+        case 16:
+            convert_s16_to_float(output, input, value_count);
+            break;
+        case 24:
+            convert_s24_to_float(output, input, value_count);
+            break;
+        case 32:
+            (format.floating_point ? convert_f32_to_float : convert_s32_to_float)(output, input, value_count);
+            break;
+        default:
+            assert(false && "not implemented");
+            std::fill_n(output, value_count, 0.0f);
+        }
+    }
+
+    void convert_from_float(uint8_t* output, const float* input, size_t value_count, const sound_format_t& format)
+    {
+        switch (format.bits_per_sample) {
+        case 8:
+            convert_float_to_u8(output, input, value_count);
+            break;
+        case 16:
+            convert_float_to_s16(output, input, value_count);
+            break;
+        case 24:
+            convert_float_to_s24(output, input, value_count);
+            break;
+        case 32:
+            (format.floating_point ? convert_float_to_f32 : convert_float_to_s32)(output, input, value_count);
+            break;
+        default:
+            assert(false && "not implemented");
+            std::fill_n(output, value_count * (format.bits_per_sample / 8), 0);
+        }
+    }
+
+    sound_converter_t::sound_converter_t(const sound_buffer_ptr_t& buffer, const sound_format_t& native_format):
+        m_buffer(buffer),
+        m_native_format(native_format),
+        m_foreign(sound_options_t::samples_in_block * buffer->format().channel_count),
+        m_resampled(sound_options_t::samples_in_block * buffer->format().channel_count)
+    {
+        if (m_buffer->format().samples_per_second != m_native_format.samples_per_second) {
+            m_resampler = make_unique<sound_resampler_t>(m_buffer->format().samples_per_second,
+                m_native_format.samples_per_second, m_buffer->format().channel_count);
+        }
+    }
+
+    size_t sound_converter_t::read(float* output, size_t frame_count)
+    {
+        assert(frame_count <= sound_options_t::samples_in_block);
+        if (!m_resampler) {
+            frame_count = read_foreign(m_foreign.data(), frame_count);
+            map_channels(output, m_foreign.data(), frame_count);
+            return frame_count;
+        }
+
+        const size_t channel_count = m_buffer->format().channel_count;
+        size_t count = m_resampler->pull(m_resampled.data(), frame_count);
+        while (count < frame_count) {
+            const size_t input_count = std::min(m_resampler->input_frame_count(frame_count - count), sound_options_t::samples_in_block);
+            const size_t foreign_count = read_foreign(m_foreign.data(), input_count);
+            if (0 == foreign_count) {
+                break;
+            }
+            m_resampler->push(m_foreign.data(), foreign_count);
+            count += m_resampler->pull(m_resampled.data() + count * channel_count, frame_count - count);
+        }
+
+        map_channels(output, m_resampled.data(), count);
+        return count;
+    }
+
+    size_t sound_converter_t::skip(size_t frame_count)
+    {
+        const sound_format_t& format = m_buffer->format();
+        const size_t foreign_count = frame_count * format.samples_per_second / m_native_format.samples_per_second;
+        size_t count = 0;
+        while (count < foreign_count) {
+            const auto span = m_buffer->try_read_span();
+            if (0 == span.second) {
+                break;
+            }
+            const size_t span_count = std::min(span.second / format.sample_size, foreign_count - count);
+            m_buffer->consume(span_count * format.sample_size);
+            count += span_count;
+        }
+        if (m_resampler) {
+            // the history no longer matches the input, start over from silence
+            m_resampler->reset();
+        }
+        return count * m_native_format.samples_per_second / format.samples_per_second;
+    }
+
+    size_t sound_converter_t::read_foreign(float* output, size_t frame_count)
+    {
+        // convert straight out of the queued blocks
+        const sound_format_t& format = m_buffer->format();
+        size_t count = 0;
+        while (count < frame_count) {
+            const auto span = m_buffer->try_read_span();
+            if (0 == span.second) {
+                break;
+            }
+            const size_t span_count = std::min(span.second / format.sample_size, frame_count - count);
+            convert_to_float(output + count * format.channel_count, span.first, span_count * format.channel_count, format);
+            m_buffer->consume(span_count * format.sample_size);
+            count += span_count;
+        }
+        return count;
+    }
+
+    void sound_converter_t::map_channels(float* output, const float* input, size_t frame_count) const
+    {
+        const size_t native_channel_count = m_native_format.channel_count;
+        const size_t foreign_channel_count = m_buffer->format().channel_count;
+        if (native_channel_count == foreign_channel_count) {
+            std::copy_n(input, frame_count * native_channel_count, output);
+            return;
+        }
+
+        // extra foreign channels are dropped, missing ones repeat the last foreign channel
+        for (size_t i = 0; i < frame_count; ++i, output += native_channel_count, input += foreign_channel_count) {
+            for (size_t j = 0; j < native_channel_count; ++j) {
+                output[j] = input[std::min(j, foreign_channel_count - 1)];
+            }
+        }
+    }
+}
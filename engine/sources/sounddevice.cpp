@@ -19,18 +19,108 @@
  */
 
 #include "sounddevice.hpp"
+#include "byteorder.hpp"
+#include "exception.hpp"
 #include "logging.hpp"
 
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
 namespace cursedearth
 {
-    null_sound_device_t::null_sound_device_t(const sound_format_t& format):
-        sound_device_t(format)
+    null_sound_device_t::null_sound_device_t(const sound_format_t& format, bool realtime):
+        sound_device_t(format),
+        m_realtime(realtime)
     {
-        ce_logging_info("sound device: using null output");
+        ce_logging_info("sound device: using null output (%s)", m_realtime ? "real time" : "as fast as possible");
+    }
+
+    void null_sound_device_t::write(sound_block_t& block)
+    {
+        if (!m_realtime) {
+            return;
+        }
+
+        // sleep until a real device would have played everything written so far
+        if (0 == m_sample_count) {
+            m_start_time = std::chrono::steady_clock::now();
+        }
+        m_sample_count += block.read_raw().second / m_format.sample_size;
+        std::this_thread::sleep_until(m_start_time + std::chrono::microseconds(1000000 * m_sample_count / m_format.samples_per_second));
+    }
+
+    wave_sound_device_t::wave_sound_device_t(const sound_format_t& format, const boost::filesystem::path& path):
+        sound_device_t(format),
+        m_file(fopen(path.string().c_str(), "wb"))
+    {
+        if (NULL == m_file) {
+            throw game_error("sound device", "could not open file `%1%' for writing", path.string());
+        }
+        write_header();
+        ce_logging_info("sound device: writing output into `%s'", path.string().c_str());
+    }
+
+    wave_sound_device_t::~wave_sound_device_t()
+    {
+        // sizes are known only now
+        if (0 == fseek(m_file, 0, SEEK_SET)) {
+            write_header();
+        }
+        fclose(m_file);
+    }
+
+    void wave_sound_device_t::write_header()
+    {
+        // non-PCM formats need an extended fmt chunk (cbSize) and a fact chunk with the frame count
+        const bool extended = m_format.floating_point;
+        const uint16_t format_tag = extended ? 3 : 1; // WAVE_FORMAT_IEEE_FLOAT or WAVE_FORMAT_PCM
+        const uint32_t header_size = extended ? 58 : 44;
+        const uint32_t data_size = static_cast<uint32_t>(std::min<size_t>(m_data_size, UINT32_MAX - header_size));
+
+        std::vector<uint8_t> header;
+        header.reserve(header_size);
+        auto put_u16 = [&header](uint16_t value) {
+            value = cpu2le(value);
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+            header.insert(header.end(), bytes, bytes + 2);
+        };
+        auto put_u32 = [&header](uint32_t value) {
+            value = cpu2le(value);
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+            header.insert(header.end(), bytes, bytes + 4);
+        };
+
+        put_u32(UINT32_C(0x46464952)); // RIFF
+        put_u32(header_size - 8 + data_size);
+        put_u32(UINT32_C(0x45564157)); // WAVE
+        put_u32(UINT32_C(0x20746d66)); // fmt
+        put_u32(extended ? 18 : 16);
+        put_u16(format_tag);
+        put_u16(static_cast<uint16_t>(m_format.channel_count));
+        put_u32(static_cast<uint32_t>(m_format.samples_per_second));
+        put_u32(static_cast<uint32_t>(m_format.bytes_per_second));
+        put_u16(static_cast<uint16_t>(m_format.sample_size));
+        put_u16(static_cast<uint16_t>(m_format.bits_per_sample));
+        if (extended) {
+            put_u16(0); // cbSize
+            put_u32(UINT32_C(0x74636166)); // fact
+            put_u32(4);
+            put_u32(static_cast<uint32_t>(data_size / m_format.sample_size));
+        }
+        put_u32(UINT32_C(0x61746164)); // data
+        put_u32(data_size);
+
+        assert(header_size == header.size());
+        fwrite(header.data(), 1, header.size(), m_file);
     }
 
-    void null_sound_device_t::write(const sound_block_ptr_t&)
+    void wave_sound_device_t::write(sound_block_t& block)
     {
-        // TODO: sleep?
+        // WAV is little-endian, the mixer produces host order
+        assert(endian_t::little == host_order() || 8 == m_format.bits_per_sample || 24 == m_format.bits_per_sample);
+        auto data = block.read_raw();
+        m_data_size += fwrite(data.first, 1, data.second, m_file);
     }
 }
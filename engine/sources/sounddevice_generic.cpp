@@ -22,7 +22,7 @@
 
 namespace cursedearth
 {
-    sound_device_ptr_t make_sound_device(const sound_format_t& format)
+    sound_device_ptr_t make_sound_device(const sound_format_t& format, const sound_latency_t&)
     {
         return make_null_sound_device(format);
     }
@@ -46,7 +46,9 @@ namespace cursedearth
             }
         };
 
+        const sound_latency_t m_latency;
         std::unique_ptr<snd_pcm_t, snd_pcm_dtor_t> m_handle;
+        bool m_mmap = false;
 
         void debug_dump()
         {
@@ -76,13 +78,13 @@ namespace cursedearth
             snd_pcm_format_t format = SND_PCM_FORMAT_UNKNOWN;
             switch (static_cast<int>(m_format.bits_per_sample)) {
             case 8:
-                format = SND_PCM_FORMAT_S8;
+                format = SND_PCM_FORMAT_U8;
                 break;
             case 16:
                 format = SND_PCM_FORMAT_S16;
                 break;
             case 24:
-                format = SND_PCM_FORMAT_S24;
+                format = SND_PCM_FORMAT_S24_3LE;
                 break;
             case 32:
                 format = SND_PCM_FORMAT_S32;
@@ -116,10 +118,13 @@ namespace cursedearth
                 throw game_error("alsa", "resampling setup failed for playback");
             }
 
-            // set the interleaved read/write format
-            code = snd_pcm_hw_params_set_access(m_handle.get(), hwparams, SND_PCM_ACCESS_RW_INTERLEAVED);
-            if (code < 0) {
-                throw game_error("alsa", "access type not available for playback");
+            // prefer writing straight into the mmap'ed ring buffer, fall back to the interleaved read/write format
+            m_mmap = 0 == snd_pcm_hw_params_set_access(m_handle.get(), hwparams, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+            if (!m_mmap) {
+                code = snd_pcm_hw_params_set_access(m_handle.get(), hwparams, SND_PCM_ACCESS_RW_INTERLEAVED);
+                if (code < 0) {
+                    throw game_error("alsa", "access type not available for playback");
+                }
             }
 
             // set the sample format
@@ -147,7 +152,7 @@ namespace cursedearth
             }
 
             // ring buffer length in us
-            unsigned int buffer_time = 500000;
+            unsigned int buffer_time = m_latency.buffer_time;
 
             // set the buffer time
             code = snd_pcm_hw_params_set_buffer_time_near(m_handle.get(), hwparams, &buffer_time, &dir);
@@ -156,7 +161,7 @@ namespace cursedearth
             }
 
             // period time in us
-            unsigned int period_time = 100000;
+            unsigned int period_time = m_latency.period_time;
 
             // set the period time
             code = snd_pcm_hw_params_set_period_time_near(m_handle.get(), hwparams, &period_time, &dir);
@@ -178,6 +183,9 @@ namespace cursedearth
 
             snd_pcm_sframes_t period_size = size;
 
+            ce_logging_info("alsa: %s access, buffer of %ld frames (%u us), period of %ld frames (%u us)",
+                m_mmap ? "mmap" : "read/write", buffer_size, buffer_time, period_size, period_time);
+
             // write the parameters to device
             code = snd_pcm_hw_params(m_handle.get(), hwparams);
             if (code < 0) {
@@ -218,6 +226,7 @@ namespace cursedearth
 
             // under-run
             if (-EPIPE == code) {
+                ce_logging_warning("alsa: underrun #%zu", ++m_underrun_count);
                 code = snd_pcm_prepare(m_handle.get());
                 if (code < 0) {
                     throw game_error("alsa", "can't recovery from underrun, prepare failed: %1%", snd_strerror(code));
@@ -225,6 +234,7 @@ namespace cursedearth
             }
 
             if (-ESTRPIPE == code) {
+                ce_logging_warning("alsa: suspend #%zu", ++m_suspend_count);
                 while (-EAGAIN == (code = snd_pcm_resume(m_handle.get()))) {
                     sleep(1); // wait until the suspend flag is released
                 }
@@ -242,23 +252,25 @@ namespace cursedearth
             }
         }
 
-        virtual void write(const sound_block_ptr_t& block) final
+        virtual void write(sound_block_t& block) final
         {
-            auto data = block->read_raw();
-            for (size_t sample_count = data.second / block->format().sample_size; sample_count > 0; ) {
-                int code = snd_pcm_writei(m_handle.get(), data.first, sample_count);
+            auto data = block.read_raw();
+            for (size_t sample_count = data.second / block.format().sample_size; sample_count > 0; ) {
+                snd_pcm_sframes_t code = m_mmap ? snd_pcm_mmap_writei(m_handle.get(), data.first, sample_count) :
+                                                  snd_pcm_writei(m_handle.get(), data.first, sample_count);
                 if (code < 0) {
-                    recovery(code);
+                    recovery(static_cast<int>(code));
                 } else {
-                    data.first += code * block->format().sample_size;
+                    data.first += code * block.format().sample_size;
                     sample_count -= code;
                 }
             }
         }
 
     public:
-        explicit alsa_device_t(const sound_format_t& format):
-            sound_device_t(format)
+        alsa_device_t(const sound_format_t& format, const sound_latency_t& latency):
+            sound_device_t(format),
+            m_latency(latency)
         {
             ce_logging_info("sound system: using ALSA (Advanced Linux Sound Architecture)");
             snd_lib_error_set_handler(error_handler);
@@ -280,8 +292,8 @@ namespace cursedearth
         }
     };
 
-    sound_device_ptr_t make_sound_device(const sound_format_t& format)
+    sound_device_ptr_t make_sound_device(const sound_format_t& format, const sound_latency_t& latency)
     {
-        return std::make_shared<alsa_device_t>(format);
+        return std::make_shared<alsa_device_t>(format, latency);
     }
 }
@@ -92,7 +92,7 @@ namespace cursedearth
             return NULL;
         }
 
-        virtual void write(const sound_block_ptr_t& block)
+        virtual void write(sound_block_t& block)
         {
             ResetEvent(m_event);
 
@@ -109,7 +109,7 @@ namespace cursedearth
             }
 
             if (MMSYSERR_NOERROR == code) {
-                auto data = block->read_raw();
+                auto data = block.read_raw();
                 std::copy_n(data.first, data.second, header->data);
                 header->waveheader.dwBufferLength = data.second;
                 code = waveOutPrepareHeader(m_waveout, &header->waveheader, sizeof(WAVEHDR));
@@ -184,7 +184,7 @@ namespace cursedearth
         }
     };
 
-    sound_device_ptr_t make_sound_device(const sound_format_t& format)
+    sound_device_ptr_t make_sound_device(const sound_format_t& format, const sound_latency_t&)
     {
         return std::make_shared<wmm_device_t>(format);
     }
@@ -0,0 +1,73 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soundemitter.hpp"
+#include "soundoptions.hpp"
+#include "utility.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace cursedearth
+{
+    void sound_emitter_t::channel_gains(float* gains, size_t channel_count) const
+    {
+        const float left = left_gain, right = right_gain;
+        if (1 == channel_count) {
+            gains[0] = 0.5f * (left + right);
+            return;
+        }
+        gains[0] = left;
+        gains[1] = right;
+        for (size_t i = 2; i < channel_count; ++i) {
+            gains[i] = 0.5f * (left + right);
+        }
+    }
+
+    float spatialize(sound_emitter_t& emitter, const sound_listener_t& listener)
+    {
+        if (!emitter.positional) {
+            emitter.left_gain = emitter.volume;
+            emitter.right_gain = emitter.volume;
+            return emitter.volume;
+        }
+
+        vector3_t direction;
+        ce_vec3_sub(&direction, &emitter.position, &listener.position);
+        const float distance = ce_vec3_len(&direction);
+
+        // inverse distance attenuation, faded out towards the maximum distance
+        float gain = 0.0f;
+        if (distance < sound_options_t::max_distance) {
+            const float fade = 1.0f - distance / sound_options_t::max_distance;
+            const float reference_distance = sound_options_t::reference_distance;
+            gain = emitter.volume * fade * reference_distance / std::max(distance, reference_distance);
+        }
+
+        // equal-power panning; sounds right at the listener stay centered
+        const float pan = distance > g_epsilon_e3 ? clamp(ce_vec3_dot(&direction, &listener.right) / distance, -1.0f, 1.0f) : 0.0f;
+        const float angle = g_pi_div_4 * (pan + 1.0f);
+
+        // sqrt(2) keeps a centered sound as loud as a non-positional one
+        emitter.left_gain = gain * std::cos(angle) * std::sqrt(2.0f);
+        emitter.right_gain = gain * std::sin(angle) * std::sqrt(2.0f);
+        return gain;
+    }
+}
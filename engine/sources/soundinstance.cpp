@@ -20,63 +20,61 @@
 
 #include "soundinstance.hpp"
 #include "soundmixer.hpp"
-#include "threadlock.hpp"
+#include "soundscheduler.hpp"
 
 namespace cursedearth
 {
     sound_instance_t::sound_instance_t(ce_sound_resource* resource):
         m_state(SOUND_INSTANCE_STATE_STOPPED),
         m_bytes_per_second_inv(1.0f / resource->sound_format.bytes_per_second),
+        m_seconds_per_block(static_cast<float>(sound_options_t::samples_in_block) / resource->sound_format.samples_per_second),
         m_resource(resource),
-        m_buffer(sound_mixer_t::instance()->make_buffer(resource->sound_format)),
-        m_pause_condition(make_condition_variable()),
-        m_thread("sound instance", [this]{execute();})
+        m_emitter(make_sound_emitter()),
+        m_buffer(sound_mixer_t::instance()->make_buffer(resource->sound_format, m_emitter))
     {
+        m_buffer->sleep();
+        sound_scheduler_t::instance()->add(this);
     }
 
     sound_instance_t::~sound_instance_t()
     {
-        m_thread.temp();
+        sound_scheduler_t::instance()->remove(this);
+        sound_mixer_t::instance()->remove_buffer(m_buffer);
         ce_sound_resource_del(m_resource);
     }
 
     void sound_instance_t::change_state(sound_instance_state_t state)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        std::ignore = lock;
         m_state = state;
-        m_pause_condition->notify_all();
-    }
-
-    void sound_instance_t::pause()
-    {
-        m_buffer->sleep();
-        thread_lock_t lock(m_mutex, m_pause_condition);
-        m_pause_condition->wait(lock);
-        m_buffer->wakeup();
+        sound_scheduler_t::instance()->notify(this);
     }
 
-    void sound_instance_t::execute()
+    void sound_instance_t::process()
     {
-        pause();
-        while (true) {
-            switch (m_state) {
-            case SOUND_INSTANCE_STATE_PLAYING:
-                if (!ce_sound_resource_read(m_resource, m_buffer)) {
-                    change_state(SOUND_INSTANCE_STATE_STOPPED);
-                }
+        switch (m_state) {
+        case SOUND_INSTANCE_STATE_PLAYING:
+            m_buffer->wakeup();
+            if (ce_sound_resource_read(m_resource, m_buffer)) {
                 break;
+            }
+            {
+                // end of stream, unless the state has been changed meanwhile
+                sound_instance_state_t state = SOUND_INSTANCE_STATE_PLAYING;
+                if (!m_state.compare_exchange_strong(state, SOUND_INSTANCE_STATE_STOPPED)) {
+                    break;
+                }
+            }
+            // fall through
 
-            case SOUND_INSTANCE_STATE_PAUSED:
-                pause();
-                break;
+        case SOUND_INSTANCE_STATE_STOPPED:
+            ce_sound_resource_reset(m_resource);
+            m_buffer->reset_granule_position();
+            m_buffer->sleep();
+            break;
 
-            case SOUND_INSTANCE_STATE_STOPPED:
-                ce_sound_resource_reset(m_resource);
-                m_buffer->reset_granule_position();
-                pause();
-                break;
-            }
+        case SOUND_INSTANCE_STATE_PAUSED:
+            m_buffer->sleep();
+            break;
         }
     }
 }
@@ -19,9 +19,15 @@
  */
 
 #include "soundmanager.hpp"
+#include "soundsystem.hpp"
+#include "soundconverter.hpp"
+#include "soundscheduler.hpp"
 #include "optionmanager.hpp"
 #include "resball.hpp"
 
+#include <algorithm>
+#include <tuple>
+
 #include <boost/filesystem.hpp>
 
 namespace cursedearth
@@ -76,8 +82,39 @@ namespace cursedearth
         return res_file;
     }
 
+    sound_sample_ptr_t load_sound_sample(ce_sound_resource* resource)
+    {
+        const sound_format_t& format = sound_system_t::instance()->format();
+        const size_t max_value_count = format.channel_count * (format.samples_per_second * sound_options_t::max_bank_sample_milliseconds / 1000);
+
+        // run the resource through the same conversion as the mixer does, but only once
+        sound_buffer_ptr_t buffer = std::make_shared<sound_buffer_t>(resource->sound_format);
+        sound_converter_t converter(buffer, format);
+        std::vector<float> values, frames(sound_options_t::samples_in_block * format.channel_count);
+
+        while (ce_sound_resource_read(resource, buffer)) {
+            while (const size_t count = converter.read(frames.data(), sound_options_t::samples_in_block)) {
+                values.insert(values.end(), frames.begin(), frames.begin() + count * format.channel_count);
+            }
+            if (values.size() > max_value_count) {
+                // too long, keep streaming it
+                return nullptr;
+            }
+        }
+
+        if (values.empty()) {
+            return nullptr;
+        }
+
+        values.shrink_to_fit();
+        return std::make_shared<sound_sample_t>(std::move(values), format.channel_count);
+    }
+
     sound_manager_t::sound_manager_t():
-        singleton_t<sound_manager_t>(this)
+        singleton_t<sound_manager_t>(this),
+        m_voice_count(option_manager_t::instance()->sound_voice_count()),
+        m_listener{ CE_VEC3_ZERO, CE_VEC3_UNIT_X },
+        m_bank(std::make_shared<bank_t>())
     {
         for (const auto& directory: ce_sound_dirs) {
             fs::path path = option_manager_t::instance()->ei_path() / directory;
@@ -100,9 +137,100 @@ namespace cursedearth
 
     void sound_manager_t::advance(float /*elapsed*/)
     {
+        m_candidates.clear();
+        for (const auto& instance: m_instances) {
+            if (SOUND_INSTANCE_STATE_PLAYING == instance.second->state()) {
+                sound_emitter_t& emitter = *instance.second->emitter();
+                m_candidates.push_back({ instance.first, &emitter, spatialize(emitter, m_listener) });
+            }
+        }
+        for (const auto& voice: m_voices) {
+            if (SOUND_INSTANCE_STATE_PLAYING == voice.second->state()) {
+                sound_emitter_t& emitter = *voice.second->emitter();
+                m_candidates.push_back({ voice.first, &emitter, spatialize(emitter, m_listener) });
+            }
+        }
+
+        // inaudible ones go last, then by priority, then the loudest first;
+        // ties go to the older sound, so hash map order can't flip voices between frames
+        std::sort(m_candidates.begin(), m_candidates.end(), [](const candidate_t& lhs, const candidate_t& rhs) {
+            const bool lhs_audible = lhs.gain >= sound_options_t::audible_gain;
+            const bool rhs_audible = rhs.gain >= sound_options_t::audible_gain;
+            if (lhs_audible != rhs_audible) {
+                return lhs_audible;
+            }
+            if (lhs.emitter->priority != rhs.emitter->priority) {
+                return lhs.emitter->priority > rhs.emitter->priority;
+            }
+            if (lhs.gain != rhs.gain) {
+                return lhs.gain > rhs.gain;
+            }
+            return lhs.object < rhs.object;
+        });
+
+        size_t voice_count = 0;
+        for (const auto& candidate: m_candidates) {
+            const bool audible = candidate.gain >= sound_options_t::audible_gain && voice_count < m_voice_count;
+            candidate.emitter->audible = audible;
+            voice_count += audible;
+        }
+    }
+
+    sound_emitter_ptr_t sound_manager_t::find_emitter(sound_object_t object)
+    {
+        if (sound_instance_ptr_t instance = find_instance(object)) {
+            return instance->emitter();
+        }
+        sound_voice_ptr_t voice = find_voice(object);
+        return voice ? voice->emitter() : nullptr;
     }
 
     sound_object_t sound_manager_t::make_instance(const std::string& name)
+    {
+        bool unknown;
+        {
+            std::lock_guard<std::mutex> lock(m_bank->mutex);
+            std::ignore = lock;
+            auto it = m_bank->samples.find(name);
+            if (m_bank->samples.end() != it && it->second) {
+                // banked: no file access and no decoding
+                const sound_object_t object = ++m_last_object;
+                m_voices.insert({ object, std::make_shared<sound_voice_t>(it->second) });
+                return object;
+            }
+            unknown = m_bank->samples.end() == it;
+            if (unknown) {
+                m_bank->samples.insert({ name, nullptr });
+            }
+        }
+
+        ce_sound_resource* resource = open_resource(name);
+        if (NULL == resource) {
+            return 0;
+        }
+
+        if (unknown) {
+            // this one is streamed, later ones are mixed from the bank once decoded
+            bank_sample(name);
+        }
+
+        const sound_object_t object = ++m_last_object;
+        m_instances.insert({ object, std::make_shared<sound_instance_t>(resource) });
+        return object;
+    }
+
+    void sound_manager_t::remove_instance(sound_object_t object)
+    {
+        m_instances.erase(object);
+        auto it = m_voices.find(object);
+        if (m_voices.end() != it) {
+            // the mixer may still hold it
+            it->second->change_state(SOUND_INSTANCE_STATE_STOPPED);
+            m_voices.erase(it);
+        }
+    }
+
+    ce_sound_resource* sound_manager_t::open_resource(const std::string& name)
     {
         ce_mem_file* mem_file = NULL;
         for (const auto& file: m_files) {
@@ -115,13 +243,13 @@ namespace cursedearth
             fs::path path = find_sound(name);
             if (path.empty()) {
                 ce_logging_error("sound manager: could not find sound `%s'", name.c_str());
-                return 0;
+                return NULL;
             }
 
             mem_file = ce_mem_file_new_path(path);
             if (NULL == mem_file) {
                 ce_logging_error("sound manager: could not open file `%s'", path.string().c_str());
-                return 0;
+                return NULL;
             }
         }
 
@@ -129,13 +257,29 @@ namespace cursedearth
         if (NULL == resource) {
             ce_logging_error("sound manager: could not create resource `%s'", name.c_str());
             ce_mem_file_del(mem_file);
-            return 0;
         }
 
-        const sound_object_t object = ++m_last_object;
-        sound_instance_ptr_t instance = std::make_shared<sound_instance_t>(resource);
+        return resource;
+    }
 
-        m_instances.insert({ object, instance });
-        return object;
+    void sound_manager_t::bank_sample(const std::string& name)
+    {
+        ce_sound_resource* resource = open_resource(name);
+        if (NULL == resource) {
+            return;
+        }
+
+        // the decode threads own the resource from now on
+        std::shared_ptr<ce_sound_resource> shared_resource(resource, ce_sound_resource_del);
+        std::shared_ptr<bank_t> bank = m_bank;
+        sound_scheduler_t::instance()->post([bank, name, shared_resource] {
+            sound_sample_ptr_t sample = load_sound_sample(shared_resource.get());
+            if (sample) {
+                ce_logging_debug("sound manager: `%s' is banked (%zu frames)", name.c_str(), sample->frame_count());
+                std::lock_guard<std::mutex> lock(bank->mutex);
+                std::ignore = lock;
+                bank->samples[name] = std::move(sample);
+            }
+        });
     }
 }
@@ -32,72 +32,96 @@ namespace cursedearth
 
     sound_mixer_t::~sound_mixer_t()
     {
-        if (!m_buffers.empty()) {
+        if (!m_sources.empty()) {
             ce_logging_warning("sound mixer: some buffers have not been unregistered");
         }
     }
 
-    sound_buffer_ptr_t sound_mixer_t::make_buffer(const sound_format_t& format)
+    sound_buffer_ptr_t sound_mixer_t::make_buffer(const sound_format_t& format, const sound_emitter_ptr_t& emitter)
     {
         sound_buffer_ptr_t buffer = std::make_shared<sound_buffer_t>(format);
+        sound_converter_ptr_t converter = make_sound_converter(buffer, sound_system_t::instance()->format());
         std::lock_guard<std::mutex> lock(m_mutex);
         std::ignore = lock;
-        m_buffers.push_back(buffer);
+        m_sources.push_back({ std::move(converter), emitter });
         return buffer;
     }
 
-    void convert_sample_s16_s16(int16_t* native, const int16_t* foreign, const sound_format_t& native_format, const sound_format_t& foreign_format)
+    void sound_mixer_t::remove_buffer(const sound_buffer_ptr_t& buffer)
     {
-        for (size_t i = 0; i < native_format.channel_count; ++i) {
-            native[i] = (0 == i || i < foreign_format.channel_count) ? foreign[i] : native[i - 1];
-        }
-    }
-
-    void convert_sample(void* native, const void* foreign, const sound_format_t& native_format, const sound_format_t& foreign_format)
-    {
-        if (16 != native_format.bits_per_sample || 16 != foreign_format.bits_per_sample) {
-            assert(false && "not implemented");
-        }
-        convert_sample_s16_s16(static_cast<int16_t*>(native), static_cast<const int16_t*>(foreign), native_format, foreign_format);
-    }
-
-    void mix_sample_s16(int16_t* sample, const int16_t* other, const sound_format_t& format)
-    {
-        for (size_t i = 0; i < format.channel_count; ++i) {
-            int32_t value = static_cast<int32_t>(sample[i]) + static_cast<int32_t>(other[i]);
-            sample[i] = clamp(value, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
-        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+        m_sources.remove_if([&buffer](const source_t& source) { return buffer == source.converter->buffer(); });
     }
 
-    void mix_sample(void* sample, const void* other, const sound_format_t& format)
+    void sound_mixer_t::add_voice(const sound_voice_ptr_t& voice)
     {
-        if (16 != format.bits_per_sample) {
-            assert(false && "not implemented");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+        if (!voice->m_active) {
+            voice->m_active = true;
+            m_voices.push_back(voice);
         }
-        mix_sample_s16(static_cast<int16_t*>(sample), static_cast<const int16_t*>(other), format);
     }
 
     void sound_mixer_t::execute()
     {
-        uint8_t array[sound_options_t::max_block_size];
-        uint8_t native_sample[sound_options_t::max_sample_size];
-        uint8_t foreign_sample[sound_options_t::max_sample_size];
+        const sound_format_t& format = sound_system_t::instance()->format();
+        const size_t value_count = sound_options_t::samples_in_block * format.channel_count;
+        std::vector<float> mix(value_count), frames(value_count), gains(format.channel_count);
         while (true) {
-            uint8_t* data = array;
-            for (size_t i = 0; i < sound_options_t::samples_in_block; ++i, data += sound_system_t::instance()->format().sample_size) {
-                std::fill_n(data, sound_system_t::instance()->format().sample_size, 0);
+            const auto start_time = std::chrono::steady_clock::now();
+            size_t starved_buffer_count = 0;
+            std::fill(mix.begin(), mix.end(), 0.0f);
+            {
                 std::lock_guard<std::mutex> lock(m_mutex);
                 std::ignore = lock;
-                for (const auto& buffer: m_buffers) {
-                    if (!buffer->sleeping() && buffer->try_read_one_sample(foreign_sample)) {
-                        convert_sample(native_sample, foreign_sample, sound_system_t::instance()->format(), buffer->format());
-                        mix_sample(data, native_sample, buffer->format());
+                for (const auto& source: m_sources) {
+                    const sound_converter_ptr_t& converter = source.converter;
+                    if (!converter->buffer()->sleeping()) {
+                        if (!source.emitter->audible) {
+                            // virtual: streams can't seek, so their blocks are still decoded, but dropped here
+                            if (converter->skip(sound_options_t::samples_in_block) < sound_options_t::samples_in_block) {
+                                ++starved_buffer_count;
+                            }
+                            continue;
+                        }
+                        const size_t count = converter->read(frames.data(), sound_options_t::samples_in_block);
+                        if (count < sound_options_t::samples_in_block) {
+                            ++starved_buffer_count;
+                        }
+                        source.emitter->channel_gains(gains.data(), format.channel_count);
+                        for (size_t i = 0; i < count; ++i) {
+                            for (size_t j = 0; j < format.channel_count; ++j) {
+                                mix[i * format.channel_count + j] += frames[i * format.channel_count + j] * gains[j];
+                            }
+                        }
+                    }
+                }
+                for (auto it = m_voices.begin(); it != m_voices.end();) {
+                    sound_voice_t* voice = it->get();
+                    bool playing = SOUND_INSTANCE_STATE_PLAYING == voice->state();
+                    if (playing && voice->emitter()->audible) {
+                        voice->emitter()->channel_gains(gains.data(), format.channel_count);
+                        playing = voice->mix(mix.data(), sound_options_t::samples_in_block, format.channel_count, gains.data());
+                    } else if (playing) {
+                        playing = voice->skip(sound_options_t::samples_in_block);
+                    }
+                    if (playing) {
+                        ++it;
+                    } else {
+                        // stopped, paused or finished: drop it until it is played again
+                        voice->m_active = false;
+                        it = m_voices.erase(it);
                     }
                 }
-                interruption_point();
             }
-            sound_block_ptr_t block = sound_system_t::instance()->map();
-            block->write(array, block->format().sample_size * sound_options_t::samples_in_block);
+            interruption_point();
+            sound_system_t::instance()->account_mix(std::chrono::steady_clock::now() - start_time, starved_buffer_count);
+            sound_block_t* block = sound_system_t::instance()->map();
+            assert(block->write_span().second >= format.sample_size * sound_options_t::samples_in_block);
+            convert_from_float(block->write_span().first, mix.data(), value_count, format);
+            block->commit(format.sample_size * sound_options_t::samples_in_block);
             sound_system_t::instance()->unmap(block);
         }
     }
@@ -28,19 +28,22 @@ namespace cursedearth
         return sound_manager_t::instance()->make_instance(name);
     }
 
-    void remove_sound_object(sound_object_t)
+    void remove_sound_object(sound_object_t sound_object)
     {
+        sound_manager_t::instance()->remove_instance(sound_object);
     }
 
     bool sound_object_is_valid(sound_object_t sound_object)
     {
-        return 0 != sound_object && sound_manager_t::instance()->find_instance(sound_object);
+        return 0 != sound_object && (sound_manager_t::instance()->find_instance(sound_object) || sound_manager_t::instance()->find_voice(sound_object));
     }
 
     void sound_object_advance(sound_object_t sound_object, float elapsed)
     {
         if (sound_instance_ptr_t sound_instance = sound_manager_t::instance()->find_instance(sound_object)) {
             sound_instance->advance(elapsed);
+        } else if (sound_voice_ptr_t sound_voice = sound_manager_t::instance()->find_voice(sound_object)) {
+            sound_voice->advance(elapsed);
         }
     }
 
@@ -54,36 +57,67 @@ namespace cursedearth
         return SOUND_INSTANCE_STATE_PAUSED == get_sound_object_state(sound_object);
     }
 
-    void play_sound_object(sound_object_t sound_object)
+    void change_sound_object_state(sound_object_t sound_object, sound_instance_state_t state)
     {
         if (sound_instance_ptr_t sound_instance = sound_manager_t::instance()->find_instance(sound_object)) {
-            sound_instance->change_state(SOUND_INSTANCE_STATE_PLAYING);
+            sound_instance->change_state(state);
+        } else if (sound_voice_ptr_t sound_voice = sound_manager_t::instance()->find_voice(sound_object)) {
+            sound_voice->change_state(state);
         }
     }
 
+    void play_sound_object(sound_object_t sound_object)
+    {
+        change_sound_object_state(sound_object, SOUND_INSTANCE_STATE_PLAYING);
+    }
+
     void pause_sound_object(sound_object_t sound_object)
+    {
+        change_sound_object_state(sound_object, SOUND_INSTANCE_STATE_PAUSED);
+    }
+
+    void stop_sound_object(sound_object_t sound_object)
+    {
+        change_sound_object_state(sound_object, SOUND_INSTANCE_STATE_STOPPED);
+    }
+
+    int get_sound_object_state(sound_object_t sound_object)
     {
         if (sound_instance_ptr_t sound_instance = sound_manager_t::instance()->find_instance(sound_object)) {
-            sound_instance->change_state(SOUND_INSTANCE_STATE_PAUSED);
+            return sound_instance->state();
         }
+        sound_voice_ptr_t sound_voice = sound_manager_t::instance()->find_voice(sound_object);
+        return sound_voice ? sound_voice->state() : SOUND_INSTANCE_STATE_STOPPED;
     }
 
-    void stop_sound_object(sound_object_t sound_object)
+    float get_sound_object_time(sound_object_t sound_object)
     {
         if (sound_instance_ptr_t sound_instance = sound_manager_t::instance()->find_instance(sound_object)) {
-            sound_instance->change_state(SOUND_INSTANCE_STATE_STOPPED);
+            return sound_instance->time();
         }
+        sound_voice_ptr_t sound_voice = sound_manager_t::instance()->find_voice(sound_object);
+        return sound_voice ? sound_voice->time() : 0.0f;
     }
 
-    int get_sound_object_state(sound_object_t sound_object)
+    void set_sound_object_position(sound_object_t sound_object, const vector3_t& position)
     {
-        sound_instance_ptr_t sound_instance = sound_manager_t::instance()->find_instance(sound_object);
-        return sound_instance ? sound_instance->state() : SOUND_INSTANCE_STATE_STOPPED;
+        if (sound_emitter_ptr_t sound_emitter = sound_manager_t::instance()->find_emitter(sound_object)) {
+            sound_emitter->positional = true;
+            sound_emitter->position = position;
+        }
     }
 
-    float get_sound_object_time(sound_object_t sound_object)
+    void set_sound_object_priority(sound_object_t sound_object, int priority)
     {
-        sound_instance_ptr_t sound_instance = sound_manager_t::instance()->find_instance(sound_object);
-        return sound_instance ? sound_instance->time() : 0.0f;
+        if (sound_emitter_ptr_t sound_emitter = sound_manager_t::instance()->find_emitter(sound_object)) {
+            sound_emitter->priority = priority;
+        }
+    }
+
+    void set_sound_object_volume(sound_object_t sound_object, float volume)
+    {
+        if (sound_emitter_ptr_t sound_emitter = sound_manager_t::instance()->find_emitter(sound_object)) {
+            sound_emitter->volume = volume;
+        }
     }
 }
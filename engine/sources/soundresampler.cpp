@@ -0,0 +1,146 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soundresampler.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+namespace cursedearth
+{
+    namespace
+    {
+        const double pi = 3.14159265358979323846;
+        const double kaiser_beta = 8.0;
+
+        size_t gcd(size_t a, size_t b)
+        {
+            while (0 != b) {
+                const size_t c = a % b;
+                a = b;
+                b = c;
+            }
+            return a;
+        }
+
+        // zeroth order modified Bessel function of the first kind
+        double bessel_i0(double x)
+        {
+            double sum = 1.0, term = 1.0;
+            for (size_t k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        double kaiser(double x)
+        {
+            return std::abs(x) > 1.0 ? 0.0 : bessel_i0(kaiser_beta * std::sqrt(1.0 - x * x)) / bessel_i0(kaiser_beta);
+        }
+
+        double sinc(double x)
+        {
+            return std::abs(x) < 1e-9 ? 1.0 : std::sin(pi * x) / (pi * x);
+        }
+    }
+
+    sound_resampler_t::sound_resampler_t(size_t input_rate, size_t output_rate, size_t channel_count):
+        m_channel_count(channel_count),
+        m_up(output_rate / gcd(input_rate, output_rate)),
+        m_down(input_rate / gcd(input_rate, output_rate)),
+        m_phase_count(std::min(m_up, max_phase_count)),
+        m_position(0),
+        m_phase(0)
+    {
+        assert(0 != input_rate && 0 != output_rate && 0 != channel_count);
+
+        // downsampling moves the cutoff below the output Nyquist frequency and widens the kernel
+        const double cutoff = 0.95 * std::min(1.0, static_cast<double>(m_up) / m_down);
+        m_tap_count = 2 * static_cast<size_t>(std::ceil(zero_crossing_count / cutoff));
+
+        const double half_width = 0.5 * m_tap_count;
+        m_filters.resize(m_phase_count * m_tap_count);
+        for (size_t phase = 0; phase < m_phase_count; ++phase) {
+            float* filter = m_filters.data() + phase * m_tap_count;
+            const double center = half_width - 1.0 + static_cast<double>(phase) / m_phase_count;
+            double sum = 0.0;
+            for (size_t tap = 0; tap < m_tap_count; ++tap) {
+                const double x = tap - center;
+                const double value = cutoff * sinc(cutoff * x) * kaiser(x / half_width);
+                filter[tap] = static_cast<float>(value);
+                sum += value;
+            }
+            // unity gain for every phase, so DC passes through untouched
+            for (size_t tap = 0; tap < m_tap_count; ++tap) {
+                filter[tap] = static_cast<float>(filter[tap] / sum);
+            }
+        }
+
+        reset();
+    }
+
+    size_t sound_resampler_t::input_frame_count(size_t output_frame_count) const
+    {
+        const size_t required = m_position + m_tap_count + (m_phase + output_frame_count * m_down) / m_up;
+        const size_t available = m_frames.size() / m_channel_count;
+        return required > available ? required - available : 0;
+    }
+
+    void sound_resampler_t::push(const float* input, size_t frame_count)
+    {
+        // drop the history no longer reachable by the filter before growing
+        if (m_position > 0 && m_position * m_channel_count >= m_frames.size() / 2) {
+            m_frames.erase(m_frames.begin(), m_frames.begin() + m_position * m_channel_count);
+            m_position = 0;
+        }
+        m_frames.insert(m_frames.end(), input, input + frame_count * m_channel_count);
+    }
+
+    size_t sound_resampler_t::pull(float* output, size_t frame_count)
+    {
+        const size_t available = m_frames.size() / m_channel_count;
+        size_t count = 0;
+        for (; count < frame_count && m_position + m_tap_count <= available; ++count) {
+            const float* filter = m_filters.data() + (m_phase * m_phase_count / m_up) * m_tap_count;
+            const float* frames = m_frames.data() + m_position * m_channel_count;
+            float* frame = output + count * m_channel_count;
+            std::fill_n(frame, m_channel_count, 0.0f);
+            for (size_t tap = 0; tap < m_tap_count; ++tap, frames += m_channel_count) {
+                for (size_t channel = 0; channel < m_channel_count; ++channel) {
+                    frame[channel] += filter[tap] * frames[channel];
+                }
+            }
+            m_phase += m_down;
+            m_position += m_phase / m_up;
+            m_phase %= m_up;
+        }
+        return count;
+    }
+
+    void sound_resampler_t::reset()
+    {
+        // prime with silence so that the first output frame lines up with the first input frame
+        m_frames.assign((m_tap_count / 2 - 1) * m_channel_count, 0.0f);
+        m_position = 0;
+        m_phase = 0;
+    }
+}
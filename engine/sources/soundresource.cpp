@@ -88,20 +88,28 @@ namespace cursedearth
 
     bool ce_sound_resource_read(ce_sound_resource* resource, const sound_buffer_ptr_t& buffer)
     {
-        if (0 == resource->output_buffer_size) {
-            resource->output_buffer_pos = 0;
-            if (!(*resource->vtable.decode)(resource)) {
-                return false;
+        sound_block_t* block = buffer->acquire();
+
+        // decode until the block is full, so that the mixer always gets whole blocks except at the end of stream
+        while (0 != block->write_size()) {
+            if (0 == resource->output_buffer_size) {
+                resource->output_buffer_pos = 0;
+                if (!(*resource->vtable.decode)(resource) || 0 == resource->output_buffer_size) {
+                    break;
+                }
             }
-        }
 
-        sound_block_ptr_t block = buffer->acquire();
-        size_t size = block->write(resource->output_buffer + resource->output_buffer_pos, resource->output_buffer_size);
-        buffer->push(block);
+            size_t size = block->write(resource->output_buffer + resource->output_buffer_pos, resource->output_buffer_size);
+            resource->output_buffer_pos += size;
+            resource->output_buffer_size -= size;
+        }
 
-        resource->output_buffer_pos += size;
-        resource->output_buffer_size -= size;
+        if (0 == block->read_size()) {
+            // nothing decoded, the block stays unpublished and is reused by the next acquire
+            return false;
+        }
 
+        buffer->push(block);
         return true;
     }
 
@@ -46,10 +46,10 @@ extern "C"
 }
 
 #include "alloc.hpp"
-#include "byteorder.hpp"
 #include "logging.hpp"
 #include "wave.hpp"
 #include "bink.hpp"
+#include "soundsamples.hpp"
 #include "soundresource.hpp"
 
 namespace cursedearth
@@ -61,6 +61,7 @@ namespace cursedearth
     {
         OggVorbis_File vf;
         int bitstream;
+        sound_dither_t dither;
     };
 
     size_t ce_vorbis_read_wrap(void* ptr, size_t size, size_t nmemb, void* datasource)
@@ -108,6 +109,7 @@ namespace cursedearth
     {
         ce_vorbis* vorbis = (ce_vorbis*)sound_resource->impl;
         memcpy(&vorbis->vf, sound_probe->buffer, sizeof(OggVorbis_File));
+        vorbis->dither = sound_dither_t();
 
         if (0 != ov_test_open(&vorbis->vf)) {
             ce_logging_error("vorbis: input does not appear to be an Ogg Vorbis audio");
@@ -120,7 +122,7 @@ namespace cursedearth
             return false;
         }
 
-        // a vorbis file has no particular number of bits per sample, so use words, see also ov_read
+        // a vorbis file has no particular number of bits per sample, so use words, see also ce_vorbis_decode
         sound_resource->sound_format = sound_format_t(16, info->rate, info->channels);
 
         ce_logging_debug("vorbis: audio is %ld bits per second (%ld bits per second nominal)",
@@ -138,14 +140,20 @@ namespace cursedearth
     bool ce_vorbis_decode(ce_sound_resource* sound_resource)
     {
         ce_vorbis* vorbis = (ce_vorbis*)sound_resource->impl;
+        const size_t channel_count = sound_resource->sound_format.channel_count;
 
         for (;;) {
-            long code = ov_read(&vorbis->vf, reinterpret_cast<char*>(sound_resource->output_buffer),
-                sound_resource->output_buffer_capacity, endian_t::big == host_order(), 2, 1, &vorbis->bitstream);
-            if (code >= 0) {
-                sound_resource->output_buffer_size = code;
+            // take planar floats and convert the whole packet at once instead of letting ov_read do it per sample
+            float** pcm;
+            long code = ov_read_float(&vorbis->vf, &pcm, static_cast<int>(sound_resource->output_buffer_capacity / (2 * channel_count)), &vorbis->bitstream);
+            if (code > 0) {
+                interleave_float_to_s16(reinterpret_cast<int16_t*>(sound_resource->output_buffer), pcm, channel_count, code, vorbis->dither);
+                sound_resource->output_buffer_size = 2 * channel_count * code;
                 return true;
             }
+            if (0 == code) {
+                return false;
+            }
             ce_logging_warning("vorbis: error in the stream");
         }
 
@@ -295,11 +303,7 @@ namespace cursedearth
         ce_flac_bundle* flac_bundle = (ce_flac_bundle*)client_data;
         flac_bundle->block_size = frame->header.blocksize;
 
-        for (unsigned int i = 0; i < frame->header.blocksize; ++i) {
-            for (unsigned int j = 0; j < frame->header.channels; ++j) {
-                flac_bundle->buffer[i * frame->header.channels + j] = buffer[j][i];
-            }
-        }
+        interleave_integer_to_s16(flac_bundle->buffer, buffer, frame->header.channels, frame->header.blocksize, frame->header.bits_per_sample);
 
         return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
     }
@@ -311,7 +315,8 @@ namespace cursedearth
         if (FLAC__METADATA_TYPE_STREAMINFO == metadata->type) {
             flac_bundle->min_block_size = metadata->data.stream_info.min_blocksize;
             flac_bundle->max_block_size = metadata->data.stream_info.max_blocksize;
-            flac_bundle->sound_format = sound_format_t(metadata->data.stream_info.bits_per_sample, metadata->data.stream_info.sample_rate, metadata->data.stream_info.channels);
+            // samples are rescaled to words, see ce_flac_write_callback
+            flac_bundle->sound_format = sound_format_t(16, metadata->data.stream_info.sample_rate, metadata->data.stream_info.channels);
         }
     }
 
@@ -435,7 +440,8 @@ namespace cursedearth
                 break;
 
             case CE_WAVE_FORMAT_IMA_ADPCM:
-                sound_probe->input_buffer_capacity = ce_wave_ima_adpcm_block_storage_size(&wave_header);
+                // the codes scratch follows the block
+                sound_probe->input_buffer_capacity = ce_wave_ima_adpcm_block_storage_size(&wave_header) + ce_wave_ima_adpcm_codes_storage_size(&wave_header);
                 sound_probe->output_buffer_capacity = ce_wave_ima_adpcm_samples_storage_size(&wave_header);
                 break;
             }
@@ -468,7 +474,7 @@ namespace cursedearth
         case CE_WAVE_FORMAT_PCM:
             sound_resource->output_buffer_size = ce_mem_file_read(sound_resource->mem_file,
                 sound_resource->output_buffer, 1, sound_resource->output_buffer_capacity);
-            return true;
+            return 0 != sound_resource->output_buffer_size;
 
         case CE_WAVE_FORMAT_IMA_ADPCM:
             if (ce_mem_file_eof(sound_resource->mem_file)) {
@@ -476,9 +482,10 @@ namespace cursedearth
             }
 
             sound_resource->output_buffer_size = sound_resource->output_buffer_capacity;
-            ce_mem_file_read(sound_resource->mem_file, sound_resource->input_buffer, 1, sound_resource->input_buffer_capacity);
+            ce_mem_file_read(sound_resource->mem_file, sound_resource->input_buffer, 1, ce_wave_ima_adpcm_block_storage_size(&wave->wave_header));
 
-            ce_wave_ima_adpcm_decode(sound_resource->output_buffer, sound_resource->input_buffer, &wave->wave_header);
+            ce_wave_ima_adpcm_decode(sound_resource->output_buffer, sound_resource->input_buffer,
+                sound_resource->input_buffer + ce_wave_ima_adpcm_block_storage_size(&wave->wave_header), &wave->wave_header);
             return true;
         }
 
@@ -497,16 +504,6 @@ namespace cursedearth
         CE_MAD_OUTPUT_BUFFER_CAPACITY = 8192,
     };
 
-    typedef struct {
-        mad_fixed_t error[3];
-        mad_fixed_t random;
-    } ce_mad_dither;
-
-    typedef struct {
-        mad_fixed_t peak_clipping;
-        mad_fixed_t peak_sample;
-    } ce_mad_stats;
-
     /**
      * @brief MAD: MPEG Audio Decoder (C) Underbit Technologies, Inc.
      *        madlld (C) Bertrand Petit - a simple sample demonstrating how the low-level libmad API can be used
@@ -515,8 +512,7 @@ namespace cursedearth
         struct mad_stream stream;
         struct mad_frame frame;
         struct mad_synth synth;
-        ce_mad_dither dither[2]; // for 2 channels
-        ce_mad_stats stats;
+        sound_dither_t dither;
     } ce_mad;
 
     bool ce_mad_test(ce_sound_probe* sound_probe)
@@ -598,81 +594,13 @@ namespace cursedearth
         return true;
     }
 
-    // 32-bit pseudo-random number generator
-    inline mad_fixed_t ce_mad_prng(mad_fixed_t state)
-    {
-        return (state * 0x0019660dL + 0x3c6ef35fL) & 0xffffffffL;
-    }
-
-    // generic linear sample quantize and dither routine
-    int16_t ce_mad_scale(mad_fixed_t sample, ce_mad_dither* dither, ce_mad_stats* stats)
-    {
-        // noise shape
-        sample += dither->error[0] - dither->error[1] + dither->error[2];
-
-        dither->error[2] = dither->error[1];
-        dither->error[1] = dither->error[0] / 2;
-
-        // bias
-        mad_fixed_t output = sample + (1L << (MAD_F_FRACBITS - 16));
-
-        const unsigned int scalebits = MAD_F_FRACBITS + 1 - 16;
-        const mad_fixed_t mask = (1L << scalebits) - 1;
-
-        // dither
-        const mad_fixed_t random = ce_mad_prng(dither->random);
-        output += (random & mask) - (dither->random & mask);
-
-        dither->random = random;
-
-        enum {
-            CLIP_MIN = -MAD_F_ONE,
-            CLIP_MAX =  MAD_F_ONE - 1
-        };
-
-        // clip
-        if (output >= stats->peak_sample) {
-            if (output > CLIP_MAX) {
-                if (output - CLIP_MAX > stats->peak_clipping) {
-                    stats->peak_clipping = output - CLIP_MAX;
-                }
-                output = CLIP_MAX;
-                if (sample > CLIP_MAX) {
-                    sample = CLIP_MAX;
-                }
-            }
-            stats->peak_sample = output;
-        } else if (output < -stats->peak_sample) {
-            if (output < CLIP_MIN) {
-                if (CLIP_MIN - output > stats->peak_clipping) {
-                    stats->peak_clipping = CLIP_MIN - output;
-                }
-                output = CLIP_MIN;
-                if (sample < CLIP_MIN) {
-                    sample = CLIP_MIN;
-                }
-            }
-            stats->peak_sample = -output;
-        }
-
-        // quantize
-        output &= ~mask;
-
-        // error feedback
-        dither->error[0] = sample - output;
-
-        // scale
-        return output >> scalebits;
-    }
-
     void ce_mad_init(ce_mad* mad)
     {
         mad_stream_init(&mad->stream);
         mad_frame_init(&mad->frame);
         mad_synth_init(&mad->synth);
 
-        memset(&mad->dither, 0, sizeof(mad->dither));
-        memset(&mad->stats, 0, sizeof(mad->stats));
+        mad->dither = sound_dither_t();
     }
 
     void ce_mad_clean(ce_mad* mad)
@@ -716,13 +644,8 @@ namespace cursedearth
         assert(sound_resource->output_buffer_size <= sound_resource->output_buffer_capacity);
 
         // convert to signed 16 bit host endian integers
-        int16_t* output_buffer = (int16_t*)sound_resource->output_buffer;
-
-        for (unsigned int i = 0; i < sample_count; ++i) {
-            for (unsigned int j = 0; j < channel_count; ++j) {
-                output_buffer[channel_count * i + j] = le2cpu(ce_mad_scale(mad->synth.pcm.samples[j][i], &mad->dither[j], &mad->stats));
-            }
-        }
+        const int32_t* planes[] = { mad->synth.pcm.samples[0], mad->synth.pcm.samples[1] };
+        interleave_fixed_to_s16(reinterpret_cast<int16_t*>(sound_resource->output_buffer), planes, channel_count, sample_count, MAD_F_FRACBITS, mad->dither);
 
         return true;
     }
@@ -0,0 +1,215 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soundsamples.hpp"
+#include "utility.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CE_SOUND_SAMPLES_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace cursedearth
+{
+    namespace
+    {
+        inline uint32_t next_noise_state(uint32_t state)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        // difference of two uniform 16-bit values: triangular noise in (-1, 1) LSB
+        inline int16_t dither(float value, uint32_t& state)
+        {
+            state = next_noise_state(state);
+            const float noise = (static_cast<int32_t>(state >> 16) - static_cast<int32_t>(state & 0xffff)) * (1.0f / 65536.0f);
+            return clamp(std::lrint(value * 32768.0f + noise), -32768l, 32767l);
+        }
+
+        inline int16_t saturate(int32_t value)
+        {
+            return clamp(value, -32768, 32767);
+        }
+
+#ifdef CE_SOUND_SAMPLES_SSE2
+        inline __m128i next_noise_state(__m128i state)
+        {
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+            state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+            return state;
+        }
+
+        inline __m128 dither(__m128 value, __m128i& state)
+        {
+            state = next_noise_state(state);
+            const __m128i noise = _mm_sub_epi32(_mm_srli_epi32(state, 16), _mm_and_si128(state, _mm_set1_epi32(0xffff)));
+            value = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(32768.0f)), _mm_mul_ps(_mm_cvtepi32_ps(noise), _mm_set1_ps(1.0f / 65536.0f)));
+            // cvtps2dq turns out of range values into INT_MIN, so clamp first
+            return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+        }
+
+        // 8 interleaved values to 8 samples
+        inline void store_dithered(int16_t* output, __m128 first, __m128 second, __m128i& state)
+        {
+            const __m128i low = _mm_cvtps_epi32(dither(first, state));
+            const __m128i high = _mm_cvtps_epi32(dither(second, state));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packs_epi32(low, high));
+        }
+#endif
+
+        struct float_source_t
+        {
+            typedef float sample_t;
+
+            float load(const float* input) const { return *input; }
+#ifdef CE_SOUND_SAMPLES_SSE2
+            __m128 load4(const float* input) const { return _mm_loadu_ps(input); }
+#endif
+        };
+
+        struct fixed_source_t
+        {
+            typedef int32_t sample_t;
+
+            explicit fixed_source_t(unsigned int fraction_bits): scale(1.0f / (1u << fraction_bits)) {}
+
+            float load(const int32_t* input) const { return *input * scale; }
+#ifdef CE_SOUND_SAMPLES_SSE2
+            __m128 load4(const int32_t* input) const
+            {
+                return _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input))), _mm_set1_ps(scale));
+            }
+#endif
+
+            const float scale;
+        };
+
+        template <typename source_t>
+        void interleave_dithered(int16_t* output, const typename source_t::sample_t* const* planes,
+                                 size_t channel_count, size_t frame_count, sound_dither_t& dither_state, const source_t& source)
+        {
+            size_t i = 0;
+#ifdef CE_SOUND_SAMPLES_SSE2
+            __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither_state.state));
+            if (1 == channel_count) {
+                for (; i + 8 <= frame_count; i += 8) {
+                    store_dithered(output + i, source.load4(planes[0] + i), source.load4(planes[0] + i + 4), state);
+                }
+            } else if (2 == channel_count) {
+                for (; i + 4 <= frame_count; i += 4) {
+                    const __m128 left = source.load4(planes[0] + i);
+                    const __m128 right = source.load4(planes[1] + i);
+                    store_dithered(output + 2 * i, _mm_unpacklo_ps(left, right), _mm_unpackhi_ps(left, right), state);
+                }
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dither_state.state), state);
+#endif
+            for (; i < frame_count; ++i) {
+                for (size_t j = 0; j < channel_count; ++j) {
+                    output[i * channel_count + j] = dither(source.load(planes[j] + i), dither_state.state[0]);
+                }
+            }
+        }
+    }
+
+    void interleave_float_to_s16(int16_t* output, const float* const* planes, size_t channel_count, size_t frame_count, sound_dither_t& dither_state)
+    {
+        interleave_dithered(output, planes, channel_count, frame_count, dither_state, float_source_t());
+    }
+
+    void interleave_fixed_to_s16(int16_t* output, const int32_t* const* planes, size_t channel_count, size_t frame_count, unsigned int fraction_bits, sound_dither_t& dither_state)
+    {
+        interleave_dithered(output, planes, channel_count, frame_count, dither_state, fixed_source_t(fraction_bits));
+    }
+
+    void interleave_integer_to_s16(int16_t* output, const int32_t* const* planes, size_t channel_count, size_t frame_count, unsigned int bits_per_sample)
+    {
+        const int right_shift = std::max(static_cast<int>(bits_per_sample) - 16, 0);
+        const int left_shift = std::max(16 - static_cast<int>(bits_per_sample), 0);
+
+        size_t i = 0;
+#ifdef CE_SOUND_SAMPLES_SSE2
+        const __m128i right_count = _mm_cvtsi32_si128(right_shift);
+        const __m128i left_count = _mm_cvtsi32_si128(left_shift);
+        auto load = [&](const int32_t* input) {
+            return _mm_sll_epi32(_mm_sra_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input)), right_count), left_count);
+        };
+        if (1 == channel_count) {
+            for (; i + 8 <= frame_count; i += 8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(load(planes[0] + i), load(planes[0] + i + 4)));
+            }
+        } else if (2 == channel_count) {
+            for (; i + 4 <= frame_count; i += 4) {
+                const __m128i left = load(planes[0] + i);
+                const __m128i right = load(planes[1] + i);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 2 * i),
+                    _mm_packs_epi32(_mm_unpacklo_epi32(left, right), _mm_unpackhi_epi32(left, right)));
+            }
+        }
+#endif
+        for (; i < frame_count; ++i) {
+            for (size_t j = 0; j < channel_count; ++j) {
+                output[i * channel_count + j] = saturate(static_cast<int32_t>(static_cast<uint32_t>(planes[j][i] >> right_shift) << left_shift));
+            }
+        }
+    }
+
+    void expand_nibbles(uint8_t* const* codes, const uint8_t* data, size_t channel_count, size_t group_count)
+    {
+        size_t i = 0;
+#ifdef CE_SOUND_SAMPLES_SSE2
+        const __m128i mask = _mm_set1_epi8(0xf);
+        if (1 == channel_count) {
+            for (; i + 4 <= group_count; i += 4) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 4 * i));
+                const __m128i low = _mm_and_si128(bytes, mask);
+                const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(codes[0] + 8 * i), _mm_unpacklo_epi8(low, high));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(codes[0] + 8 * i + 16), _mm_unpackhi_epi8(low, high));
+            }
+        } else if (2 == channel_count) {
+            for (; i + 2 <= group_count; i += 2) {
+                // L0 R0 L1 R1 -> L0 L1 R0 R1
+                const __m128i bytes = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 8 * i)), _MM_SHUFFLE(3, 1, 2, 0));
+                const __m128i low = _mm_and_si128(bytes, mask);
+                const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(codes[0] + 8 * i), _mm_unpacklo_epi8(low, high));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(codes[1] + 8 * i), _mm_unpackhi_epi8(low, high));
+            }
+        }
+#endif
+        for (; i < group_count; ++i) {
+            for (size_t j = 0; j < channel_count; ++j) {
+                const uint8_t* group = data + 4 * (i * channel_count + j);
+                for (size_t k = 0; k < 4; ++k) {
+                    codes[j][8 * i + 2 * k + 0] = group[k] & 0xf;
+                    codes[j][8 * i + 2 * k + 1] = group[k] >> 4;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soundscheduler.hpp"
+#include "soundinstance.hpp"
+#include "threadlock.hpp"
+
+#include <limits>
+#include <chrono>
+
+namespace cursedearth
+{
+    sound_scheduler_t::sound_scheduler_t():
+        singleton_t<sound_scheduler_t>(this),
+        m_idle(make_condition_variable()),
+        m_threads(std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(sound_options_t::decode_thread_count), std::thread::hardware_concurrency())))
+    {
+        for (auto& thread: m_threads) {
+            thread = make_thread("sound scheduler", [this]{execute();});
+        }
+        ce_logging_info("sound scheduler: using %zu decode threads", m_threads.size());
+    }
+
+    sound_scheduler_t::~sound_scheduler_t()
+    {
+        if (!m_entries.empty()) {
+            ce_logging_warning("sound scheduler: some instances have not been removed");
+        }
+    }
+
+    void sound_scheduler_t::add(sound_instance_t* instance)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+        m_entries.push_back({ instance, false, true });
+        m_idle->notify_one();
+    }
+
+    void sound_scheduler_t::remove(sound_instance_t* instance)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (instance == it->instance) {
+                // a worker may be decoding right now
+                m_released.wait(lock, [it]{ return !it->busy; });
+                m_entries.erase(it);
+                return;
+            }
+        }
+    }
+
+    void sound_scheduler_t::notify(sound_instance_t* instance)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+        for (auto& entry: m_entries) {
+            if (instance == entry.instance) {
+                entry.dirty = true;
+                m_idle->notify_one();
+                return;
+            }
+        }
+    }
+
+    void sound_scheduler_t::post(std::function<void ()> task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+        m_tasks.push_back(std::move(task));
+        m_idle->notify_one();
+    }
+
+    sound_scheduler_t::entry_t* sound_scheduler_t::pick(bool& throttled)
+    {
+        entry_t* earliest_entry = nullptr;
+        float earliest_deadline = std::numeric_limits<float>::max();
+
+        throttled = false;
+        for (auto& entry: m_entries) {
+            if (entry.busy) {
+                continue;
+            }
+
+            // state changes are cheap and must not wait behind decoding
+            if (entry.dirty) {
+                return &entry;
+            }
+
+            if (SOUND_INSTANCE_STATE_PLAYING == entry.instance->state()) {
+                if (entry.instance->m_buffer->full()) {
+                    throttled = true;
+                } else {
+                    const float deadline = entry.instance->deadline();
+                    if (deadline < earliest_deadline) {
+                        earliest_deadline = deadline;
+                        earliest_entry = &entry;
+                    }
+                }
+            }
+        }
+
+        return earliest_entry;
+    }
+
+    void sound_scheduler_t::execute()
+    {
+        // the mixer consumes one block per this period, no need to poll full buffers more often
+        const auto poll_period = std::chrono::microseconds(1000000 * sound_options_t::samples_in_block / sound_capabilities_t::samples_per_second / 4);
+        while (true) {
+            thread_lock_t lock(m_mutex, m_idle);
+            bool throttled;
+            if (entry_t* entry = pick(throttled)) {
+                entry->busy = true;
+                entry->dirty = false;
+                lock.unlock();
+                entry->instance->process();
+                lock.lock();
+                entry->busy = false;
+                m_released.notify_all();
+            } else if (!m_tasks.empty()) {
+                // background work never delays a refill
+                std::function<void ()> task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            } else if (throttled) {
+                lock.unlock();
+                std::this_thread::sleep_for(poll_period);
+            } else {
+                m_idle->wait(lock);
+            }
+            interruption_point();
+        }
+    }
+}
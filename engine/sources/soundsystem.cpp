@@ -23,30 +23,88 @@
 
 namespace cursedearth
 {
+    namespace
+    {
+        sound_device_ptr_t make_device(const sound_format_t& format)
+        {
+            if (option_manager_t::instance()->disable_sound()) {
+                return make_null_sound_device(format);
+            }
+            const std::string& output = option_manager_t::instance()->sound_output();
+            if ("null" == output) {
+                return make_null_sound_device(format, false);
+            }
+            if ("realtime-null" == output) {
+                return make_null_sound_device(format, true);
+            }
+            if (!output.empty()) {
+                return make_wave_sound_device(format, output);
+            }
+            return make_sound_device(format, sound_latency_t(1000 * option_manager_t::instance()->sound_buffer_time(),
+                                                             1000 * option_manager_t::instance()->sound_period_time()));
+        }
+    }
+
     sound_system_t::sound_system_t():
         singleton_t<sound_system_t>(this),
         m_format(make_default_format()),
-        m_buffer(std::make_shared<sound_buffer_t>(m_format)),
-        m_device(option_manager_t::instance()->disable_sound() ? make_null_sound_device(m_format) : make_sound_device(m_format)),
+        m_low_latency(option_manager_t::instance()->low_latency_sound()),
+        // every queued block adds its length to the latency on top of the device buffer
+        m_buffer(std::make_shared<sound_buffer_t>(m_format, m_low_latency ? sound_options_t::low_latency_block_count : sound_options_t::block_count)),
+        m_device(make_device(m_format)),
+        m_mixed_block_count(0),
+        m_written_block_count(0),
+        m_starved_buffer_count(0),
+        m_mix_time(0),
         m_thread("sound system", [this]{execute();})
     {
     }
 
-    sound_block_ptr_t sound_system_t::map()
+    sound_system_t::~sound_system_t()
+    {
+        const sound_statistics_t stats = statistics();
+        ce_logging_info("sound system: %zu blocks mixed (%.3f ms per block, %zu starved buffers), %zu blocks written, %zu underruns, %zu suspends",
+            stats.mixed_block_count, 1000.0 * stats.mix_time, stats.starved_buffer_count, stats.written_block_count, stats.underrun_count, stats.suspend_count);
+    }
+
+    sound_block_t* sound_system_t::map()
     {
         return m_buffer->acquire();
     }
 
-    void sound_system_t::unmap(const sound_block_ptr_t& block)
+    void sound_system_t::unmap(sound_block_t* block)
     {
         m_buffer->push(block);
     }
 
+    void sound_system_t::account_mix(std::chrono::steady_clock::duration duration, size_t starved_buffer_count)
+    {
+        m_mix_time += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        m_starved_buffer_count += starved_buffer_count;
+        ++m_mixed_block_count;
+    }
+
+    sound_statistics_t sound_system_t::statistics() const
+    {
+        sound_statistics_t stats;
+        stats.mixed_block_count = m_mixed_block_count;
+        stats.written_block_count = m_written_block_count;
+        stats.starved_buffer_count = m_starved_buffer_count;
+        stats.underrun_count = m_device->underrun_count();
+        stats.suspend_count = m_device->suspend_count();
+        stats.mix_time = 0 == stats.mixed_block_count ? 0.0 : 1e-9 * m_mix_time / stats.mixed_block_count;
+        return stats;
+    }
+
     void sound_system_t::execute()
     {
+        if (m_low_latency && !promote_thread_priority()) {
+            ce_logging_warning("sound system: could not raise the output thread priority");
+        }
         while (true) {
-            sound_block_ptr_t block = m_buffer->pop();
-            m_device->write(block);
+            sound_block_t* block = m_buffer->pop();
+            m_device->write(*block);
+            ++m_written_block_count;
             m_buffer->release(block);
         }
     }
@@ -0,0 +1,82 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "soundvoice.hpp"
+#include "soundmixer.hpp"
+#include "soundsystem.hpp"
+
+namespace cursedearth
+{
+    sound_voice_t::sound_voice_t(const sound_sample_ptr_t& sample):
+        m_sample(sample),
+        m_emitter(make_sound_emitter()),
+        m_seconds_per_frame(1.0f / sound_system_t::instance()->format().samples_per_second),
+        m_state(SOUND_INSTANCE_STATE_STOPPED),
+        m_position(0)
+    {
+    }
+
+    void sound_voice_t::change_state(sound_instance_state_t state)
+    {
+        m_state = state;
+        if (SOUND_INSTANCE_STATE_STOPPED == state) {
+            m_position = 0;
+        } else if (SOUND_INSTANCE_STATE_PLAYING == state) {
+            sound_mixer_t::instance()->add_voice(shared_from_this());
+        }
+    }
+
+    bool sound_voice_t::mix(float* output, size_t frame_count, size_t channel_count, const float* gains)
+    {
+        const size_t position = m_position;
+        const size_t count = std::min(frame_count, m_sample->frame_count() - position);
+        const float* input = m_sample->data() + position * channel_count;
+        for (size_t i = 0; i < count; ++i, output += channel_count, input += channel_count) {
+            for (size_t j = 0; j < channel_count; ++j) {
+                output[j] += input[j] * gains[j];
+            }
+        }
+        return advance_position(position, count);
+    }
+
+    bool sound_voice_t::skip(size_t frame_count)
+    {
+        const size_t position = m_position;
+        return advance_position(position, std::min(frame_count, m_sample->frame_count() - position));
+    }
+
+    bool sound_voice_t::advance_position(size_t position, size_t count)
+    {
+        // a concurrent stop rewinds the voice, don't overwrite that
+        if (!m_position.compare_exchange_strong(position, position + count)) {
+            return true;
+        }
+
+        if (position + count == m_sample->frame_count()) {
+            sound_instance_state_t state = SOUND_INSTANCE_STATE_PLAYING;
+            if (m_state.compare_exchange_strong(state, SOUND_INSTANCE_STATE_STOPPED)) {
+                m_position = 0;
+            }
+            return false;
+        }
+
+        return true;
+    }
+}
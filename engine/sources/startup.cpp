@@ -0,0 +1,125 @@
+/*
+ *  This file is part of Cursed Earth.
+ *
+ *  Cursed Earth is an open source, cross-platform port of Evil Islands.
+ *  Copyright (C) 2009-2017 Yanis Kurganov <ykurganov@users.sourceforge.net>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <tuple>
+#include <algorithm>
+
+#include "logging.hpp"
+#include "thread.hpp"
+#include "startup.hpp"
+
+namespace cursedearth
+{
+    void startup_graph_t::add(const std::string& name, const std::vector<std::string>& dependencies, affinity_t affinity, const task_t& task)
+    {
+        phase_t phase = { name, {}, affinity, task, state_t::pending, {}, {} };
+        for (const auto& dependency: dependencies) {
+            auto it = std::find_if(m_phases.begin(), m_phases.end(), [&dependency](const phase_t& other) { return dependency == other.name; });
+            assert(m_phases.end() != it && "dependency must be added before");
+            phase.dependencies.push_back(it - m_phases.begin());
+        }
+        m_phases.push_back(phase);
+    }
+
+    bool startup_graph_t::ready(const phase_t& phase) const
+    {
+        return state_t::pending == phase.state && std::all_of(phase.dependencies.begin(), phase.dependencies.end(),
+            [this](size_t index) { return state_t::done == m_phases[index].state; });
+    }
+
+    void startup_graph_t::execute(phase_t& phase)
+    {
+        std::exception_ptr error;
+        const steady_clock_t::time_point start = steady_clock_t::now();
+        try {
+            phase.task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::ignore = lock;
+        phase.start = start;
+        phase.finish = steady_clock_t::now();
+        phase.state = state_t::done;
+        if (error && !m_error) {
+            m_error = error;
+        }
+        m_done.notify_all();
+    }
+
+    void startup_graph_t::run()
+    {
+        const steady_clock_t::time_point start = steady_clock_t::now();
+        std::vector<thread_ptr_t> threads;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;) {
+            phase_t* main_phase = nullptr;
+            size_t running_count = 0, pending_count = 0;
+
+            for (auto& phase: m_phases) {
+                if (!m_error && ready(phase)) {
+                    if (affinity_t::any_thread == phase.affinity) {
+                        phase.state = state_t::running;
+                        threads.push_back(make_thread("startup", [this, &phase] { execute(phase); }));
+                    } else if (nullptr == main_phase) {
+                        phase.state = state_t::running;
+                        main_phase = &phase;
+                    }
+                }
+                running_count += state_t::running == phase.state;
+                pending_count += state_t::pending == phase.state;
+            }
+
+            if (nullptr != main_phase) {
+                lock.unlock();
+                execute(*main_phase);
+                lock.lock();
+            } else if (0 != running_count) {
+                m_done.wait(lock);
+            } else {
+                assert((m_error || 0 == pending_count) && "unreachable startup phase");
+                break;
+            }
+        }
+
+        lock.unlock();
+        threads.clear();
+
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+
+        trace(start);
+    }
+
+    void startup_graph_t::trace(steady_clock_t::time_point start) const
+    {
+        typedef std::chrono::duration<double, std::milli> milliseconds_t;
+        for (const auto& phase: m_phases) {
+            ce_logging_info("startup: %-16s %8.1f ms, started at %8.1f ms on the %s thread", phase.name.c_str(),
+                milliseconds_t(phase.finish - phase.start).count(), milliseconds_t(phase.start - start).count(),
+                affinity_t::main_thread == phase.affinity ? "main" : "worker");
+        }
+        ce_logging_info("startup: done in %.1f ms", milliseconds_t(steady_clock_t::now() - start).count());
+    }
+}
@@ -177,13 +177,27 @@ namespace cursedearth
         terrain->scenenode->position = *position;
         terrain->scenenode->orientation = *orientation;
 
+        // every sector is needed for geometry, decode them all at once
+        ce_mprfile_decode_sectors(mprfile);
+
+        if (option_manager_t::instance()->terrain_tiling()) {
+            // tile textures are acquired by the first sector ready, have them decoded by then
+            std::vector<std::string> tile_names = { "default0" };
+            std::vector<char> tile_name(mprfile->name->length + 3 + 1);
+            for (int i = 0; i < mprfile->texture_count; ++i) {
+                snprintf(tile_name.data(), tile_name.size(), "%s%03d", mprfile->name->str, i);
+                tile_names.push_back(tile_name.data());
+            }
+            ce_texture_manager_preload(tile_names);
+        }
+
         std::vector<char> name(terrain->mprfile->name->length + 3 + 3 + 1 + 1);
 
         for (int i = 0; i < CE_MPRFILE_MATERIAL_COUNT; ++i) {
             bool water = CE_MPRFILE_MATERIAL_WATER == i;
             for (int z = 0; z < terrain->mprfile->sector_z_count; ++z) {
                 for (int x = 0; x < terrain->mprfile->sector_x_count; ++x) {
-                    ce_mprsector* mpr_sector = terrain->mprfile->sectors + z * terrain->mprfile->sector_x_count + x;
+                    ce_mprsector* mpr_sector = ce_mprfile_sector(terrain->mprfile, x, z);
                     if (water && NULL == mpr_sector->water_allow) {
                         // do not add empty geometry
                         continue;
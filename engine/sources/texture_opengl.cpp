@@ -38,6 +38,23 @@ namespace cursedearth
         GLuint id;
     } ce_texture_opengl;
 
+    // GLEW context is thread-local and only initialized on the render thread
+    struct {
+        bool dxt1;
+        bool dxt3;
+    } ce_texture_capabilities;
+
+    void ce_texture_query_capabilities(void)
+    {
+        ce_texture_capabilities.dxt3 = GLEW_VERSION_1_3 && GLEW_EXT_texture_compression_s3tc;
+        ce_texture_capabilities.dxt1 = ce_texture_capabilities.dxt3 || (GLEW_VERSION_1_3 && GLEW_EXT_texture_compression_dxt1);
+    }
+
+    bool ce_texture_is_compression_supported(ce_mmpfile_format format)
+    {
+        return CE_MMPFILE_FORMAT_DXT1 == format ? ce_texture_capabilities.dxt1 : ce_texture_capabilities.dxt3;
+    }
+
     unsigned int ce_texture_correct_mipmap_count(unsigned int mipmap_count)
     {
         // OpenGL Specification:
@@ -152,7 +169,7 @@ namespace cursedearth
 
     void ce_texture_generate_dxt(ce_mmpfile* mmpfile)
     {
-        if (GLEW_VERSION_1_3 && (GLEW_EXT_texture_compression_s3tc || (CE_MMPFILE_FORMAT_DXT1 == mmpfile->format && GLEW_EXT_texture_compression_dxt1))) {
+        if (ce_texture_is_compression_supported(mmpfile->format)) {
             ce_texture_generate_compressed(mmpfile, (CE_MMPFILE_FORMAT_DXT3 == mmpfile->format ? GL_COMPRESSED_RGBA_S3TC_DXT3_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT));
         } else {
             ce_mmpfile_convert(mmpfile, CE_MMPFILE_FORMAT_R8G8B8A8);
@@ -244,6 +261,8 @@ namespace cursedearth
 
         texture->ref_count = 1;
         texture->name =  ce_string_new_str(NULL != name ? name : "");
+        texture->width = 0;
+        texture->height = 0;
 
         glGenTextures(1, &opengl_texture->id);
 
@@ -288,6 +307,40 @@ namespace cursedearth
         ce_texture_unbind(texture);
     }
 
+    void ce_texture_prepare(ce_mmpfile* mmpfile)
+    {
+        // mirrors the generate procs above, only conversions that do not depend on
+        // legacy packed pixel formats are done here, the rest is left for uploading
+        if (CE_MMPFILE_FORMAT_PNT3 == mmpfile->format) {
+            ce_mmpfile_convert(mmpfile, CE_MMPFILE_FORMAT_ARGB8);
+        } else if (CE_MMPFILE_FORMAT_DXT1 == mmpfile->format || CE_MMPFILE_FORMAT_DXT3 == mmpfile->format) {
+            if (!ce_texture_is_compression_supported(mmpfile->format)) {
+                ce_mmpfile_convert(mmpfile, CE_MMPFILE_FORMAT_R8G8B8A8);
+            }
+        }
+    }
+
+    void ce_texture_replace_plane(ce_texture* texture, unsigned int width, unsigned int height, const void* data)
+    {
+        ce_texture_bind(texture);
+
+        glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        if (width != texture->width || height != texture->height) {
+            texture->width = width;
+            texture->height = height;
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+            ce_texture_setup_filters(1);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+        }
+
+        glPopClientAttrib();
+
+        ce_texture_unbind(texture);
+    }
+
     void ce_texture_wrap(ce_texture* texture, ce_texture_wrap_mode mode)
     {
         ce_texture_bind(texture);
@@ -319,4 +372,18 @@ namespace cursedearth
     {
         glDisable(GL_TEXTURE_2D);
     }
+
+    void ce_texture_bind_unit(ce_texture* texture, unsigned int unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        ce_texture_bind(texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void ce_texture_unbind_unit(ce_texture* texture, unsigned int unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        ce_texture_unbind(texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
 }
@@ -19,12 +19,19 @@
  */
 
 #include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/filesystem.hpp>
 
 #include "alloc.hpp"
 #include "logging.hpp"
+#include "event.hpp"
 #include "resfile.hpp"
+#include "resourcemanager.hpp"
+#include "threadpool.hpp"
+#include "rendersystem.hpp"
 #include "optionmanager.hpp"
 #include "texturemanager.hpp"
 
@@ -34,6 +41,12 @@ namespace cursedearth
 
     struct ce_texture_manager* ce_texture_manager;
 
+    struct ce_texture_preloader {
+        std::mutex mutex;
+        std::unordered_set<std::string> requested; // every name ever preloaded
+        std::unordered_map<std::string, std::shared_ptr<ce_mmpfile>> ready; // prepared, waiting for the render thread
+    };
+
     const std::vector<std::string> ce_texture_exts = { ".mmp" };
     const std::vector<std::string> ce_texture_cache_dirs = { "Textures" };
     const std::vector<std::string> ce_texture_resource_dirs = { "Res" };
@@ -74,7 +87,9 @@ namespace cursedearth
     {
         ce_texture_manager = (struct ce_texture_manager*)ce_alloc_zero(sizeof(struct ce_texture_manager));
         ce_texture_manager->res_files = ce_vector_new();
+        ce_texture_manager->res_indices = ce_vector_new();
         ce_texture_manager->textures = ce_vector_new();
+        ce_texture_manager->preloader = new ce_texture_preloader;
 
         for (const auto& dir: ce_texture_cache_dirs) {
             fs::path path = option_manager_t::instance()->ei_path() / dir;
@@ -92,6 +107,9 @@ namespace cursedearth
             if (!path.empty() && NULL != (res_file = ce_res_file_new_path(path))) {
                 ce_vector_push_back(ce_texture_manager->res_files, res_file);
                 ce_logging_info("texture manager: loading `%s'... ok", path.string().c_str());
+                if (option_manager_t::instance()->archive_indexing()) {
+                    ce_vector_push_back(ce_texture_manager->res_indices, ce_resource_manager_open_index(path, res_file));
+                }
             } else {
                 ce_logging_error("texture manager: loading `%s'... failed", path.string().c_str());
             }
@@ -101,8 +119,11 @@ namespace cursedearth
     void ce_texture_manager_term()
     {
         if (NULL != ce_texture_manager) {
+            delete ce_texture_manager->preloader;
             ce_vector_for_each(ce_texture_manager->textures, (void(*)(void*))ce_texture_del);
             ce_vector_del(ce_texture_manager->textures);
+            ce_vector_for_each(ce_texture_manager->res_indices, (void(*)(void*))ce_res_index_del);
+            ce_vector_del(ce_texture_manager->res_indices);
             ce_vector_for_each(ce_texture_manager->res_files, (void(*)(void*))ce_res_file_del);
             ce_vector_del(ce_texture_manager->res_files);
             ce_free(ce_texture_manager, sizeof(struct ce_texture_manager));
@@ -124,23 +145,25 @@ namespace cursedearth
         return NULL;
     }
 
-    ce_mmpfile* ce_texture_manager_open_mmpfile_from_resources(const std::string& name)
+    ce_res_file* ce_texture_manager_find_res_file(const std::string& file_name, size_t* index)
     {
-        std::string file_name = name + ce_texture_exts[0];
-
-        // find in resources
         for (size_t i = 0; i < ce_texture_manager->res_files->count; ++i) {
             ce_res_file* res_file = (ce_res_file*)ce_texture_manager->res_files->items[i];
-            size_t index = ce_res_file_node_index(res_file, file_name.c_str());
-            if (res_file->node_count != index) {
-                ce_mmpfile* mmpfile = ce_mmpfile_new_res_file(res_file, index);
-                return mmpfile;
+            *index = ce_res_file_node_index(res_file, file_name.c_str());
+            if (res_file->node_count != *index) {
+                return res_file;
             }
         }
-
         return NULL;
     }
 
+    ce_mmpfile* ce_texture_manager_open_mmpfile_from_resources(const std::string& name)
+    {
+        size_t index;
+        ce_res_file* res_file = ce_texture_manager_find_res_file(name + ce_texture_exts[0], &index);
+        return NULL != res_file ? ce_mmpfile_new_res_file(res_file, index) : NULL;
+    }
+
     ce_mmpfile* ce_texture_manager_open_mmpfile(const std::string& name)
     {
         ce_mmpfile* mmpfile = ce_texture_manager_open_mmpfile_from_cache(name.c_str());
@@ -157,23 +180,49 @@ namespace cursedearth
         ce_mmpfile_save(mmpfile, path);
     }
 
-    ce_texture* ce_texture_manager_get(const std::string& name)
+    ce_texture* ce_texture_manager_find(const std::string& base_name)
     {
-        std::string base_name = name.substr(0, name.find_last_of("."));
-
-        // find texture in cache
         for (size_t i = 0; i < ce_texture_manager->textures->count; ++i) {
             ce_texture* texture = (ce_texture*)ce_texture_manager->textures->items[i];
             if (base_name == texture->name->str) {
                 return texture;
             }
         }
+        return NULL;
+    }
+
+    std::shared_ptr<ce_mmpfile> ce_texture_manager_take_ready(const std::string& base_name)
+    {
+        ce_texture_preloader* preloader = ce_texture_manager->preloader;
+        std::lock_guard<std::mutex> lock(preloader->mutex);
+        std::ignore = lock;
+        auto it = preloader->ready.find(base_name);
+        if (preloader->ready.end() == it) {
+            return nullptr;
+        }
+        std::shared_ptr<ce_mmpfile> mmpfile = it->second;
+        preloader->ready.erase(it);
+        return mmpfile;
+    }
 
-        // load texture from resources
-        ce_mmpfile* mmpfile = ce_texture_manager_open_mmpfile(name.c_str());
-        if (NULL != mmpfile) {
-            ce_texture* texture = ce_texture_new(base_name.c_str(), mmpfile);
-            ce_mmpfile_del(mmpfile);
+    ce_texture* ce_texture_manager_get(const std::string& name)
+    {
+        std::string base_name = name.substr(0, name.find_last_of("."));
+
+        // find texture in cache
+        ce_texture* texture = ce_texture_manager_find(base_name);
+        if (NULL != texture) {
+            return texture;
+        }
+
+        // take preloaded mmp file or load it from resources
+        std::shared_ptr<ce_mmpfile> mmpfile = ce_texture_manager_take_ready(base_name);
+        if (!mmpfile) {
+            mmpfile.reset(ce_texture_manager_open_mmpfile(name.c_str()), ce_mmpfile_del);
+        }
+
+        if (mmpfile) {
+            texture = ce_texture_new(base_name.c_str(), mmpfile.get());
             ce_texture_manager_put(texture);
             return texture;
         }
@@ -185,4 +234,84 @@ namespace cursedearth
     {
         ce_vector_push_back(ce_texture_manager->textures, texture);
     }
+
+    void ce_texture_manager_upload_ready(ce_event*)
+    {
+        std::unordered_map<std::string, std::shared_ptr<ce_mmpfile>> ready;
+        {
+            std::lock_guard<std::mutex> lock(ce_texture_manager->preloader->mutex);
+            std::ignore = lock;
+            ready.swap(ce_texture_manager->preloader->ready);
+        }
+
+        for (const auto& pair: ready) {
+            // texture may be already acquired by someone who did not wait
+            if (NULL == ce_texture_manager_find(pair.first)) {
+                ce_texture_manager_put(ce_texture_new(pair.first.c_str(), pair.second.get()));
+            }
+        }
+    }
+
+    std::shared_ptr<ce_mmpfile> ce_texture_manager_hand_over(const std::string& name, ce_mmpfile* mmpfile)
+    {
+        ce_texture_prepare(mmpfile);
+
+        std::shared_ptr<ce_mmpfile> ptr(mmpfile, ce_mmpfile_del);
+        {
+            std::lock_guard<std::mutex> lock(ce_texture_manager->preloader->mutex);
+            std::ignore = lock;
+            ce_texture_manager->preloader->ready[name] = ptr;
+        }
+
+        ce_event_manager_post_ptr(ce_render_system_thread_id(), ce_texture_manager_upload_ready, NULL);
+        return ptr;
+    }
+
+    void ce_texture_manager_preload_exec(const std::string& name)
+    {
+        ce_mmpfile* mmpfile = ce_texture_manager_open_mmpfile_from_cache(name);
+        if (NULL != mmpfile) {
+            ce_texture_manager_hand_over(name, mmpfile);
+        }
+    }
+
+    std::shared_ptr<ce_mmpfile> ce_texture_manager_preload_decode(const std::string& name, const resource_data_ptr_t& data)
+    {
+        // mmp file takes ownership of its data; a node read alone by the preloader is handed over,
+        // a node read together with its neighbours is copied out of the shared span
+        return ce_texture_manager_hand_over(name, ce_mmpfile_new_data(data->release(), data->size));
+    }
+
+    void ce_texture_manager_preload(const std::vector<std::string>& names)
+    {
+        std::vector<std::string> base_names;
+        {
+            std::lock_guard<std::mutex> lock(ce_texture_manager->preloader->mutex);
+            std::ignore = lock;
+            for (const auto& name: names) {
+                std::string base_name = name.substr(0, name.find_last_of("."));
+                if (!base_name.empty() && ce_texture_manager->preloader->requested.insert(base_name).second) {
+                    base_names.push_back(base_name);
+                }
+            }
+        }
+
+        for (const auto& base_name: base_names) {
+            size_t index;
+            ce_res_file* res_file;
+            if (!find_cache_resource(base_name).empty()) {
+                thread_pool_t::instance()->enqueue(std::bind(ce_texture_manager_preload_exec, base_name));
+            } else if (NULL != (res_file = ce_texture_manager_find_res_file(base_name + ce_texture_exts[0], &index))) {
+                // archive reads go through the loader to be ordered by offset
+                resource_loader_t::instance()->load<ce_mmpfile>(res_file, ce_res_file_node_name(res_file, index),
+                    std::bind(ce_texture_manager_preload_decode, base_name, std::placeholders::_1));
+            } else {
+                ce_logging_warning("texture manager: could not preload `%s'", base_name.c_str());
+            }
+        }
+
+        if (!base_names.empty()) {
+            ce_logging_debug("texture manager: preloading %zu textures", base_names.size());
+        }
+    }
 }
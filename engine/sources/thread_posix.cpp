@@ -36,6 +36,14 @@ namespace cursedearth
         return pthread_self();
     }
 
+    bool promote_thread_priority()
+    {
+        // real-time round robin just above the lowest level, usually requires CAP_SYS_NICE or rtprio limits
+        sched_param param;
+        param.sched_priority = sched_get_priority_min(SCHED_RR) + 1;
+        return 0 == pthread_setschedparam(pthread_self(), SCHED_RR, &param);
+    }
+
     struct routine_t
     {
         void (*proc)(void*);
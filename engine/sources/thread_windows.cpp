@@ -35,6 +35,11 @@ namespace cursedearth
         return static_cast<ce_thread_id>(GetCurrentThreadId());
     }
 
+    bool promote_thread_priority()
+    {
+        return FALSE != SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    }
+
     struct routine_t
     {
         void (*proc)(void*);
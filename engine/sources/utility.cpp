@@ -39,10 +39,23 @@ namespace cursedearth
     const float g_deg2rad = 0.01745329f;
     const float g_rad2deg = 57.2957795f;
 
+    const uint64_t g_fnv1a64_basis = 14695981039346656037ULL;
+
     // http://www.c-faq.com/fp/fpequal.html
     float relative_difference(float a, float b)
     {
         const float value = std::max(std::abs(a), std::abs(b));
         return 0.0f == value ? 0.0f : std::abs(a - b) / value;
     }
+
+    // http://www.isthe.com/chongo/tech/comp/fnv/
+    uint64_t fnv1a64(const void* data, size_t size, uint64_t basis)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            basis ^= bytes[i];
+            basis *= 1099511628211ULL;
+        }
+        return basis;
+    }
 }
@@ -18,7 +18,11 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits>
+
+#include "utility.hpp"
 #include "videoinstance.hpp"
+#include "optionmanager.hpp"
 #include "shadermanager.hpp"
 #include "rendersystem.hpp"
 
@@ -27,25 +31,41 @@ namespace cursedearth
     video_instance_t::video_instance_t(sound_object_t object, ce_video_resource* resource):
         m_object(object),
         m_resource(resource),
+        m_play_time(0.0f),
         m_texture(ce_texture_new("frame", NULL)),
+        m_planes{ce_texture_new("y plane", NULL), ce_texture_new("cb plane", NULL), ce_texture_new("cr plane", NULL)},
         m_material(ce_material_new()),
-        m_rgba_frame(ce_mmpfile_new(resource->width, resource->height, 1, CE_MMPFILE_FORMAT_R8G8B8A8, 0)),
-        m_buffer(make_video_buffer()),
+        m_rgba_frame(NULL),
+        m_buffer(make_video_buffer(option_manager_t::instance()->video_prefetch_frames())),
         m_thread("video instance", [this]{execute();})
     {
+        // the soundtrack drives the video clock, it must never be virtualized
+        set_sound_object_priority(m_object, std::numeric_limits<int>::max());
+
         const char* shaders[] = { "shaders/ycbcr2rgba.vert", "shaders/ycbcr2rgba.frag", NULL };
         m_material->mode = CE_MATERIAL_MODE_REPLACE;
         m_material->shader = ce_shader_manager_get(shaders);
         if (NULL != m_material->shader) {
             ce_shader_add_ref(m_material->shader);
+            for (ce_texture* plane: m_planes) {
+                ce_texture_wrap(plane, CE_TEXTURE_WRAP_CLAMP_TO_EDGE);
+            }
+        } else {
+            m_rgba_frame = ce_mmpfile_new(resource->width, resource->height, 1, CE_MMPFILE_FORMAT_R8G8B8A8, 0);
         }
     }
 
     video_instance_t::~video_instance_t()
     {
         m_thread.temp();
+        if (0 != m_dropped_frame_count) {
+            ce_logging_debug("video instance: %zu frames dropped to keep up with the sound", m_dropped_frame_count);
+        }
         ce_mmpfile_del(m_rgba_frame);
         ce_material_del(m_material);
+        for (ce_texture* plane: m_planes) {
+            ce_texture_del(plane);
+        }
         ce_texture_del(m_texture);
         ce_video_resource_del(m_resource);
         remove_sound_object(m_object);
@@ -62,7 +82,7 @@ namespace cursedearth
             float sound_time = get_sound_object_time(m_object);
             m_play_time = sound_time;
         } else {
-            m_play_time += elapsed;
+            m_play_time = m_play_time + elapsed;
         }
 
         do_advance();
@@ -77,7 +97,20 @@ namespace cursedearth
     void video_instance_t::render()
     {
         ce_render_system_apply_material(m_material);
-        if (ce_texture_is_valid(m_texture)) {
+        if (NULL != m_material->shader) {
+            // wrapping makes planes valid before the first upload, but their size is known only after it
+            if (ce_texture_is_valid(m_planes[0]) && 0 != m_planes[0]->width && 0 != m_planes[0]->height) {
+                const char* samplers[] = { "y_texture", "cb_texture", "cr_texture" };
+                for (unsigned int i = 0; i < 3; ++i) {
+                    ce_texture_bind_unit(m_planes[i], i);
+                    ce_shader_set_uniform_int(m_material->shader, samplers[i], i);
+                }
+                ce_render_system_draw_fullscreen_wire_rect(m_planes[0]->width, m_planes[0]->height);
+                for (unsigned int i = 0; i < 3; ++i) {
+                    ce_texture_unbind_unit(m_planes[i], i);
+                }
+            }
+        } else if (ce_texture_is_valid(m_texture)) {
             ce_texture_bind(m_texture);
             ce_render_system_draw_fullscreen_wire_rect(m_texture->width, m_texture->height);
             ce_texture_unbind(m_texture);
@@ -112,36 +145,17 @@ namespace cursedearth
     {
         bool acquired = false;
         const int desired_frame = m_resource->fps * m_play_time;
-        mmpfile_ptr_t ycbcr_frame;
+        video_frame_ptr_t frame;
 
         // if sound or time far away
-        while (m_frame < desired_frame && m_buffer->try_pop(ycbcr_frame)) {
+        while (m_frame < desired_frame && m_buffer->try_pop(frame)) {
+            m_frame = frame->index;
             // skip frames to reach desired frame
-            if (++m_frame == desired_frame || /* or use the closest frame */ 0 == m_buffer->read_available()) {
-                if (NULL != m_material->shader) {
-                    const uint8_t* y_data = static_cast<const uint8_t*>(ycbcr_frame->texels);
-                    const uint8_t* cb_data = y_data + ycbcr_frame->width * ycbcr_frame->height;
-                    const uint8_t* cr_data = cb_data + (ycbcr_frame->width / 2) * (ycbcr_frame->height / 2);
-
-                    uint8_t* texels = static_cast<uint8_t*>(m_rgba_frame->texels);
-
-                    for (unsigned int h = 0; h < ycbcr_frame->height; ++h) {
-                        for (unsigned int w = 0; w < ycbcr_frame->width; ++w) {
-                            size_t index = 4 * (h * ycbcr_frame->width + w);
-                            texels[index + 0] = y_data[h * ycbcr_frame->width + w];
-                            texels[index + 1] = cb_data[(h / 2) * (ycbcr_frame->width / 2) + w / 2];
-                            texels[index + 2] = cr_data[(h / 2) * (ycbcr_frame->width / 2) + w / 2];
-                            texels[index + 3] = 255;
-                        }
-                    }
-                } else {
-                    ce_mmpfile_convert2(ycbcr_frame.get(), m_rgba_frame);
-                }
-
-                ce_texture_replace(m_texture, m_rgba_frame);
+            if (m_frame >= desired_frame || /* or use the closest frame */ 0 == m_buffer->read_available()) {
+                upload(*frame);
                 acquired = true;
             }
-            m_buffer->release_to_cache(ycbcr_frame);
+            m_buffer->release_to_cache(frame);
         }
 
         // TODO: think again how to hold last frame
@@ -150,20 +164,65 @@ namespace cursedearth
         }
     }
 
+    void video_instance_t::upload(const video_frame_t& frame)
+    {
+        if (NULL != m_material->shader) {
+            // planes go to the GPU as they are, the shader does the conversion
+            for (size_t i = 0; i < 3; ++i) {
+                ce_texture_replace_plane(m_planes[i], frame.planes[i].width, frame.planes[i].height, frame.planes[i].data.get());
+            }
+            return;
+        }
+
+        const uint8_t* y_data = frame.planes[0].data.get();
+        const uint8_t* cb_data = frame.planes[1].data.get();
+        const uint8_t* cr_data = frame.planes[2].data.get();
+
+        uint8_t* texels = static_cast<uint8_t*>(m_rgba_frame->texels);
+
+        for (unsigned int h = 0; h < frame.height(); ++h) {
+            const uint8_t* y_row = y_data + h * frame.planes[0].width;
+            const uint8_t* cb_row = cb_data + (h / 2) * frame.planes[1].width;
+            const uint8_t* cr_row = cr_data + (h / 2) * frame.planes[2].width;
+            for (unsigned int w = 0; w < frame.width(); ++w, texels += 4) {
+                int y = 298 * (y_row[w] - 16);
+                int cb = cb_row[w / 2] - 128;
+                int cr = cr_row[w / 2] - 128;
+
+                texels[0] = clamp((y + 409 * cr + 128) / 256, 0, 255);
+                texels[1] = clamp((y - 100 * cb - 208 * cr + 128) / 256, 0, 255);
+                texels[2] = clamp((y + 516 * cb + 128) / 256, 0, 255);
+                texels[3] = std::numeric_limits<uint8_t>::max();
+            }
+        }
+
+        ce_texture_replace(m_texture, m_rgba_frame);
+    }
+
     void video_instance_t::execute()
     {
         while (true) {
+            // post-processing only while the queue has frames to spare
+            m_resource->hurry_up = m_buffer->read_available() < m_buffer->capacity() / 4;
             if (!ce_video_resource_read(m_resource)) {
                 m_state = state_t::stopping;
                 break;
             }
 
-            mmpfile_ptr_t ycbcr_frame = m_buffer->acquire_from_cache(m_resource->width, m_resource->height);
+            // the sound clock has already passed this frame: keep decoding (later frames depend on it), but don't copy it
+            const size_t index = m_resource->ycbcr_frame_index;
+            if (index + 1 < m_resource->fps * m_play_time) {
+                ++m_dropped_frame_count;
+                continue;
+            }
+
+            // the only copy between decoder and uploader: decoders reuse their own picture buffers
+            video_frame_ptr_t frame = m_buffer->acquire_from_cache(m_resource->width, m_resource->height);
             ycbcr_t* ycbcr = &m_resource->ycbcr;
 
-            uint8_t* y_data = static_cast<uint8_t*>(ycbcr_frame->texels);
-            uint8_t* cb_data = y_data + ycbcr_frame->width * ycbcr_frame->height;
-            uint8_t* cr_data = cb_data + (ycbcr_frame->width / 2) * (ycbcr_frame->height / 2);
+            uint8_t* y_data = frame->planes[0].data.get();
+            uint8_t* cb_data = frame->planes[1].data.get();
+            uint8_t* cr_data = frame->planes[2].data.get();
 
             int y_offset = (ycbcr->crop_rectangle.x & ~1) + ycbcr->planes[0].stride * (ycbcr->crop_rectangle.y & ~1);
             int cb_offset = (ycbcr->crop_rectangle.x / 2) + ycbcr->planes[1].stride * (ycbcr->crop_rectangle.y / 2);
@@ -178,7 +237,8 @@ namespace cursedearth
                 memcpy(cr_data + h * (ycbcr->crop_rectangle.width / 2), ycbcr->planes[2].data + cr_offset + h * ycbcr->planes[2].stride, ycbcr->crop_rectangle.width / 2);
             }
 
-            m_buffer->push(ycbcr_frame);
+            frame->index = index;
+            m_buffer->push(frame);
         }
     }
 }
@@ -73,6 +73,7 @@ namespace cursedearth
     {
         video_resource->time = 0.0f;
         video_resource->frame_index = 0;
+        video_resource->ycbcr_frame_index = 0;
         ce_mem_file_rewind(video_resource->mem_file);
         return (*video_resource->vtable.reset)(video_resource);
     }
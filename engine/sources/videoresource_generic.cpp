@@ -28,6 +28,8 @@
 #include <cstdio>
 #include <cstring>
 #include <cmath>
+#include <thread>
+#include <algorithm>
 
 #include <theora/theoradec.h>
 
@@ -39,6 +41,7 @@ extern "C"
 #include "alloc.hpp"
 #include "logging.hpp"
 #include "bink.hpp"
+#include "videooptions.hpp"
 #include "videoresource.hpp"
 
 namespace cursedearth
@@ -58,6 +61,8 @@ namespace cursedearth
         th_comment comment;
         th_dec_ctx* context;
         th_ycbcr_buffer ycbcr;
+        int max_pp_level;
+        bool hurry_up;
     };
 
     size_t ce_theora_size_hint(ce_mem_file*)
@@ -273,6 +278,11 @@ namespace cursedearth
         // initialize decoder
         theora->context = th_decode_alloc(&theora->info, theora->setup);
 
+        // post-processing is switched on only while the player has frames to spare
+        th_decode_ctl(theora->context, TH_DECCTL_GET_PPLEVEL_MAX, &theora->max_pp_level, sizeof(theora->max_pp_level));
+        theora->hurry_up = true;
+        video_resource->hurry_up = true;
+
         video_resource->width = theora->info.pic_width;
         video_resource->height = theora->info.pic_height;
         video_resource->fps = (float)theora->info.fps_numerator / theora->info.fps_denominator;
@@ -322,6 +332,12 @@ namespace cursedearth
             }
         }
 
+        if (theora->hurry_up != video_resource->hurry_up) {
+            theora->hurry_up = video_resource->hurry_up;
+            int pp_level = theora->hurry_up ? 0 : theora->max_pp_level;
+            th_decode_ctl(theora->context, TH_DECCTL_SET_PPLEVEL, &pp_level, sizeof(pp_level));
+        }
+
         // TODO: explore it
         if (theora->packet.granulepos >= 0) {
             th_decode_ctl(theora->context, TH_DECCTL_SET_GRANPOS, &theora->packet.granulepos, sizeof(theora->packet.granulepos));
@@ -330,7 +346,7 @@ namespace cursedearth
         ogg_int64_t granulepos;
         if (0 == th_decode_packetin(theora->context, &theora->packet, &granulepos)) {
             theora->time = th_granule_time(theora->context, granulepos);
-            ++video_resource->frame_index;
+            video_resource->ycbcr_frame_index = video_resource->frame_index++;
 
             th_decode_ycbcr_out(theora->context, theora->ycbcr);
 
@@ -365,6 +381,7 @@ namespace cursedearth
         AVPacket packet;
         uint8_t extradata[4 + FF_INPUT_BUFFER_PADDING_SIZE];
         uint8_t* data;
+        size_t output_frame_count;
     };
 
     size_t ce_bink_size_hint(ce_mem_file*)
@@ -443,6 +460,10 @@ namespace cursedearth
 
         memcpy(bink->context->extradata, &bink->header.video_flags, 4);
 
+        // frame threading where the codec supports it, slices otherwise; frames come out with a delay then
+        bink->context->thread_count = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned int>(video_options_t::max_decode_thread_count)));
+        bink->context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
         if (avcodec_open2(bink->context, bink->codec, NULL) < 0) {
             ce_logging_error("bink: could not open video codec");
             return false;
@@ -479,15 +500,10 @@ namespace cursedearth
         }
     }
 
-    bool ce_bink_read(ce_video_resource* video_resource)
+    bool ce_bink_read_packet(ce_video_resource* video_resource)
     {
         ce_bink* bink = (ce_bink*)video_resource->impl;
 
-        if (video_resource->frame_index == video_resource->frame_count) {
-            assert(ce_mem_file_eof(video_resource->mem_file));
-            return false;
-        }
-
         uint32_t frame_size = bink->indices[video_resource->frame_index++].length;
 
         if (0 != bink->header.audio_track_count) {
@@ -508,15 +524,49 @@ namespace cursedearth
         }
 
         bink->packet.size = ce_mem_file_read(video_resource->mem_file, bink->packet.data, 1, frame_size);
+        if (static_cast<uint32_t>(bink->packet.size) != frame_size) {
+            ce_logging_error("bink: unexpected end of stream");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ce_bink_read(ce_video_resource* video_resource)
+    {
+        ce_bink* bink = (ce_bink*)video_resource->impl;
 
         int got_frame = 0;
-        int code = avcodec_decode_video2(bink->context, bink->frame, &got_frame, &bink->packet);
+        while (0 == got_frame) {
+            if (video_resource->frame_index == video_resource->frame_count) {
+                assert(ce_mem_file_eof(video_resource->mem_file));
+                if (bink->output_frame_count == video_resource->frame_count) {
+                    return false;
+                }
 
-        if (code < 0 || (uint32_t)code != frame_size || 0 == got_frame) {
-            ce_logging_error("bink: codec error while decoding video");
-            return false;
+                // drain frames still in flight in the decoding threads
+                uint8_t* data = bink->packet.data;
+                bink->packet.data = NULL;
+                bink->packet.size = 0;
+                int code = avcodec_decode_video2(bink->context, bink->frame, &got_frame, &bink->packet);
+                bink->packet.data = data;
+                if (code < 0 || 0 == got_frame) {
+                    return false;
+                }
+            } else {
+                if (!ce_bink_read_packet(video_resource)) {
+                    return false;
+                }
+
+                int code = avcodec_decode_video2(bink->context, bink->frame, &got_frame, &bink->packet);
+                if (code < 0 || code != bink->packet.size) {
+                    ce_logging_error("bink: codec error while decoding video");
+                    return false;
+                }
+            }
         }
 
+        video_resource->ycbcr_frame_index = bink->output_frame_count++;
         for (size_t i = 0; i < 3; ++i) {
             video_resource->ycbcr.planes[i].stride = bink->frame->linesize[i];
             video_resource->ycbcr.planes[i].data = bink->frame->data[i];
@@ -529,6 +579,8 @@ namespace cursedearth
     {
         ce_bink* bink = (ce_bink*)video_resource->impl;
         ce_mem_file_seek(video_resource->mem_file, bink->indices[video_resource->frame_index].pos, CE_MEM_FILE_SEEK_SET);
+        avcodec_flush_buffers(bink->context);
+        bink->output_frame_count = video_resource->frame_index;
         return true;
     }
 
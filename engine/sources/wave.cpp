@@ -20,11 +20,10 @@
 
 #include <cassert>
 #include <cstring>
-#include <limits>
-#include <memory>
 
 #include "utility.hpp"
 #include "logging.hpp"
+#include "soundsamples.hpp"
 #include "wave.hpp"
 
 namespace cursedearth
@@ -52,6 +51,10 @@ namespace cursedearth
     {
         wave_header->format.extra.ima_adpcm.size = ce_mem_file_read_u16le(mem_file);
         wave_header->format.extra.ima_adpcm.samples_per_block = ce_mem_file_read_u16le(mem_file);
+        if (0 == wave_header->format.channel_count || wave_header->format.channel_count > CE_WAVE_IMA_ADPCM_MAX_CHANNEL_COUNT) {
+            ce_logging_error("wave: ima adpcm with %u channels is not supported", wave_header->format.channel_count);
+            return false;
+        }
         assert(2 * (wave_header->format.block_align - 4 * wave_header->format.channel_count) /
             wave_header->format.channel_count + 1 == wave_header->format.extra.ima_adpcm.samples_per_block);
         return true;
@@ -146,14 +149,14 @@ namespace cursedearth
         return ce_wave_header_check(wave_header);
     }
 
-    int ce_wave_ima_adpcm_index_table[16] = {
+    const int ce_wave_ima_adpcm_index_table[16] = {
         -1, -1, -1, -1, /* +0 - +3, decrease the step size */
          2,  4,  6,  8, /* +4 - +7, increase the step size */
         -1, -1, -1, -1,	/* -0 - -3, decrease the step size */
          2,  4,  6,  8,	/* -4 - -7, increase the step size */
     };
 
-    unsigned int ce_wave_ima_adpcm_step_table[89] = {
+    const int ce_wave_ima_adpcm_step_table[89] = {
         7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
         50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
         253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
@@ -162,26 +165,66 @@ namespace cursedearth
         12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
     };
 
+    // magnitude of the difference for every step and 3-bit code, so that
+    // decoding a sample is two table lookups and no branches
+    struct ce_wave_ima_adpcm_diff_table
+    {
+        ce_wave_ima_adpcm_diff_table()
+        {
+            for (size_t i = 0; i < 89; ++i) {
+                const int step = ce_wave_ima_adpcm_step_table[i];
+                for (int code = 0; code < 8; ++code) {
+                    diffs[i][code] = (step >> 3) + (code & 1 ? step >> 2 : 0) + (code & 2 ? step >> 1 : 0) + (code & 4 ? step : 0);
+                }
+            }
+        }
+
+        int diffs[89][8];
+    };
+
+    const ce_wave_ima_adpcm_diff_table ce_wave_ima_adpcm_diffs;
+
     inline int ce_wave_ima_adpcm_clamp_step_index(int index)
     {
         return clamp(index, 0, 88);
     }
 
-    void ce_wave_ima_adpcm_decode(void* dst, const void* src, const ce_wave_header* wave_header)
+    void ce_wave_ima_adpcm_decode_channel(int16_t* samples, size_t stride, const uint8_t* codes, size_t code_count, int current, int step_index)
+    {
+        for (size_t i = 0; i < code_count; ++i) {
+            const int code = codes[i];
+            const int sign = -(code >> 3); // 0 or -1
+            const int diff = ce_wave_ima_adpcm_diffs.diffs[step_index][code & 7];
+            current = clamp(current + ((diff ^ sign) - sign), -32768, 32767);
+            step_index = ce_wave_ima_adpcm_clamp_step_index(step_index + ce_wave_ima_adpcm_index_table[code]);
+            samples[(i + 1) * stride] = current;
+        }
+    }
+
+    void ce_wave_ima_adpcm_decode(void* dst, const void* src, void* codes, const ce_wave_header* wave_header)
     {
         int16_t* samples = static_cast<int16_t*>(dst);
         const uint8_t* block = static_cast<const uint8_t*>(src);
 
-        std::unique_ptr<int[]> step_indices(new int[wave_header->format.channel_count]);
+        const size_t channel_count = wave_header->format.channel_count;
+        const size_t code_count = wave_header->format.extra.ima_adpcm.samples_per_block - 1;
+
+        int currents[CE_WAVE_IMA_ADPCM_MAX_CHANNEL_COUNT];
+        int step_indices[CE_WAVE_IMA_ADPCM_MAX_CHANNEL_COUNT];
+        uint8_t* channel_codes[CE_WAVE_IMA_ADPCM_MAX_CHANNEL_COUNT];
+
+        assert(channel_count <= CE_WAVE_IMA_ADPCM_MAX_CHANNEL_COUNT);
 
         // read and check the block header
-        for (size_t channel = 0; channel < wave_header->format.channel_count; ++channel) {
+        for (size_t channel = 0; channel < channel_count; ++channel) {
             int32_t current = block[channel * 4 + 0] | (block[channel * 4 + 1] << 8);
             if (current & 0x8000) {
                 current -= 0x10000;
             }
 
+            currents[channel] = current;
             step_indices[channel] = ce_wave_ima_adpcm_clamp_step_index(block[channel * 4 + 2]);
+            channel_codes[channel] = static_cast<uint8_t*>(codes) + channel * code_count;
 
             if (0 != block[channel * 4 + 3]) {
                 ce_logging_error("wave: ima adpcm synchronization error");
@@ -190,44 +233,12 @@ namespace cursedearth
             samples[channel] = current;
         }
 
-        // pull apart the packed 4 bit samples and store them in their
-        // correct sample positions
-        size_t block_index = 4 * wave_header->format.channel_count;
-        size_t index_start = wave_header->format.channel_count;
-
-        while (block_index < wave_header->format.block_align) {
-            for (size_t channel = 0; channel < wave_header->format.channel_count; ++channel) {
-                size_t index = index_start + channel;
-                for (size_t k = 0; k < 4; ++k) {
-                    uint8_t byte_code = block[block_index++];
-                    samples[index] = byte_code & 0xf;
-                    index += wave_header->format.channel_count;
-                    samples[index] = (byte_code >> 4) & 0xf;
-                    index += wave_header->format.channel_count;
-                }
-            }
-            index_start += 8 * wave_header->format.channel_count;
-        }
-
-        // decode the encoded 4 bit samples
-        for (size_t k = wave_header->format.channel_count; k < wave_header->format.extra.ima_adpcm.samples_per_block * (size_t)wave_header->format.channel_count; ++k) {
-            size_t channel = (wave_header->format.channel_count > 1) ? (k % 2) : 0;
-
-            uint8_t byte_code = samples[k] & 0xf;
-            unsigned int step = ce_wave_ima_adpcm_step_table[step_indices[channel]];
-            int diff = step >> 3;
-
-            if (byte_code & 1) diff += step >> 2;
-            if (byte_code & 2) diff += step >> 1;
-            if (byte_code & 4) diff += step;
-            if (byte_code & 8) diff = -diff;
-
-            int32_t current = samples[k - wave_header->format.channel_count];
-            current += diff;
-            samples[k] = clamp(current, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
+        // pull apart the packed 4 bit samples: rounds of 4 bytes (8 codes) per channel
+        expand_nibbles(channel_codes, block + 4 * channel_count, channel_count, code_count / 8);
 
-            step_indices[channel] += ce_wave_ima_adpcm_index_table[byte_code];
-            step_indices[channel] = ce_wave_ima_adpcm_clamp_step_index(step_indices[channel]);
+        // decode the encoded 4 bit samples, each channel is an independent chain
+        for (size_t channel = 0; channel < channel_count; ++channel) {
+            ce_wave_ima_adpcm_decode_channel(samples + channel, channel_count, channel_codes[channel], code_count, currents[channel], step_indices[channel]);
         }
     }
 }
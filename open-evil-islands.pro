@@ -29,6 +29,7 @@ HEADERS = \
     engine/headers/alloc.hpp \
     engine/headers/anmfile.hpp \
     engine/headers/anmstate.hpp \
+    engine/headers/anmstore.hpp \
     engine/headers/avcodec.hpp \
     engine/headers/bbox.hpp \
     engine/headers/bink.hpp \
@@ -47,6 +48,7 @@ HEADERS = \
     engine/headers/display_x11.hpp \
     engine/headers/event.hpp \
     engine/headers/exception.hpp \
+    engine/headers/figbake.hpp \
     engine/headers/figbone.hpp \
     engine/headers/figentity.hpp \
     engine/headers/figfile.hpp \
@@ -66,6 +68,7 @@ HEADERS = \
     engine/headers/graphicscontext_windows.hpp \
     engine/headers/graphicscontext_x11.hpp \
     engine/headers/input.hpp \
+    engine/headers/keytable.hpp \
     engine/headers/lnkfile.hpp \
     engine/headers/logging.hpp \
     engine/headers/makeunique.hpp \
@@ -74,6 +77,7 @@ HEADERS = \
     engine/headers/matrix4.hpp \
     engine/headers/memfile.hpp \
     engine/headers/mmpfile.hpp \
+    engine/headers/mobcache.hpp \
     engine/headers/mobfile.hpp \
     engine/headers/mobloader.hpp \
     engine/headers/mobmanager.hpp \
@@ -101,6 +105,7 @@ HEADERS = \
     engine/headers/renderwindow.hpp \
     engine/headers/resball.hpp \
     engine/headers/resfile.hpp \
+    engine/headers/resindex.hpp \
     engine/headers/resourcemanager.hpp \
     engine/headers/ringbuffer.hpp \
     engine/headers/root.hpp \
@@ -114,16 +119,23 @@ HEADERS = \
     engine/headers/soundblock.hpp \
     engine/headers/soundbuffer.hpp \
     engine/headers/soundcapabilities.hpp \
+    engine/headers/soundconverter.hpp \
     engine/headers/sounddevice.hpp \
+    engine/headers/soundemitter.hpp \
     engine/headers/soundformat.hpp \
     engine/headers/soundinstance.hpp \
     engine/headers/soundmanager.hpp \
     engine/headers/soundmixer.hpp \
     engine/headers/soundobject.hpp \
     engine/headers/soundoptions.hpp \
+    engine/headers/soundresampler.hpp \
     engine/headers/soundresource.hpp \
+    engine/headers/soundsamples.hpp \
+    engine/headers/soundscheduler.hpp \
     engine/headers/soundsystem.hpp \
+    engine/headers/soundvoice.hpp \
     engine/headers/sphere.hpp \
+    engine/headers/startup.hpp \
     engine/headers/string.hpp \
     engine/headers/systemevent.hpp \
     engine/headers/systeminfo.hpp \
@@ -145,6 +157,7 @@ HEADERS = \
     engine/headers/vector3.hpp \
     engine/headers/vector4.hpp \
     engine/headers/videobuffer.hpp \
+    engine/headers/videoframe.hpp \
     engine/headers/videoinstance.hpp \
     engine/headers/videomanager.hpp \
     engine/headers/videoobject.hpp \
@@ -162,6 +175,7 @@ SOURCES = \
     engine/sources/alloc.cpp \
     engine/sources/anmfile.cpp \
     engine/sources/anmstate.cpp \
+    engine/sources/anmstore.cpp \
     engine/sources/avcodec.cpp \
     engine/sources/bbox.cpp \
     engine/sources/bink.cpp \
@@ -179,6 +193,7 @@ SOURCES = \
     engine/sources/display_windows.cpp \
     engine/sources/display_x11.cpp \
     engine/sources/event.cpp \
+    engine/sources/figbake.cpp \
     engine/sources/figbone.cpp \
     engine/sources/figentity.cpp \
     engine/sources/figfile.cpp \
@@ -198,6 +213,7 @@ SOURCES = \
     engine/sources/graphicscontext_windows.cpp \
     engine/sources/graphicscontext_x11.cpp \
     engine/sources/input.cpp \
+    engine/sources/keytable.cpp \
     engine/sources/lnkfile.cpp \
     engine/sources/logging.cpp \
     engine/sources/material.cpp \
@@ -205,6 +221,7 @@ SOURCES = \
     engine/sources/matrix4.cpp \
     engine/sources/memfile.cpp \
     engine/sources/mmpfile.cpp \
+    engine/sources/mobcache.cpp \
     engine/sources/mobfile.cpp \
     engine/sources/mobloader.cpp \
     engine/sources/mobmanager.cpp \
@@ -234,6 +251,7 @@ SOURCES = \
     engine/sources/renderwindow_x11.cpp \
     engine/sources/resball.cpp \
     engine/sources/resfile.cpp \
+    engine/sources/resindex.cpp \
     engine/sources/resourcemanager.cpp \
     engine/sources/root.cpp \
     engine/sources/scenemanager.cpp \
@@ -243,18 +261,25 @@ SOURCES = \
     engine/sources/shadermanager.cpp \
     engine/sources/soundblock.cpp \
     engine/sources/soundbuffer.cpp \
+    engine/sources/soundconverter.cpp \
     engine/sources/sounddevice.cpp \
     engine/sources/sounddevice_generic.cpp \
     engine/sources/sounddevice_linux.cpp \
     engine/sources/sounddevice_windows.cpp \
+    engine/sources/soundemitter.cpp \
     engine/sources/soundinstance.cpp \
     engine/sources/soundmanager.cpp \
     engine/sources/soundmixer.cpp \
     engine/sources/soundobject.cpp \
+    engine/sources/soundresampler.cpp \
     engine/sources/soundresource.cpp \
     engine/sources/soundresource_generic.cpp \
+    engine/sources/soundsamples.cpp \
+    engine/sources/soundscheduler.cpp \
     engine/sources/soundsystem.cpp \
+    engine/sources/soundvoice.cpp \
     engine/sources/sphere.cpp \
+    engine/sources/startup.cpp \
     engine/sources/string.cpp \
     engine/sources/systemevent.cpp \
     engine/sources/systeminfo_generic.cpp \
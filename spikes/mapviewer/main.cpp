@@ -21,6 +21,8 @@
 #include "alloc.hpp"
 #include "utility.hpp"
 #include "logging.hpp"
+#include "figuremanager.hpp"
+#include "soundobject.hpp"
 #include "root.hpp"
 
 namespace cursedearth
@@ -34,11 +36,16 @@ namespace cursedearth
             m_anmfps_inc_event(m_input_supply->repeat(m_input_supply->push(input_button_t::kb_add))),
             m_anmfps_dec_event(m_input_supply->repeat(m_input_supply->push(input_button_t::kb_subtract)))
         {
-            const char* zone;
+            const char *zone, *entity_sound;
             bool only_mpr;
 
             ce_optparse_get(option_parser, "zone", &zone);
             ce_optparse_get(option_parser, "only_mpr", &only_mpr);
+            ce_optparse_get(option_parser, "entity_sound", &entity_sound);
+
+            if (NULL != entity_sound) {
+                m_entity_sound.assign(entity_sound);
+            }
 
             load_mpr(zone);
             if (!only_mpr) {
@@ -68,6 +75,20 @@ namespace cursedearth
         {
             m_input_supply->advance(elapsed);
 
+            // objects are loaded in the background, give the sound to the ones that have come in
+            if (!m_entity_sound.empty()) {
+                for (size_t i = 0; i < ce_figure_manager->entities->count; ++i) {
+                    ce_figentity* figentity = static_cast<ce_figentity*>(ce_figure_manager->entities->items[i]);
+                    if (0 == figentity->sound_object) {
+                        const sound_object_t sound_object = make_sound_object(m_entity_sound);
+                        if (0 != sound_object) {
+                            ce_figentity_attach_sound(figentity, sound_object, 0);
+                            play_sound_object(sound_object);
+                        }
+                    }
+                }
+            }
+
             float animation_fps = root_t::instance()->animation_fps;
 
             if (m_anmfps_inc_event->triggered()) animation_fps += 1.0f;
@@ -98,6 +119,7 @@ namespace cursedearth
         }
 
     private:
+        std::string m_entity_sound;
         float m_text_timeout = 0.0f;
         color_t m_text_color = CE_COLOR_CORNFLOWER;
         input_supply_ptr_t m_input_supply;
@@ -125,6 +147,7 @@ int main(int argc, char* argv[])
             "Cursed Earth: Map Viewer", "This program is part of Cursed Earth spikes.\nMap Viewer - explore Evil Islands zones.");
 
         ce_optparse_add(option_parser, "only_mpr", CE_TYPE_BOOL, NULL, false, NULL, "only-mpr", "without objects (do not load mob)");
+        ce_optparse_add(option_parser, "entity_sound", CE_TYPE_STRING, NULL, false, NULL, "entity-sound", "every object plays this sound where it stands");
         ce_optparse_add(option_parser, "zone", CE_TYPE_STRING, NULL, true, NULL, NULL, "any ZONE.mpr file in `EI/Maps'");
         ce_optparse_add_control(option_parser, "+/-", "change animation FPS");
 